@@ -327,7 +327,13 @@ void Core2ForAWS_Display_Init(void) {
 
     xSemaphoreGive(xGuiSemaphore);
 
+#ifdef CONFIG_TASK_GUI_CORE
+    // Placement from the application's task plan
+    xTaskCreatePinnedToCore(guiTask, "gui", CONFIG_TASK_GUI_STACK, NULL, CONFIG_TASK_GUI_PRIORITY, NULL,
+                            CONFIG_TASK_GUI_CORE < 0 ? tskNO_AFFINITY : CONFIG_TASK_GUI_CORE);
+#else
     xTaskCreatePinnedToCore(guiTask, "gui", 4096*2, NULL, 2, NULL, 1);
+#endif
 }
 
 void Core2ForAWS_Display_SetBrightness(uint8_t brightness) {
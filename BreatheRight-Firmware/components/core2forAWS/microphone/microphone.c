@@ -8,9 +8,13 @@
 #define I2S_DATA_IN_PIN 34
 
 void Microphone_Init() {
+    Microphone_Init_Config(44100, 2, 128, 0, NULL);
+}
+
+void Microphone_Init_Config(uint32_t sample_rate, int dma_buf_count, int dma_buf_len, int queue_size, QueueHandle_t* i2s_queue) {
     i2s_config_t i2s_config = {
         .mode = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_RX | I2S_MODE_PDM),
-        .sample_rate = 44100,
+        .sample_rate = sample_rate,
         .bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT,
         .channel_format = I2S_CHANNEL_FMT_ALL_RIGHT,
 #if ESP_IDF_VERSION > ESP_IDF_VERSION_VAL(4, 1, 0)
@@ -19,8 +23,8 @@ void Microphone_Init() {
 		.communication_format = I2S_COMM_FORMAT_I2S,
 #endif
         .intr_alloc_flags = ESP_INTR_FLAG_LEVEL1,
-        .dma_buf_count = 2,
-        .dma_buf_len = 128,
+        .dma_buf_count = dma_buf_count,
+        .dma_buf_len = dma_buf_len,
     };
 
     i2s_pin_config_t pin_config;
@@ -29,9 +33,9 @@ void Microphone_Init() {
     pin_config.data_out_num = I2S_PIN_NO_CHANGE;
     pin_config.data_in_num = I2S_DATA_IN_PIN;
     
-    i2s_driver_install(MIC_I2S_NUMBER, &i2s_config, 0, NULL);
+    i2s_driver_install(MIC_I2S_NUMBER, &i2s_config, queue_size, i2s_queue);
     i2s_set_pin(MIC_I2S_NUMBER, &pin_config);
-    i2s_set_clk(MIC_I2S_NUMBER, 44100, I2S_BITS_PER_SAMPLE_16BIT, I2S_CHANNEL_MONO);
+    i2s_set_clk(MIC_I2S_NUMBER, sample_rate, I2S_BITS_PER_SAMPLE_16BIT, I2S_CHANNEL_MONO);
 }
 
 void Microphone_Deinit() {
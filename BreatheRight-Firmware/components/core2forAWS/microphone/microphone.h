@@ -4,6 +4,9 @@
  */
 
 #pragma once
+#include "stdint.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
 
 /**
  * @brief Microphone I2S port number. 
@@ -24,6 +27,25 @@
 void Microphone_Init();
 /* @[declare_microphone_init] */
 
+/**
+ * @brief Initializes the microphone over I2S with a caller sized
+ * DMA descriptor ring and an optional driver event queue.
+ * 
+ * @ref Microphone_Init() is equivalent to 
+ * `Microphone_Init_Config(44100, 2, 128, 0, NULL)`.
+ * 
+ * @note The same GPIO0 restriction as @ref Microphone_Init() applies.
+ * 
+ * @param[in] sample_rate PCM output sample rate in Hz.
+ * @param[in] dma_buf_count Number of DMA descriptors in the ring (2-128).
+ * @param[in] dma_buf_len Length of each DMA buffer in samples (8-1024).
+ * @param[in] queue_size Depth of the I2S event queue, 0 for none.
+ * @param[out] i2s_queue Receives the I2S event queue handle, NULL for none.
+ */
+/* @[declare_microphone_init_config] */
+void Microphone_Init_Config(uint32_t sample_rate, int dma_buf_count, int dma_buf_len, int queue_size, QueueHandle_t* i2s_queue);
+/* @[declare_microphone_init_config] */
+
 /**
  * @brief De-initializes the microphone over I2S. 
  */
@@ -0,0 +1,199 @@
+/*
+ * Host capture replay
+ * BreatheRight v1.0
+ * capture_replay.c
+ *
+ * Copyright (C) 2020 Upbeat Labs LLC or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Plays a WAV file through audio_capture.c and the WAV-fed I2S stand-in and
+ * checks that the ring hands out exactly the decimated audio the capture
+ * task read, and that every DMA buffer lost in a burst is counted.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "audio_capture.h"
+#include "audio_decimator.h"
+#include "i2s_host.h"
+#include "wav.h"
+#include "esp_log.h"
+
+static const char *TAG = "CAPTURE-REPLAY";
+
+#ifdef CONFIG_AUDIO_DC_BLOCK
+#define DC_BLOCK 1
+#else
+#define DC_BLOCK 0
+#endif
+
+// Read size of the consumer, a prime so reads straddle the ring end and the DMA buffers
+#define READ_SAMPLES 1021
+
+static uint32_t burst_buffers;
+
+/**
+ * Room in the ring for the next post, so a consumer the host keeps waiting
+ * does not overflow it. The capture task wants one sample more than a buffer free.
+ */
+static bool ring_has_room(void)
+{
+    return audio_capture_available() + (burst_buffers + 2) * CONFIG_AUDIO_DMA_BUF_LEN <= CONFIG_AUDIO_RING_SAMPLES;
+}
+
+/** The capture task has handled every buffer i2s_read returned, and there are no more */
+static bool capture_drained(void)
+{
+    I2S_HOST_STATS i2s;
+    AUDIO_CAPTURE_STATS capture;
+    i2s_host_get_stats(&i2s);
+    audio_capture_get_stats(&capture);
+    return i2s.done && i2s.read_buffers + i2s.dropped_buffers == i2s.buffers &&
+        capture.dma_buffers + capture.ring_overflows == i2s.read_buffers;
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [-b after,buffers] file.wav\n"
+        "  -b after,buffers  after `after` DMA buffers, post `buffers` at once while the\n"
+        "                    capture task is held off (%u are held, %u events queued)\n"
+        "The file must be 16 bit PCM at %u Hz.\n",
+        name, CONFIG_AUDIO_DMA_BUF_COUNT - 1, 2 * CONFIG_AUDIO_DMA_BUF_COUNT, CONFIG_AUDIO_I2S_SAMPLE_RATE);
+}
+
+int main(int argc, char **argv)
+{
+    unsigned burst_after = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "b:")) != -1) {
+        switch (opt) {
+        case 'b':
+            if (sscanf(optarg, "%u,%u", &burst_after, &burst_buffers) != 2) {
+                usage(argv[0]);
+                return 2;
+            }
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (optind != argc - 1) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    const char *path = argv[optind];
+    size_t count = 0;
+    uint32_t sample_rate = 0;
+    int16_t *samples = wav_read(path, &count, &sample_rate);
+    if (samples == NULL) {
+        return 1;
+    }
+    if (sample_rate != CONFIG_AUDIO_I2S_SAMPLE_RATE) {
+        ESP_LOGE(TAG, "%s: %u Hz, the capture is built for %u Hz", path, sample_rate, CONFIG_AUDIO_I2S_SAMPLE_RATE);
+        return 1;
+    }
+
+    i2s_host_set_source(samples, count);
+    i2s_host_set_burst(burst_after, burst_buffers);
+    i2s_host_set_ready(ring_has_room);
+    if (!audio_capture_start()) {
+        return 1;
+    }
+
+    // Consume like microphoneTask, until the capture task has nothing left
+    size_t captured_len = 0;
+    int16_t *captured = (int16_t *)malloc((count / CONFIG_AUDIO_DECIMATION + 1) * sizeof(int16_t));
+    for (;;) {
+        size_t n = audio_capture_read(&captured[captured_len], READ_SAMPLES, pdMS_TO_TICKS(100));
+        if (n == 0 && capture_drained()) {
+            n = audio_capture_read(&captured[captured_len], audio_capture_available(), 0);
+            captured_len += n;
+            break;
+        }
+        captured_len += n;
+    }
+
+    // What the capture task should have made of the buffers it got
+    const size_t buffers = count / CONFIG_AUDIO_DMA_BUF_LEN;
+    AUDIO_DECIMATOR decimator;
+    audio_decimator_init(&decimator, CONFIG_AUDIO_DECIMATION, CONFIG_AUDIO_GAIN_Q8, DC_BLOCK);
+    size_t expected_len = 0;
+    int16_t *expected = (int16_t *)malloc((count / CONFIG_AUDIO_DECIMATION + 1) * sizeof(int16_t));
+    for (uint32_t ix = 0; ix < buffers; ix++) {
+        if (i2s_host_buffer_read(ix)) {
+            expected_len += audio_decimator_process(&decimator, &samples[ix * CONFIG_AUDIO_DMA_BUF_LEN],
+                CONFIG_AUDIO_DMA_BUF_LEN, &expected[expected_len]);
+        }
+    }
+
+    I2S_HOST_STATS i2s;
+    AUDIO_CAPTURE_STATS stats;
+    i2s_host_get_stats(&i2s);
+    audio_capture_get_stats(&stats);
+
+    printf("%s: %u DMA buffers, %u read, %u overwritten in the driver, %u events dropped\n",
+        path, i2s.buffers, i2s.read_buffers, i2s.dropped_buffers, i2s.dropped_events);
+    printf("Capture: %u buffers, %u samples, %u gaps (%u DMA errors, %u DMA overflows, %u ring overflows, "
+        "%u short reads), %u samples dropped, max fill %u\n",
+        stats.dma_buffers, stats.samples, audio_capture_gaps(&stats), stats.dma_errors, stats.dma_overflows,
+        stats.ring_overflows, stats.short_reads, stats.dropped_samples, stats.max_fill);
+    if (stats.input_samples > 0) {
+        printf("Decimator: %.1f cycles per input sample\n", (double)stats.dsp_cycles / stats.input_samples);
+    }
+
+    int errors = 0;
+    if (stats.ring_overflows > 0) {
+        ESP_LOGE(TAG, "the consumer fell behind, %u ring overflows", stats.ring_overflows);
+        errors++;
+    }
+    if (stats.dma_overflows != i2s.dropped_buffers) {
+        // Events dropped from a full queue cannot be counted, only those below it
+        ESP_LOGW(TAG, "%u DMA overflows counted, %u buffers overwritten", stats.dma_overflows, i2s.dropped_buffers);
+        errors += i2s.dropped_events == 0;
+    }
+    if (stats.short_reads > 0 || stats.dma_errors > 0) {
+        ESP_LOGE(TAG, "%u short reads, %u DMA errors", stats.short_reads, stats.dma_errors);
+        errors++;
+    }
+    if (captured_len != expected_len || memcmp(captured, expected, expected_len * sizeof(int16_t)) != 0) {
+        size_t ix = 0;
+        while (ix < captured_len && ix < expected_len && captured[ix] == expected[ix]) {
+            ix++;
+        }
+        ESP_LOGE(TAG, "%zu samples captured, %zu expected, first difference at %zu", captured_len, expected_len, ix);
+        errors++;
+    }
+    else {
+        printf("Ring output identical to the decimated input (%zu samples)\n", captured_len);
+    }
+
+    free(expected);
+    free(captured);
+    free(samples);
+    return errors > 0 ? 1 : 0;
+}
@@ -0,0 +1,148 @@
+/*
+ * Host decimator benchmark
+ * BreatheRight v1.0
+ * decimator_bench.c
+ *
+ * Copyright (C) 2020 Upbeat Labs LLC or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Cycles per input sample of audio_decimator_process, the pass the capture
+ * task runs on every DMA buffer, for each factor and for the DC blocker on
+ * and off. Buffers are the DMA buffer length so the per-call overhead is
+ * counted like on the device.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "xtensa/hal.h"
+#include "audio_decimator.h"
+#include "wav.h"
+
+#define DMA_BUF_SAMPLES 256
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/** Best of `runs` passes over the input, like the capture task feeds it */
+static void bench(const int16_t *in, size_t count, int factor, int dc_block, int runs)
+{
+    static int16_t out[DMA_BUF_SAMPLES + 1];
+    const size_t buffers = count / DMA_BUF_SAMPLES;
+    uint32_t best_cycles = UINT32_MAX;
+    uint64_t best_ns = UINT64_MAX;
+    int32_t checksum = 0;
+
+    for (int run = 0; run < runs; run++) {
+        AUDIO_DECIMATOR d;
+        audio_decimator_init(&d, factor, AUDIO_DECIMATOR_UNITY_GAIN, dc_block);
+
+        uint64_t start_ns = now_ns();
+        uint32_t start = xthal_get_ccount();
+        for (size_t ix = 0; ix < buffers; ix++) {
+            size_t n = audio_decimator_process(&d, &in[ix * DMA_BUF_SAMPLES], DMA_BUF_SAMPLES, out);
+            checksum += out[n - 1];
+        }
+        uint32_t cycles = xthal_get_ccount() - start;
+        uint64_t ns = now_ns() - start_ns;
+        if (cycles < best_cycles) {
+            best_cycles = cycles;
+        }
+        if (ns < best_ns) {
+            best_ns = ns;
+        }
+    }
+
+    const size_t samples = buffers * DMA_BUF_SAMPLES;
+    printf("factor %d  dc %-3s  %7.2f cycles/sample  %6.2f ns/sample  (checksum %d)\n", factor,
+        dc_block ? "on" : "off", (double)best_cycles / samples, (double)best_ns / samples, checksum);
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [-n runs] [file.wav]\n"
+        "  -n runs  passes over the input, the best one is printed (default 20)\n"
+        "Without a file, 10 s of noise is used. Cycles are TSC ticks on x86.\n", name);
+}
+
+int main(int argc, char **argv)
+{
+    int runs = 20;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        switch (opt) {
+        case 'n':
+            runs = atoi(optarg);
+            if (runs < 1) {
+                usage(argv[0]);
+                return 2;
+            }
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (optind < argc - 1) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    size_t count;
+    int16_t *in;
+    if (optind < argc) {
+        uint32_t sample_rate;
+        in = wav_read(argv[optind], &count, &sample_rate);
+        if (in == NULL) {
+            return 1;
+        }
+    }
+    else {
+        count = 10 * 48000;
+        in = (int16_t *)malloc(count * sizeof(int16_t));
+        uint32_t seed = 1;
+        for (size_t ix = 0; ix < count; ix++) {
+            seed = seed * 1664525u + 1013904223u;
+            in[ix] = (int16_t)(seed >> 16) / 4;
+        }
+    }
+    if (count < DMA_BUF_SAMPLES) {
+        fprintf(stderr, "need at least %d samples\n", DMA_BUF_SAMPLES);
+        return 1;
+    }
+
+    printf("%zu samples in %d sample buffers, best of %d runs\n", count / DMA_BUF_SAMPLES * DMA_BUF_SAMPLES,
+        DMA_BUF_SAMPLES, runs);
+    bench(in, count, 3, 1, runs);
+    bench(in, count, 3, 0, runs);
+    bench(in, count, 1, 1, runs);
+    bench(in, count, 1, 0, runs);
+
+    free(in);
+    return 0;
+}
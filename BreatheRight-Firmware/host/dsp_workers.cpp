@@ -0,0 +1,164 @@
+/*
+ * Host DSP worker
+ * BreatheRight v1.0
+ * dsp_workers.cpp
+ * 
+ * Copyright (C) 2020 Upbeat Labs LLC or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The second worker of ei_dsp_parallel_for as a thread, same protocol as
+ * dspWorkerTask in main/dsp_workers.cpp, so replay -w 2 splits the MFCC
+ * frames the way the Core2 does.
+ */
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "edge-impulse-sdk/porting/ei_classifier_porting.h"
+#include "dsp_workers.h"
+#include "esp_log.h"
+
+#define DSP_WORKERS 2
+
+enum {
+    JOB_IDLE = 0,
+    JOB_POSTED,
+    JOB_RUNNING
+};
+
+/** The loop ei_dsp_parallel_for is running */
+typedef struct DSP_JOB {
+    ei_dsp_work_fn fn;
+    void *ctx;
+    size_t count;
+    std::atomic<size_t> next;
+    std::atomic<int> result;
+} DSP_JOB;
+
+// Never destroyed: the worker is still waiting on them at exit, and destroying
+// a condition variable with a waiter blocks
+static std::mutex *job_mutex;
+static std::condition_variable *job_posted;
+static std::condition_variable *job_done;
+static int job_state = JOB_IDLE;    // under job_mutex
+static DSP_JOB job;
+static bool worker_started;
+static int workers_limit = DSP_WORKERS;
+
+static uint32_t items_taken[DSP_WORKERS];
+static uint32_t loops;
+
+static void run_items(int worker)
+{
+    size_t ix;
+    while ((ix = job.next.fetch_add(1)) < job.count) {
+        int ret = job.fn(job.ctx, ix, ix + 1, worker);
+        items_taken[worker]++;
+        if (ret != 0) {
+            int expected = 0;
+            job.result.compare_exchange_strong(expected, ret);
+            job.next.store(job.count);
+        }
+    }
+}
+
+static void dsp_worker_thread(void)
+{
+    std::unique_lock<std::mutex> lock(*job_mutex);
+    for (;;) {
+        job_posted->wait(lock, [] { return job_state == JOB_POSTED; });
+        job_state = JOB_RUNNING;
+        lock.unlock();
+        run_items(1);
+        lock.lock();
+        job_state = JOB_IDLE;
+        job_done->notify_one();
+    }
+}
+
+int ei_dsp_parallel_for(size_t count, ei_dsp_work_fn fn, void *ctx)
+{
+    if (!worker_started || workers_limit < 2 || count < 2) {
+        return fn(ctx, 0, count, 0);
+    }
+
+    job.fn = fn;
+    job.ctx = ctx;
+    job.count = count;
+    job.next.store(0);
+    job.result.store(0);
+    {
+        std::lock_guard<std::mutex> lock(*job_mutex);
+        job_state = JOB_POSTED;
+    }
+    job_posted->notify_one();
+    loops++;
+
+    run_items(0);
+
+    std::unique_lock<std::mutex> lock(*job_mutex);
+    if (job_state == JOB_POSTED) {
+        // the worker never joined, take the loop back
+        job_state = JOB_IDLE;
+    }
+    else {
+        job_done->wait(lock, [] { return job_state == JOB_IDLE; });
+    }
+    return job.result.load();
+}
+
+int ei_dsp_workers(void)
+{
+    return worker_started && workers_limit >= 2 ? DSP_WORKERS : 1;
+}
+
+int ei_set_dsp_workers(int n)
+{
+    int previous = workers_limit;
+    workers_limit = n < 1 ? 1 : n > DSP_WORKERS ? DSP_WORKERS : n;
+    return previous;
+}
+
+bool dsp_workers_start(void)
+{
+    if (!worker_started) {
+        job_mutex = new std::mutex;
+        job_posted = new std::condition_variable;
+        job_done = new std::condition_variable;
+        // blocked in job_posted->wait at exit, nothing to join
+        std::thread(dsp_worker_thread).detach();
+        worker_started = true;
+    }
+    return true;
+}
+
+void dsp_workers_log(const char *tag)
+{
+    uint32_t worker_items = items_taken[1];
+    uint32_t total = items_taken[0] + worker_items;
+    ESP_LOGI(tag, "DSP workers: %u parallel loops, %u items, %.1f%% on the worker thread", loops, total,
+        total ? 100.0f * worker_items / total : 0.0f);
+    items_taken[0] = 0;
+    items_taken[1] = 0;
+    loops = 0;
+}
@@ -0,0 +1,292 @@
+/*
+ * FreeRTOS on the host
+ * BreatheRight v1.0
+ * freertos_host.c
+ *
+ * Copyright (C) 2020 Upbeat Labs LLC or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The FreeRTOS calls of the capture modules on pthreads: enough for
+ * audio_capture.c and its consumer to run unchanged, not a scheduler.
+ */
+
+#include <errno.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos_host.h"
+#include "task_plan.h"
+
+struct HOST_TASK {
+    pthread_t thread;
+    TaskFunction_t fn;
+    void *arg;
+    pthread_mutex_t mutex;
+    pthread_cond_t notified;
+    uint32_t notifications;     // under mutex
+};
+
+struct HOST_QUEUE {
+    pthread_mutex_t mutex;
+    pthread_cond_t changed;
+    uint8_t *items;
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t head;           // next item to receive
+    UBaseType_t count;
+};
+
+static __thread TaskHandle_t current_task;
+static struct HOST_TASK main_task = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .notified = PTHREAD_COND_INITIALIZER,
+};
+
+/** Absolute CLOCK_REALTIME deadline ticks from now, for pthread_cond_timedwait */
+static struct timespec deadline(TickType_t ticks)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += ticks / 1000;
+    ts.tv_nsec += (long)(ticks % 1000) * 1000000;
+    if (ts.tv_nsec >= 1000000000) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000;
+    }
+    return ts;
+}
+
+/**
+ * Wait on cond until the caller's condition holds. Returns false on timeout,
+ * 0 ticks only checks, portMAX_DELAY waits forever.
+ */
+static bool wait_for(pthread_cond_t *cond, pthread_mutex_t *mutex, const struct timespec *until, TickType_t ticks)
+{
+    if (ticks == 0) {
+        return false;
+    }
+    if (ticks == portMAX_DELAY) {
+        pthread_cond_wait(cond, mutex);
+        return true;
+    }
+    return pthread_cond_timedwait(cond, mutex, until) != ETIMEDOUT;
+}
+
+static void *task_entry(void *arg)
+{
+    TaskHandle_t task = (TaskHandle_t)arg;
+    current_task = task;
+    task->fn(task->arg);
+    return NULL;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack, void *arg,
+    UBaseType_t priority, TaskHandle_t *handle, BaseType_t core)
+{
+    (void)name;
+    (void)stack;
+    (void)priority;
+    (void)core;
+
+    TaskHandle_t task = (TaskHandle_t)calloc(1, sizeof(*task));
+    if (task == NULL) {
+        return pdFAIL;
+    }
+    task->fn = fn;
+    task->arg = arg;
+    pthread_mutex_init(&task->mutex, NULL);
+    pthread_cond_init(&task->notified, NULL);
+    if (handle != NULL) {
+        *handle = task;
+    }
+    if (pthread_create(&task->thread, NULL, task_entry, task) != 0) {
+        free(task);
+        return pdFAIL;
+    }
+    pthread_detach(task->thread);
+    return pdPASS;
+}
+
+BaseType_t task_plan_create(TASK_ID id, TaskFunction_t fn, void *arg, TaskHandle_t *handle)
+{
+    (void)id;
+    return xTaskCreatePinnedToCore(fn, NULL, 0, arg, 0, handle, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    // Only ever called by a task on itself, at the end of its loop
+    (void)task;
+    pthread_exit(NULL);
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    struct timespec ts = { (time_t)(ticks / 1000), (long)(ticks % 1000) * 1000000 };
+    nanosleep(&ts, NULL);
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (TickType_t)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return current_task != NULL ? current_task : &main_task;
+}
+
+void xTaskNotifyGive(TaskHandle_t task)
+{
+    pthread_mutex_lock(&task->mutex);
+    task->notifications++;
+    pthread_cond_signal(&task->notified);
+    pthread_mutex_unlock(&task->mutex);
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks_to_wait)
+{
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    struct timespec until = deadline(ticks_to_wait);
+
+    pthread_mutex_lock(&task->mutex);
+    while (task->notifications == 0 && wait_for(&task->notified, &task->mutex, &until, ticks_to_wait)) {
+    }
+    uint32_t value = task->notifications;
+    if (value > 0) {
+        task->notifications = clear ? 0 : value - 1;
+    }
+    pthread_mutex_unlock(&task->mutex);
+    return value;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    QueueHandle_t queue = (QueueHandle_t)calloc(1, sizeof(*queue));
+    if (queue == NULL) {
+        return NULL;
+    }
+    queue->items = (uint8_t *)malloc(length * item_size);
+    if (queue->items == NULL) {
+        free(queue);
+        return NULL;
+    }
+    queue->length = length;
+    queue->item_size = item_size;
+    pthread_mutex_init(&queue->mutex, NULL);
+    pthread_cond_init(&queue->changed, NULL);
+    return queue;
+}
+
+void vQueueDelete(QueueHandle_t queue)
+{
+    pthread_mutex_destroy(&queue->mutex);
+    pthread_cond_destroy(&queue->changed);
+    free(queue->items);
+    free(queue);
+}
+
+static void append(QueueHandle_t queue, const void *item)
+{
+    UBaseType_t tail = (queue->head + queue->count) % queue->length;
+    memcpy(&queue->items[tail * queue->item_size], item, queue->item_size);
+    queue->count++;
+    pthread_cond_broadcast(&queue->changed);
+}
+
+static void remove_head(QueueHandle_t queue, void *item)
+{
+    if (item != NULL) {
+        memcpy(item, &queue->items[queue->head * queue->item_size], queue->item_size);
+    }
+    queue->head = (queue->head + 1) % queue->length;
+    queue->count--;
+    pthread_cond_broadcast(&queue->changed);
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks_to_wait)
+{
+    struct timespec until = deadline(ticks_to_wait);
+    BaseType_t sent = pdFALSE;
+
+    pthread_mutex_lock(&queue->mutex);
+    while (queue->count == queue->length && wait_for(&queue->changed, &queue->mutex, &until, ticks_to_wait)) {
+    }
+    if (queue->count < queue->length) {
+        append(queue, item);
+        sent = pdTRUE;
+    }
+    pthread_mutex_unlock(&queue->mutex);
+    return sent;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks_to_wait)
+{
+    struct timespec until = deadline(ticks_to_wait);
+    BaseType_t received = pdFALSE;
+
+    pthread_mutex_lock(&queue->mutex);
+    while (queue->count == 0 && wait_for(&queue->changed, &queue->mutex, &until, ticks_to_wait)) {
+    }
+    if (queue->count > 0) {
+        remove_head(queue, item);
+        received = pdTRUE;
+    }
+    pthread_mutex_unlock(&queue->mutex);
+    return received;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue)
+{
+    pthread_mutex_lock(&queue->mutex);
+    UBaseType_t count = queue->count;
+    pthread_mutex_unlock(&queue->mutex);
+    return count;
+}
+
+void host_queue_lock(QueueHandle_t queue)
+{
+    pthread_mutex_lock(&queue->mutex);
+}
+
+void host_queue_unlock(QueueHandle_t queue)
+{
+    pthread_mutex_unlock(&queue->mutex);
+}
+
+BaseType_t host_queue_overwrite_locked(QueueHandle_t queue, const void *item)
+{
+    BaseType_t kept = pdTRUE;
+    if (queue->count == queue->length) {
+        remove_head(queue, NULL);
+        kept = pdFALSE;
+    }
+    append(queue, item);
+    return kept;
+}
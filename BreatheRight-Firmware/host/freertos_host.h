@@ -0,0 +1,54 @@
+/*
+ * FreeRTOS on the host
+ * BreatheRight v1.0
+ * freertos_host.h
+ *
+ * Copyright (C) 2020 Upbeat Labs LLC or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * What an interrupt handler can do to a queue that a task cannot: the I2S
+ * stand-in takes the queue lock to post a burst of events the receiving
+ * task only sees once it is complete, like a run of DMA interrupts while
+ * the capture task is held off.
+ */
+void host_queue_lock(QueueHandle_t queue);
+void host_queue_unlock(QueueHandle_t queue);
+
+/**
+ * Append an item with the queue locked. When the queue is full the oldest
+ * item is dropped first, like the I2S driver does with its event queue.
+ * Returns pdFALSE when an item was dropped.
+ */
+BaseType_t host_queue_overwrite_locked(QueueHandle_t queue, const void *item);
+
+#ifdef __cplusplus
+}
+#endif
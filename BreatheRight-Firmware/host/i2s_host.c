@@ -0,0 +1,184 @@
+/*
+ * WAV-fed I2S driver on the host
+ * BreatheRight v1.0
+ * i2s_host.c
+ *
+ * Copyright (C) 2020 Upbeat Labs LLC or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "driver/i2s.h"
+#include "freertos_host.h"
+#include "i2s_host.h"
+#include "microphone.h"
+
+static const int16_t *source;
+static size_t source_buffers;
+static uint32_t burst_after;
+static uint32_t burst_buffers;
+static I2S_HOST_READY ready_fn;
+
+static int dma_buf_count;
+static size_t dma_buf_samples;
+static QueueHandle_t event_queue;
+
+// Ring of the filled DMA buffers, by source buffer index, under mutex
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t changed = PTHREAD_COND_INITIALIZER;
+static uint32_t *filled;
+static int filled_head;
+static int filled_count;
+static uint8_t *buffer_read;
+static I2S_HOST_STATS stats;
+
+void i2s_host_set_source(const int16_t *samples, size_t count)
+{
+    source = samples;
+    source_buffers = count;     // in samples until the buffer length is known
+}
+
+void i2s_host_set_burst(uint32_t after, uint32_t buffers)
+{
+    burst_after = after;
+    burst_buffers = buffers;
+}
+
+void i2s_host_set_ready(I2S_HOST_READY ready)
+{
+    ready_fn = ready;
+}
+
+bool i2s_host_buffer_read(uint32_t ix)
+{
+    pthread_mutex_lock(&mutex);
+    bool read = ix < source_buffers && buffer_read[ix];
+    pthread_mutex_unlock(&mutex);
+    return read;
+}
+
+void i2s_host_get_stats(I2S_HOST_STATS *out)
+{
+    pthread_mutex_lock(&mutex);
+    *out = stats;
+    pthread_mutex_unlock(&mutex);
+}
+
+/** One DMA buffer completes, under mutex and with the event queue locked */
+static void post_buffer(uint32_t ix)
+{
+    const int held = dma_buf_count - 1;
+    if (filled_count == held) {
+        filled_head = (filled_head + 1) % held;
+        filled_count--;
+        stats.dropped_buffers++;
+    }
+    filled[(filled_head + filled_count) % held] = ix;
+    filled_count++;
+    stats.buffers++;
+
+    i2s_event_t event = { I2S_EVENT_RX_DONE, dma_buf_samples * sizeof(int16_t) };
+    if (host_queue_overwrite_locked(event_queue, &event) != pdTRUE) {
+        stats.dropped_events++;
+    }
+}
+
+static void *dma_thread(void *arg)
+{
+    (void)arg;
+    uint32_t ix = 0;
+    while (ix < source_buffers) {
+        // Wait until the capture task has read everything, then post one buffer, or a
+        // whole burst: it only sees the events once the queue is unlocked again
+        uint32_t count = ix == burst_after && burst_buffers > 0 ? burst_buffers : 1;
+        if (count > source_buffers - ix) {
+            count = source_buffers - ix;
+        }
+
+        pthread_mutex_lock(&mutex);
+        while (filled_count > 0 || uxQueueMessagesWaiting(event_queue) > 0) {
+            pthread_cond_wait(&changed, &mutex);
+        }
+        pthread_mutex_unlock(&mutex);
+        while (ready_fn != NULL && !ready_fn()) {
+            usleep(100);
+        }
+
+        pthread_mutex_lock(&mutex);
+        host_queue_lock(event_queue);
+        for (uint32_t n = 0; n < count; n++) {
+            post_buffer(ix++);
+        }
+        host_queue_unlock(event_queue);
+        pthread_mutex_unlock(&mutex);
+    }
+
+    pthread_mutex_lock(&mutex);
+    stats.done = true;
+    pthread_mutex_unlock(&mutex);
+    return NULL;
+}
+
+void Microphone_Init_Config(uint32_t sample_rate, int dma_buf_count_, int dma_buf_len, int queue_size, QueueHandle_t* i2s_queue)
+{
+    (void)sample_rate;
+    dma_buf_count = dma_buf_count_;
+    dma_buf_samples = dma_buf_len;
+    source_buffers /= dma_buf_samples;
+    filled = (uint32_t *)calloc(dma_buf_count - 1, sizeof(uint32_t));
+    buffer_read = (uint8_t *)calloc(source_buffers + 1, 1);
+    event_queue = xQueueCreate(queue_size, sizeof(i2s_event_t));
+    *i2s_queue = event_queue;
+
+    pthread_t thread;
+    pthread_create(&thread, NULL, dma_thread, NULL);
+    pthread_detach(thread);
+}
+
+esp_err_t i2s_read(i2s_port_t port, void *dest, size_t size, size_t *bytes_read, TickType_t ticks_to_wait)
+{
+    (void)port;
+    (void)ticks_to_wait;    // the capture task only reads buffers it got an event for
+    *bytes_read = 0;
+
+    pthread_mutex_lock(&mutex);
+    if (filled_count > 0) {
+        uint32_t ix = filled[filled_head];
+        filled_head = (filled_head + 1) % (dma_buf_count - 1);
+        filled_count--;
+
+        size_t bytes = dma_buf_samples * sizeof(int16_t);
+        if (bytes > size) {
+            bytes = size;
+        }
+        memcpy(dest, &source[ix * dma_buf_samples], bytes);
+        *bytes_read = bytes;
+        buffer_read[ix] = 1;
+        stats.read_buffers++;
+    }
+    pthread_cond_broadcast(&changed);
+    pthread_mutex_unlock(&mutex);
+    return ESP_OK;
+}
@@ -0,0 +1,79 @@
+/*
+ * WAV-fed I2S driver on the host
+ * BreatheRight v1.0
+ * i2s_host.h
+ *
+ * Copyright (C) 2020 Upbeat Labs LLC or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * Stand-in for the receive side of the ESP-IDF I2S driver, for
+ * audio_capture.c on the host. Microphone_Init_Config starts a thread that
+ * plays the source in DMA buffers: each one goes into a ring of
+ * dma_buf_count - 1 filled buffers and posts I2S_EVENT_RX_DONE, and both
+ * drop their oldest entry when full, like the driver does. Normally the
+ * thread waits for the capture task to keep up, so nothing is lost; a burst
+ * posts a run of buffers while the capture task is held off.
+ */
+
+/** What the stand-in did with the source */
+typedef struct I2S_HOST_STATS {
+    uint32_t buffers;           // DMA buffers posted
+    uint32_t read_buffers;      // returned by i2s_read
+    uint32_t dropped_buffers;   // overwritten in the ring before i2s_read
+    uint32_t dropped_events;    // RX_DONE events dropped from a full event queue
+    bool done;                  // whole source posted
+} I2S_HOST_STATS;
+
+/** Audio to play at the I2S rate. Only whole DMA buffers of it are played. */
+void i2s_host_set_source(const int16_t *samples, size_t count);
+
+/** After `after` buffers, post the next `buffers` at once. 0 buffers for none. */
+void i2s_host_set_burst(uint32_t after, uint32_t buffers);
+
+/**
+ * Hold the next buffer back until ready() returns true, so a consumer the
+ * host scheduler delays does not overflow the capture ring. NULL for none.
+ */
+typedef bool (*I2S_HOST_READY)(void);
+void i2s_host_set_ready(I2S_HOST_READY ready);
+
+/**
+ * Whether buffer `ix` of the source was returned by i2s_read, so a test
+ * can build the audio the capture task saw. Valid once the buffer is past.
+ */
+bool i2s_host_buffer_read(uint32_t ix);
+
+void i2s_host_get_stats(I2S_HOST_STATS *stats);
+
+#ifdef __cplusplus
+}
+#endif
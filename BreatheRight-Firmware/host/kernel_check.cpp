@@ -0,0 +1,265 @@
+/*
+ * Host int8 kernel check
+ * BreatheRight v1.0
+ * kernel_check.cpp
+ *
+ * Copyright (C) 2020 Upbeat Labs LLC or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Randomized comparison of the optimized int8 Conv2D and FullyConnected
+ * kernels (CLASSIFIER_XTENSA_KERNELS, tensorflow/lite/kernels/internal/
+ * optimized/integer_ops) with the reference kernels they replace. Shapes,
+ * strides, padding, zero points, multipliers and activation ranges are
+ * drawn at random; every output must be identical.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <vector>
+
+#include "edge-impulse-sdk/tensorflow/lite/kernels/internal/quantization_util.h"
+#include "edge-impulse-sdk/tensorflow/lite/kernels/internal/reference/integer_ops/conv.h"
+#include "edge-impulse-sdk/tensorflow/lite/kernels/internal/reference/integer_ops/fully_connected.h"
+#include "edge-impulse-sdk/tensorflow/lite/kernels/internal/optimized/integer_ops/conv.h"
+#include "edge-impulse-sdk/tensorflow/lite/kernels/internal/optimized/integer_ops/fully_connected.h"
+
+using namespace tflite;
+
+static uint32_t rng_state = 1;
+
+/** Uniform in [lo, hi] */
+static int rng(int lo, int hi)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return lo + (int)(rng_state % (uint32_t)(hi - lo + 1));
+}
+
+static void fill_int8(std::vector<int8_t> &v)
+{
+    for (size_t ix = 0; ix < v.size(); ix++) {
+        v[ix] = (int8_t)rng(-128, 127);
+    }
+}
+
+/** A multiplier and shift like the converter derives from the tensor scales */
+static void random_multiplier(int32_t *multiplier, int *shift)
+{
+    const double scale = rng(1, 1000000) * 1e-8 * (1 << rng(0, 12));
+    QuantizeMultiplier(scale, multiplier, shift);
+}
+
+/** Activation range, full int8 or a fused ReLU / ReLU6 like clamp */
+static void random_activation(int32_t *min, int32_t *max)
+{
+    *min = rng(0, 2) == 0 ? rng(-128, 0) : -128;
+    *max = rng(0, 2) == 0 ? rng(*min, 127) : 127;
+}
+
+static size_t mismatches(const std::vector<int8_t> &a, const std::vector<int8_t> &b)
+{
+    size_t count = 0;
+    for (size_t ix = 0; ix < a.size(); ix++) {
+        count += a[ix] != b[ix];
+    }
+    return count;
+}
+
+/** One random Conv2D, returns the outputs compared or -1 on a mismatch */
+static long check_conv(int round)
+{
+    const int batches = rng(1, 2);
+    const int input_height = rng(1, 12);
+    const int input_width = rng(1, 12);
+    const int input_depth = rng(1, 12);
+    const int output_depth = rng(1, 12);
+    const int filter_height = rng(1, 5);
+    const int filter_width = rng(1, 5);
+
+    ConvParams params = {};
+    params.stride_height = rng(1, 3);
+    params.stride_width = rng(1, 3);
+    // VALID, SAME, or more padding than either
+    params.padding_values.height = rng(0, filter_height);
+    params.padding_values.width = rng(0, filter_width);
+    params.dilation_height_factor = 1;
+    params.dilation_width_factor = 1;
+    params.input_offset = rng(-127, 128);
+    params.output_offset = rng(-128, 127);
+    random_activation(&params.quantized_activation_min, &params.quantized_activation_max);
+
+    const int output_height = (input_height + 2 * params.padding_values.height - filter_height) /
+        params.stride_height + 1;
+    const int output_width = (input_width + 2 * params.padding_values.width - filter_width) /
+        params.stride_width + 1;
+    if (output_height < 1 || output_width < 1) {
+        // filter larger than the padded input
+        return 0;
+    }
+
+    const RuntimeShape input_shape({ batches, input_height, input_width, input_depth });
+    const RuntimeShape filter_shape({ output_depth, filter_height, filter_width, input_depth });
+    const RuntimeShape bias_shape({ output_depth });
+    const RuntimeShape output_shape({ batches, output_height, output_width, output_depth });
+
+    std::vector<int8_t> input(input_shape.FlatSize());
+    std::vector<int8_t> filter(filter_shape.FlatSize());
+    fill_int8(input);
+    fill_int8(filter);
+    std::vector<int32_t> bias(output_depth);
+    std::vector<int32_t> multiplier(output_depth);
+    std::vector<int32_t> shift(output_depth);
+    for (int ch = 0; ch < output_depth; ch++) {
+        bias[ch] = rng(-20000, 20000);
+        int s;
+        random_multiplier(&multiplier[ch], &s);
+        shift[ch] = s;
+    }
+    const int32_t *bias_data = rng(0, 4) == 0 ? nullptr : bias.data();
+
+    std::vector<int32_t> filter_sums(output_depth);
+    optimized_integer_ops::RowSums(filter.data(), output_depth, filter_height * filter_width * input_depth,
+        filter_sums.data());
+    // Without the sums every pixel takes the border path
+    const int32_t *sums = rng(0, 4) == 0 ? nullptr : filter_sums.data();
+
+    std::vector<int8_t> reference(output_shape.FlatSize());
+    std::vector<int8_t> optimized(output_shape.FlatSize());
+    reference_integer_ops::ConvPerChannel(params, multiplier.data(), shift.data(), input_shape, input.data(),
+        filter_shape, filter.data(), bias_shape, bias_data, output_shape, reference.data());
+    optimized_integer_ops::ConvPerChannel(params, multiplier.data(), shift.data(), sums, input_shape,
+        input.data(), filter_shape, filter.data(), bias_shape, bias_data, output_shape, optimized.data());
+
+    const size_t bad = mismatches(reference, optimized);
+    if (bad) {
+        fprintf(stderr, "conv %d: %zu of %zu outputs differ (%dx%dx%dx%d, filter %dx%d -> %d, stride %d,%d, "
+            "pad %d,%d, sums %s, bias %s)\n", round, bad, reference.size(), batches, input_height, input_width,
+            input_depth, filter_height, filter_width, output_depth, params.stride_height, params.stride_width,
+            params.padding_values.height, params.padding_values.width, sums ? "yes" : "no",
+            bias_data ? "yes" : "no");
+        return -1;
+    }
+    return (long)reference.size();
+}
+
+/** One random FullyConnected, returns the outputs compared or -1 on a mismatch */
+static long check_fully_connected(int round)
+{
+    const int batches = rng(1, 3);
+    const int accum_depth = rng(1, 300);
+    const int output_depth = rng(1, 20);
+
+    FullyConnectedParams params = {};
+    params.input_offset = rng(-127, 128);
+    // Symmetric weights have no zero point, test both
+    params.weights_offset = rng(0, 1) ? 0 : rng(-127, 128);
+    params.output_offset = rng(-128, 127);
+    random_multiplier(&params.output_multiplier, &params.output_shift);
+    random_activation(&params.quantized_activation_min, &params.quantized_activation_max);
+
+    const RuntimeShape input_shape({ batches, accum_depth });
+    const RuntimeShape filter_shape({ output_depth, accum_depth });
+    const RuntimeShape bias_shape({ output_depth });
+    const RuntimeShape output_shape({ batches, output_depth });
+
+    std::vector<int8_t> input(input_shape.FlatSize());
+    std::vector<int8_t> filter(filter_shape.FlatSize());
+    fill_int8(input);
+    fill_int8(filter);
+    std::vector<int32_t> bias(output_depth);
+    for (int ch = 0; ch < output_depth; ch++) {
+        bias[ch] = rng(-20000, 20000);
+    }
+    const int32_t *bias_data = rng(0, 4) == 0 ? nullptr : bias.data();
+
+    std::vector<int32_t> filter_sums(output_depth);
+    optimized_integer_ops::RowSums(filter.data(), output_depth, accum_depth, filter_sums.data());
+
+    std::vector<int8_t> reference(output_shape.FlatSize());
+    std::vector<int8_t> optimized(output_shape.FlatSize());
+    reference_integer_ops::FullyConnected(params, input_shape, input.data(), filter_shape, filter.data(),
+        bias_shape, bias_data, output_shape, reference.data());
+    optimized_integer_ops::FullyConnected(params, filter_sums.data(), input_shape, input.data(), filter_shape,
+        filter.data(), bias_shape, bias_data, output_shape, optimized.data());
+
+    const size_t bad = mismatches(reference, optimized);
+    if (bad) {
+        fprintf(stderr, "fully connected %d: %zu of %zu outputs differ (%d x %d -> %d, weights offset %d, "
+            "bias %s)\n", round, bad, reference.size(), batches, accum_depth, output_depth,
+            (int)params.weights_offset, bias_data ? "yes" : "no");
+        return -1;
+    }
+    return (long)reference.size();
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [-n rounds] [-s seed]\n"
+        "  -n rounds  random layers of each kind (default 2000)\n"
+        "  -s seed    of the shapes and data (default 1)\n", name);
+}
+
+int main(int argc, char **argv)
+{
+    int rounds = 2000;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:s:")) != -1) {
+        switch (opt) {
+        case 'n':
+            rounds = atoi(optarg);
+            break;
+        case 's':
+            rng_state = (uint32_t)strtoul(optarg, NULL, 0);
+            if (rng_state == 0) {
+                rng_state = 1;
+            }
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    uint64_t conv_outputs = 0, fc_outputs = 0;
+    int failed = 0;
+    for (int round = 0; round < rounds; round++) {
+        long n = check_conv(round);
+        if (n < 0) {
+            failed++;
+        }
+        else {
+            conv_outputs += n;
+        }
+        n = check_fully_connected(round);
+        if (n < 0) {
+            failed++;
+        }
+        else {
+            fc_outputs += n;
+        }
+    }
+
+    printf("%d conv and %d fully connected layers, %llu and %llu outputs, %d mismatching\n", rounds, rounds,
+        (unsigned long long)conv_outputs, (unsigned long long)fc_outputs, failed);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,51 @@
+/*
+ * Host MFCC benchmarks
+ * BreatheRight v1.0
+ * mfcc_bench.cpp
+ *
+ * Copyright (C) 2020 Upbeat Labs LLC or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The MFCC benchmarks AUDIO_MFCC_BENCHMARK runs at startup on the device,
+ * from main/includes/classifier_bench.h: a model window with the float and
+ * the int16 signal, the generic against the compile time MFCC, and with
+ * AUDIO_MFCC_DUAL_CORE one against two DSP workers.
+ */
+
+#include <Cough_Tutorial_inferencing.h>
+#include "slice_classifier.h"
+#include "classifier_bench.h"
+#include "dsp_workers.h"
+
+static const char *TAG = "MFCC_BENCH";
+
+int main(void)
+{
+    classifier_bench_mfcc_window(TAG);
+#if EI_DSP_MFCC_STATIC
+    classifier_bench_mfcc_static(TAG);
+#endif
+#if EIDSP_MFCC_PARALLEL
+    dsp_workers_start();
+    classifier_bench_mfcc_workers(TAG);
+#endif
+    return 0;
+}
@@ -0,0 +1,263 @@
+/*
+ * Host fixed point MFCC check
+ * BreatheRight v1.0
+ * mfcc_compare.cpp
+ *
+ * Copyright (C) 2020 Upbeat Labs LLC or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Runs the fixed point MFCC (speechpy::feature_fixed, EIDSP_MFCC_FIXED_POINT)
+ * and the float int16 MFCC it replaces (speechpy::feature::mfcc_i16) over the
+ * model windows of WAV recordings, with the DSP config of the impulse, and
+ * fails when the features or the int8 model input they normalize to differ
+ * by more than the tolerances. With -f it runs the int16 MFCC against the
+ * float signal path it replaced (AUDIO_I16_SIGNAL_PATH=n: int16_to_float,
+ * the preemphasis class and speechpy::feature::mfcc, as extract_mfcc_features
+ * runs them).
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+
+#include <Cough_Tutorial_inferencing.h>
+#include "wav.h"
+
+/** Differences over all windows compared */
+typedef struct COMPARE_STATS {
+    uint32_t windows;
+    uint64_t features;
+    double sum_diff;
+    float max_diff;
+    float max_feature;          // largest |feature| of the float MFCC, for scale
+    uint64_t inputs_differing;  // int8 input values that are not equal
+    int max_steps;              // largest int8 input difference
+} COMPARE_STATS;
+
+/** The MFCCs compared */
+typedef enum {
+    PATH_F32 = 0,   // float signal, extract_mfcc_features
+    PATH_I16,       // int16 signal, feature::mfcc_i16
+    PATH_FIXED      // int16 signal, feature_fixed::mfcc
+} MFCC_PATH;
+
+static const char *path_names[] = { "float signal", "int16", "fixed point" };
+
+static const int16_t *window_samples;
+static class speechpy::processing::preemphasis *window_preemphasis;
+
+static int window_get_data(size_t offset, size_t length, int16_t *out_ptr)
+{
+    memcpy(out_ptr, &window_samples[offset], length * sizeof(int16_t));
+    return 0;
+}
+
+static int window_get_float(size_t offset, size_t length, float *out_ptr)
+{
+    return numpy::int16_to_float(&window_samples[offset], out_ptr, length);
+}
+
+static int window_get_preemphasized(size_t offset, size_t length, float *out_ptr)
+{
+    return window_preemphasis->get_data(offset, length, out_ptr);
+}
+
+/**
+ * @brief      Features of `length` samples with one of the MFCCs
+ */
+static int window_mfcc(const ei_dsp_config_mfcc_t *config, const int16_t *samples, size_t length, MFCC_PATH path,
+                       matrix_t *out)
+{
+    window_samples = samples;
+
+    if (path == PATH_F32) {
+        signal_t signal;
+        signal.total_length = length;
+        signal.get_data = &window_get_float;
+        class speechpy::processing::preemphasis pre(&signal, config->pre_shift, config->pre_cof, false);
+        window_preemphasis = &pre;
+
+        signal_t preemphasized;
+        preemphasized.total_length = length;
+        preemphasized.get_data = &window_get_preemphasized;
+        return speechpy::feature::mfcc(out, &preemphasized, EI_CLASSIFIER_FREQUENCY, config->frame_length,
+            config->frame_stride, config->num_cepstral, config->num_filters, config->fft_length,
+            config->low_frequency, config->high_frequency, true, config->implementation_version);
+    }
+
+    signal_i16_t signal;
+    signal.total_length = length;
+    signal.get_data = &window_get_data;
+
+    // Like the first slice of continuous mode: no sample before the window
+    if (path == PATH_FIXED) {
+        return speechpy::feature_fixed::mfcc(out, &signal, 0, length, 0, config->pre_cof, EI_CLASSIFIER_FREQUENCY,
+            config->frame_length, config->frame_stride, config->num_cepstral, config->num_filters,
+            config->fft_length, config->low_frequency, config->high_frequency, true, config->implementation_version);
+    }
+    return speechpy::feature::mfcc_i16(out, &signal, 0, length, 0, config->pre_cof, EI_CLASSIFIER_FREQUENCY,
+        config->frame_length, config->frame_stride, config->num_cepstral, config->num_filters,
+        config->fft_length, config->low_frequency, config->high_frequency, true, config->implementation_version);
+}
+
+/**
+ * @brief      Compare two MFCCs over every model window of a recording,
+ *             one slice apart like the continuous classifier sees them
+ */
+static bool compare_file(const char *path, MFCC_PATH reference_path, MFCC_PATH candidate_path,
+                         bool skip_first_frame, COMPARE_STATS *stats)
+{
+    size_t count;
+    uint32_t sample_rate;
+    int16_t *samples = wav_read(path, &count, &sample_rate);
+    if (samples == NULL) {
+        return false;
+    }
+    if (sample_rate != EI_CLASSIFIER_FREQUENCY) {
+        fprintf(stderr, "%s: %u Hz, the model takes %d Hz\n", path, sample_rate, EI_CLASSIFIER_FREQUENCY);
+        free(samples);
+        return false;
+    }
+
+    const ei_dsp_config_mfcc_t *config = (const ei_dsp_config_mfcc_t *)ei_dsp_blocks[0].config;
+    const size_t window = count < EI_CLASSIFIER_RAW_SAMPLE_COUNT ? count : EI_CLASSIFIER_RAW_SAMPLE_COUNT;
+    const size_t hop = EI_CLASSIFIER_SLICE_SIZE;
+    const matrix_size_t size = speechpy::feature::calculate_mfcc_buffer_size(window, EI_CLASSIFIER_FREQUENCY,
+        config->frame_length, config->frame_stride, config->num_cepstral, config->implementation_version);
+    const size_t values = size.rows * size.cols;
+    const size_t first = skip_first_frame ? size.cols : 0;
+
+    matrix_t reference(size.rows, size.cols);
+    matrix_t candidate(size.rows, size.cols);
+    std::vector<int8_t> reference_input(values);
+    std::vector<int8_t> candidate_input(values);
+
+    bool ok = true;
+    for (size_t start = 0; start + window <= count && ok; start += hop) {
+        int ret = window_mfcc(config, &samples[start], window, reference_path, &reference);
+        if (ret == EIDSP_OK) {
+            ret = window_mfcc(config, &samples[start], window, candidate_path, &candidate);
+        }
+        if (ret != EIDSP_OK) {
+            fprintf(stderr, "%s: MFCC failed (%d)\n", path, ret);
+            ok = false;
+            break;
+        }
+
+        stats->windows++;
+        for (size_t ix = first; ix < values; ix++) {
+            const float diff = fabsf(candidate.buffer[ix] - reference.buffer[ix]);
+            stats->sum_diff += diff;
+            if (diff > stats->max_diff) {
+                stats->max_diff = diff;
+            }
+            if (fabsf(reference.buffer[ix]) > stats->max_feature) {
+                stats->max_feature = fabsf(reference.buffer[ix]);
+            }
+        }
+        stats->features += values - first;
+
+        // The normalization the classifier quantizes into its input tensor
+        if (speechpy::processing::cmvnw_sliding_i8(&reference, reference_input.data(),
+                EI_CLASSIFIER_TFLITE_INPUT_SCALE, EI_CLASSIFIER_TFLITE_INPUT_ZEROPOINT, config->win_size,
+                true) != EIDSP_OK ||
+            speechpy::processing::cmvnw_sliding_i8(&candidate, candidate_input.data(),
+                EI_CLASSIFIER_TFLITE_INPUT_SCALE, EI_CLASSIFIER_TFLITE_INPUT_ZEROPOINT, config->win_size,
+                true) != EIDSP_OK) {
+            fprintf(stderr, "%s: CMVN failed\n", path);
+            ok = false;
+            break;
+        }
+        for (size_t ix = first; ix < values; ix++) {
+            const int steps = abs(candidate_input[ix] - reference_input[ix]);
+            stats->inputs_differing += steps != 0;
+            if (steps > stats->max_steps) {
+                stats->max_steps = steps;
+            }
+        }
+    }
+
+    free(samples);
+    return ok;
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [-f] [-t max_diff] [-s max_steps] file.wav...\n"
+        "  -f            int16 MFCC against the float signal path, instead of fixed point against int16\n"
+        "  -t max_diff   largest feature difference allowed (default 2e-3)\n"
+        "  -s max_steps  largest int8 model input difference allowed (default 1)\n", name);
+}
+
+int main(int argc, char **argv)
+{
+    float max_diff = 2e-3f;
+    int max_steps = 1;
+    MFCC_PATH reference_path = PATH_I16;
+    MFCC_PATH candidate_path = PATH_FIXED;
+    int opt;
+    while ((opt = getopt(argc, argv, "ft:s:")) != -1) {
+        switch (opt) {
+        case 'f':
+            reference_path = PATH_F32;
+            candidate_path = PATH_I16;
+            break;
+        case 't':
+            max_diff = strtof(optarg, NULL);
+            break;
+        case 's':
+            max_steps = atoi(optarg);
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (optind >= argc) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    COMPARE_STATS stats = {};
+    for (int ix = optind; ix < argc; ix++) {
+        if (!compare_file(argv[ix], reference_path, candidate_path, reference_path == PATH_F32, &stats)) {
+            return 1;
+        }
+    }
+
+    printf("%u windows, %llu features (up to %.2f)\n", (unsigned)stats.windows,
+        (unsigned long long)stats.features, stats.max_feature);
+    printf("%s vs %s: max diff %.2e, mean diff %.2e\n", path_names[candidate_path], path_names[reference_path],
+        stats.max_diff,
+        stats.features ? stats.sum_diff / stats.features : 0.0);
+    printf("int8 model input: %llu of %llu values differ, by up to %d steps\n",
+        (unsigned long long)stats.inputs_differing, (unsigned long long)stats.features, stats.max_steps);
+
+    if (stats.max_diff > max_diff || stats.max_steps > max_steps) {
+        fprintf(stderr, "%s MFCC out of tolerance (max diff %.2e, %d steps)\n", path_names[candidate_path],
+            max_diff, max_steps);
+        return 1;
+    }
+    return 0;
+}
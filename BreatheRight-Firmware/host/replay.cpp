@@ -0,0 +1,427 @@
+/*
+ * Host WAV replay harness
+ * BreatheRight v1.0
+ * replay.cpp
+ *
+ * Copyright (C) 2020 Upbeat Labs LLC or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+
+#include <Cough_Tutorial_inferencing.h>
+#include "slice_classifier.h"
+#include "dsp_workers.h"
+#include "esp_log.h"
+#include "wav.h"
+
+static const char *TAG = "REPLAY";
+
+/** Totals over all replayed files */
+typedef struct REPLAY_STATS {
+    uint64_t samples;           // audio replayed
+    uint32_t slices;
+    uint32_t gated;             // skipped by the energy gate
+    uint32_t failed;            // run_classifier_continuous errors
+    uint32_t events[EVENT_KIND_COUNT];
+    uint64_t busy_us;           // time spent classifying
+    uint64_t stage_us[EI_STAGE_COUNT];
+} REPLAY_STATS;
+
+static const char *event_names[EVENT_KIND_COUNT] = { "cough", "sneeze" };
+
+/**
+ * What of the model input a window shares with the one before it. The MFCC
+ * rows of the overlap are only shifted, the question is whether the int8
+ * input the network sees is too, which caching conv activations would need
+ */
+typedef struct REUSE_STATS {
+    uint32_t windows;           // compared with the window before
+    uint32_t shift_rows;        // of the last compared window
+    uint64_t features;          // MFCC values in the overlap
+    uint64_t features_same;
+    uint64_t inputs;            // int8 input values in the overlap
+    uint64_t inputs_same;
+    uint64_t rows;              // input rows in the overlap
+    uint64_t rows_same;
+} REUSE_STATS;
+
+static bool verbose = false;
+static bool gate_enabled = true;
+static bool reuse_report = false;
+static REUSE_STATS reuse;
+static std::vector<float> reuse_features;   // window before, empty after a reset
+static std::vector<int8_t> reuse_inputs;
+
+/** A WAV file read by main */
+typedef struct REPLAY_FILE {
+    const char *path;
+    std::vector<int16_t> samples;
+} REPLAY_FILE;
+
+/**
+ * @brief      Compare the model window just classified with the one before
+ *             it: find the rows the window moved by, then count what survived
+ *             the shift in the MFCC features and in the int8 input
+ */
+static void reuse_update(void)
+{
+    if (ei_dsp_blocks[0].extract_fn != extract_mfcc_features) {
+        return;
+    }
+    const ei_dsp_config_mfcc_t *config = (const ei_dsp_config_mfcc_t *)ei_dsp_blocks[0].config;
+    const size_t cols = config->num_cepstral;
+    const size_t rows = EI_CLASSIFIER_NN_INPUT_FRAME_SIZE / cols;
+
+    ei::matrix_t *features = continuous_features_matrix();
+    if (features->buffer == NULL) {
+        return;
+    }
+    // The normalization run_inference_fused_mfcc quantizes into the input tensor
+    std::vector<int8_t> inputs(rows * cols);
+    ei::matrix_t frames(rows, cols, features->buffer);
+    if (speechpy::processing::cmvnw_sliding_i8(&frames, inputs.data(), EI_CLASSIFIER_TFLITE_INPUT_SCALE,
+            EI_CLASSIFIER_TFLITE_INPUT_ZEROPOINT, config->win_size, true) != EIDSP_OK) {
+        return;
+    }
+
+    if (!reuse_features.empty()) {
+        // Smallest shift that lines the old rows up with the new ones
+        size_t shift = 0;
+        for (size_t s = 1; s < rows && shift == 0; s++) {
+            if (memcmp(&reuse_features[s * cols], features->buffer, (rows - s) * cols * sizeof(float)) == 0) {
+                shift = s;
+            }
+        }
+        if (shift > 0) {
+            const size_t overlap = rows - shift;
+            reuse.windows++;
+            reuse.shift_rows = shift;
+            reuse.features += overlap * cols;
+            reuse.inputs += overlap * cols;
+            reuse.rows += overlap;
+            for (size_t row = 0; row < overlap; row++) {
+                size_t same = 0;
+                for (size_t col = 0; col < cols; col++) {
+                    const size_t ix = row * cols + col;
+                    reuse.features_same += reuse_features[ix + shift * cols] == features->buffer[ix];
+                    same += reuse_inputs[ix + shift * cols] == inputs[ix];
+                }
+                reuse.inputs_same += same;
+                reuse.rows_same += same == cols;
+            }
+        }
+    }
+    reuse_features.assign(features->buffer, features->buffer + rows * cols);
+    reuse_inputs.swap(inputs);
+}
+
+/**
+ * @brief      Feed one recording to the classifier slice by slice, the way
+ *             inferenceTask does, and print the events it detects
+ *
+ * @param[in]  report  Print the events, false for the repeat runs of a benchmark
+ */
+static void replay(const char *path, const std::vector<int16_t> &samples, bool report, REPLAY_STATS *stats)
+{
+    ENERGY_GATE gate;
+    EVENT_SEGMENTER segmenter;
+#ifdef CONFIG_AUDIO_VAD_ENABLE
+    slice_classifier_init_gate(&gate);
+#endif
+    slice_classifier_init_segmenter(&segmenter);
+    slice_classifier_reset();
+    reuse_features.clear();
+
+    const uint32_t slice_size = slice_classifier_slice_size(slice_classifier_slices());
+    const uint32_t slice_count = samples.size() / slice_size;
+    // One slice past the end counts as silence and closes the events still open
+    for (uint32_t seq = 0; seq <= slice_count; seq++) {
+        SEGMENT_EVENT closed[EVENT_KIND_COUNT];
+        size_t n;
+
+        if (seq == slice_count) {
+            n = event_segmenter_update(&segmenter, seq, NULL, closed, EVENT_KIND_COUNT);
+        }
+        else {
+            const int16_t *slice = &samples[seq * slice_size];
+            bool active = true;
+#ifdef CONFIG_AUDIO_VAD_ENABLE
+            active = energy_gate_update(&gate, slice, slice_size, NULL) || !gate_enabled;
+#endif
+            stats->slices++;
+
+            if (!active) {
+                stats->gated++;
+                slice_classifier_skip();
+                n = event_segmenter_update(&segmenter, seq, NULL, closed, EVENT_KIND_COUNT);
+            }
+            else {
+                ei_impulse_result_t result = {};
+                uint64_t start = ei_read_timer_us();
+                EI_IMPULSE_ERROR r = slice_classifier_run(slice, &result, false);
+                stats->busy_us += ei_read_timer_us() - start;
+                slice_classifier_record_stages();
+
+                ei_stage_times_t times;
+                ei_get_stage_times(&times);
+                for (int ix = 0; ix < EI_STAGE_COUNT; ix++) {
+                    stats->stage_us[ix] += times.us[ix];
+                }
+
+                if (r != EI_IMPULSE_OK) {
+                    ESP_LOGE(TAG, "%s: slice %u: run_classifier_continuous failed (%d)", path, seq, r);
+                    stats->failed++;
+                    n = event_segmenter_update(&segmenter, seq, NULL, closed, EVENT_KIND_COUNT);
+                }
+                else {
+                    float scores[EI_CLASSIFIER_LABEL_COUNT];
+                    for (size_t ix = 0; ix < EI_CLASSIFIER_LABEL_COUNT; ix++) {
+                        scores[ix] = result.classification[ix].value;
+                    }
+                    // No labels until the first model window is full
+                    if (verbose && report && result.classification[0].label != NULL) {
+                        printf("%s: %7.2f s", path, (float)seq * slice_size / EI_CLASSIFIER_FREQUENCY);
+                        for (size_t ix = 0; ix < EI_CLASSIFIER_LABEL_COUNT; ix++) {
+                            printf("  %s %.5f", result.classification[ix].label, scores[ix]);
+                        }
+                        printf("\n");
+                    }
+                    if (reuse_report && result.classification[0].label != NULL) {
+                        reuse_update();
+                    }
+                    n = event_segmenter_update(&segmenter, seq, scores, closed, EVENT_KIND_COUNT);
+                }
+            }
+        }
+
+        for (size_t ix = 0; ix < n; ix++) {
+            stats->events[closed[ix].kind]++;
+            if (report) {
+                printf("%s: %s at %.2f s, %u ms, peak %.2f\n", path, event_names[closed[ix].kind],
+                    closed[ix].start_sample / (float)EI_CLASSIFIER_FREQUENCY,
+                    closed[ix].duration * 1000 / EI_CLASSIFIER_FREQUENCY, closed[ix].peak / 255.0f);
+            }
+        }
+    }
+    stats->samples += samples.size();
+}
+
+static void print_summary(const REPLAY_STATS *stats)
+{
+    static const char *stage_names[EI_STAGE_COUNT] = {
+        "preemphasis", "framing", "fft", "filterbank", "dct", "cmvn", "invoke", "postprocess"
+    };
+
+    const float audio_s = (float)stats->samples / EI_CLASSIFIER_FREQUENCY;
+    const uint32_t classified = stats->slices - stats->gated;
+    printf("\n%u slices (%.1f s of audio), %u gated, %u failed, %u coughs, %u sneezes\n",
+        stats->slices, audio_s, stats->gated, stats->failed, stats->events[EVENT_COUGH], stats->events[EVENT_SNEEZE]);
+    if (classified == 0 || stats->busy_us == 0) {
+        return;
+    }
+    printf("Classified %u slices in %.1f ms: %.1f slices/s, %.0f us per slice, %.1fx real time\n",
+        classified, stats->busy_us / 1000.0f, classified * 1e6f / stats->busy_us,
+        (float)stats->busy_us / classified, audio_s * 1e6f / stats->busy_us);
+    printf("%u slices per window, %u ms hop: %.2f%% CPU\n", slice_classifier_slices(),
+        slice_classifier_slice_size(slice_classifier_slices()) * 1000 / EI_CLASSIFIER_FREQUENCY,
+        100.0f * stats->busy_us / (audio_s * 1e6f));
+
+#if EIDSP_PROFILE_STAGES
+    printf("Mean time per classified slice:\n");
+    for (int ix = 0; ix < EI_STAGE_COUNT; ix++) {
+        printf("    %-12s %8.1f us %5.1f%%\n", stage_names[ix], (float)stats->stage_us[ix] / classified,
+            100.0f * stats->stage_us[ix] / stats->busy_us);
+    }
+    inference_profiler_log();
+#else
+    (void)stage_names;
+#endif
+
+#if CONFIG_CLASSIFIER_MULTI_MODEL
+    slice_classifier_log_models(TAG);
+#endif
+}
+
+static void print_reuse(void)
+{
+    if (reuse.windows == 0) {
+        printf("Streaming reuse: no consecutive MFCC windows to compare\n");
+        return;
+    }
+    printf("Streaming reuse: %u windows, shift %u rows; overlap MFCC values identical %.1f%%, "
+        "int8 inputs identical %.1f%%, whole input rows identical %.1f%%\n",
+        reuse.windows, reuse.shift_rows, 100.0f * reuse.features_same / reuse.features,
+        100.0f * reuse.inputs_same / reuse.inputs, 100.0f * reuse.rows_same / reuse.rows);
+}
+
+/**
+ * @brief      Replay all files with every number of slices per model window and
+ *             print the CPU time the classifier needs per second of audio at
+ *             each hop
+ */
+static void hop_benchmark(const std::vector<REPLAY_FILE> &files, int runs)
+{
+    printf("\nslices  hop ms  classified  us/slice   CPU %%  coughs  sneezes\n");
+    for (uint32_t slices = SLICE_CLASSIFIER_MIN_SLICES; slices <= SLICE_CLASSIFIER_MAX_SLICES; slices++) {
+        slice_classifier_set_slices(slices);
+
+        REPLAY_STATS stats;
+        memset(&stats, 0, sizeof(stats));
+        for (size_t ix = 0; ix < files.size(); ix++) {
+            for (int run = 0; run < runs; run++) {
+                replay(files[ix].path, files[ix].samples, false, &stats);
+            }
+        }
+
+        const uint32_t classified = stats.slices - stats.gated;
+        printf("%6u  %6u  %10u  %8.0f  %6.2f  %6u  %7u\n", slices,
+            slice_classifier_slice_size(slices) * 1000 / EI_CLASSIFIER_FREQUENCY, classified,
+            classified ? (float)stats.busy_us / classified : 0.0f,
+            stats.samples ? 100.0f * stats.busy_us * EI_CLASSIFIER_FREQUENCY / (stats.samples * 1e6f) : 0.0f,
+            stats.events[EVENT_COUGH], stats.events[EVENT_SNEEZE]);
+    }
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [-v] [-a] [-n runs] [-s slices] [-w workers] [-r] [-b] file.wav...\n"
+        "  -v         print the scores of every classified slice\n"
+        "  -a         classify every slice, the energy gate only tracks the noise floor\n"
+        "  -n runs    replay every file this many times, for timing\n"
+        "  -s slices  slices per model window, %u to %u (default %u)\n"
+        "  -w workers DSP workers the MFCC frames are split between, 1 or 2 (default 1)\n"
+        "  -r         compare every model window with the one before it and print how\n"
+        "             much of the MFCC features and of the int8 model input survived the shift\n"
+        "  -b         replay with every number of slices and print the CPU load of each hop\n"
+        "Files must be 16 bit PCM at %u Hz, only the first channel is used.\n",
+        name, (unsigned)SLICE_CLASSIFIER_MIN_SLICES, (unsigned)SLICE_CLASSIFIER_MAX_SLICES,
+        (unsigned)EI_CLASSIFIER_SLICES_PER_MODEL_WINDOW, (unsigned)EI_CLASSIFIER_FREQUENCY);
+}
+
+int main(int argc, char **argv)
+{
+    int runs = 1;
+    int slices = EI_CLASSIFIER_SLICES_PER_MODEL_WINDOW;
+    int workers = 1;
+    bool benchmark = false;
+    int opt;
+    while ((opt = getopt(argc, argv, "van:s:w:rb")) != -1) {
+        switch (opt) {
+        case 'v':
+            verbose = true;
+            break;
+        case 'a':
+            gate_enabled = false;
+            break;
+        case 'n':
+            runs = atoi(optarg);
+            if (runs < 1) {
+                usage(argv[0]);
+                return 2;
+            }
+            break;
+        case 's':
+            slices = atoi(optarg);
+            if (!slice_classifier_valid_slices(slices)) {
+                usage(argv[0]);
+                return 2;
+            }
+            break;
+        case 'w':
+            workers = atoi(optarg);
+            if (workers < 1 || workers > 2) {
+                usage(argv[0]);
+                return 2;
+            }
+            break;
+        case 'r':
+            reuse_report = true;
+            break;
+        case 'b':
+            benchmark = true;
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (optind >= argc) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    slice_classifier_set_slices(slices);
+    if (workers > 1) {
+        dsp_workers_start();
+    }
+    printf("Model: %u Hz, %u samples per window, %u slices per window, %u labels, DSP workers: %d\n",
+        (unsigned)EI_CLASSIFIER_FREQUENCY, (unsigned)EI_CLASSIFIER_RAW_SAMPLE_COUNT,
+        (unsigned)slice_classifier_slices(), (unsigned)EI_CLASSIFIER_LABEL_COUNT, ei_dsp_workers());
+
+    REPLAY_STATS stats;
+    memset(&stats, 0, sizeof(stats));
+    int errors = 0;
+
+    std::vector<REPLAY_FILE> files;
+    for (int ix = optind; ix < argc; ix++) {
+        REPLAY_FILE file;
+        file.path = argv[ix];
+        uint32_t sample_rate = 0;
+        size_t count = 0;
+        int16_t *samples = wav_read(file.path, &count, &sample_rate);
+        if (samples == NULL) {
+            errors++;
+            continue;
+        }
+        file.samples.assign(samples, samples + count);
+        free(samples);
+        if (sample_rate != EI_CLASSIFIER_FREQUENCY) {
+            ESP_LOGE(TAG, "%s: %u Hz, the model needs %u Hz", file.path, sample_rate, (unsigned)EI_CLASSIFIER_FREQUENCY);
+            errors++;
+            continue;
+        }
+        files.push_back(file);
+    }
+
+    for (size_t ix = 0; ix < files.size(); ix++) {
+        for (int run = 0; run < runs; run++) {
+            replay(files[ix].path, files[ix].samples, run == 0, &stats);
+        }
+    }
+
+    print_summary(&stats);
+    if (reuse_report) {
+        print_reuse();
+    }
+    if (ei_dsp_workers() > 1) {
+        dsp_workers_log(TAG);
+    }
+
+    if (benchmark) {
+        hop_benchmark(files, runs);
+    }
+    slice_classifier_deinit();
+
+    return errors > 0 || stats.failed > 0 ? 1 : 0;
+}
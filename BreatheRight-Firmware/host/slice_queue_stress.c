@@ -0,0 +1,139 @@
+/*
+ * Host slice queue stress test
+ * BreatheRight v1.0
+ * slice_queue_stress.c
+ *
+ * Copyright (C) 2020 Upbeat Labs LLC or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * A producer and a consumer pthread pass patterned slices through
+ * slice_queue.c, the way microphoneTask and inferenceTask do, and the
+ * consumer checks every sample and the metadata. Run on a multi-core host
+ * the two threads really do touch the queue at the same time.
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "slice_queue.h"
+
+#define SLICE_SAMPLES 64
+
+static SLICE_QUEUE queue;
+static uint32_t slices;
+static uint32_t producer_waits;
+
+static int16_t pattern(uint32_t seq, uint32_t ix)
+{
+    return (int16_t)(seq * 2654435761u + ix * 40503u);
+}
+
+static void *producer(void *arg)
+{
+    (void)arg;
+    for (uint32_t seq = 0; seq < slices; seq++) {
+        int16_t *slot;
+        while ((slot = slice_queue_write_slot(&queue)) == NULL) {
+            producer_waits++;
+            sched_yield();
+        }
+        for (uint32_t ix = 0; ix < SLICE_SAMPLES; ix++) {
+            slot[ix] = pattern(seq, ix);
+        }
+        SLICE_INFO *info = slice_queue_write_info(&queue);
+        info->seq = seq;
+        info->active = seq & 1;
+        slice_queue_push(&queue);
+    }
+    return NULL;
+}
+
+/** Returns the number of corrupted slices */
+static uint32_t consume(void)
+{
+    uint32_t corrupted = 0;
+    for (uint32_t seq = 0; seq < slices; seq++) {
+        const int16_t *slot;
+        while ((slot = slice_queue_read_slot(&queue)) == NULL) {
+            sched_yield();
+        }
+        const SLICE_INFO *info = slice_queue_read_info(&queue);
+        bool ok = info->seq == seq && info->active == (bool)(seq & 1) && slice_queue_count(&queue) <= queue.depth;
+        for (uint32_t ix = 0; ix < SLICE_SAMPLES && ok; ix++) {
+            ok = slot[ix] == pattern(seq, ix);
+        }
+        if (!ok && corrupted++ == 0) {
+            fprintf(stderr, "slice %u corrupted (seq %u in the metadata)\n", seq, info->seq);
+        }
+        slice_queue_pop(&queue);
+    }
+    return corrupted;
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [-d depth] [-n slices]\n"
+        "  -d depth   queue depth (default 3, AUDIO_SLICE_QUEUE_DEPTH)\n"
+        "  -n slices  slices to pass through (default 2000000)\n", name);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t depth = 3;
+    slices = 2000000;
+    int opt;
+    while ((opt = getopt(argc, argv, "d:n:")) != -1) {
+        switch (opt) {
+        case 'd':
+            depth = atoi(optarg);
+            break;
+        case 'n':
+            slices = atoi(optarg);
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (depth < 1 || slices < 1 || optind != argc) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    if (!slice_queue_init(&queue, depth, SLICE_SAMPLES)) {
+        fprintf(stderr, "slice_queue_init failed\n");
+        return 1;
+    }
+
+    pthread_t thread;
+    pthread_create(&thread, NULL, producer, NULL);
+    uint32_t corrupted = consume();
+    pthread_join(thread, NULL);
+
+    printf("depth %u: %u slices, %u corrupted, %u producer waits, high-water mark %u, %u left\n",
+        depth, slices, corrupted, producer_waits, queue.max_count, slice_queue_count(&queue));
+    bool ok = corrupted == 0 && slice_queue_count(&queue) == 0 && queue.max_count <= depth;
+    slice_queue_deinit(&queue);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,224 @@
+/*
+ * Host sparse filterbank check
+ * BreatheRight v1.0
+ * sparse_check.cpp
+ *
+ * Copyright (C) 2020 Upbeat Labs LLC or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Checks the sparse mel filterbank (speechpy::feature::sparse_filterbanks and
+ * apply_filterbank) against the dense num_filters x coefficients filterbank it
+ * replaced, and the truncated DCT of mfcc_from_mfe (dct2_rows) against the
+ * full kissfft numpy::dct2, over a range of filterbank configurations and
+ * random power spectra. The filterbank weights and mel energies must be
+ * identical, the cepstral coefficients equal within float rounding.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <vector>
+
+#include <Cough_Tutorial_inferencing.h>
+
+using namespace ei;
+
+typedef struct FILTERBANK_CONFIG {
+    uint16_t num_filters;
+    uint16_t fft_length;
+    uint32_t sampling_freq;
+    uint32_t low_freq;
+    uint32_t high_freq;     // 0 is sampling_freq / 2
+} FILTERBANK_CONFIG;
+
+static const FILTERBANK_CONFIG configs[] = {
+    { 32, 256, 16000, 300, 0 },     // the impulse
+    { 40, 512, 16000, 300, 0 },     // speechpy defaults
+    { 26, 256, 16000, 0, 8000 },
+    { 20, 128, 8000, 300, 4000 },
+    { 64, 512, 16000, 80, 7600 },
+    { 32, 256, 44100, 300, 0 },
+    { 80, 1024, 16000, 20, 0 },
+};
+
+static uint32_t rng_state = 1;
+
+/** Uniform in [0, 1) */
+static float rng_unit(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return (rng_state >> 8) * (1.0f / 16777216.0f);
+}
+
+/** Dense weight of filter row, bin column, as the MFCC used to read it */
+static float dense_weight(const void *dense, uint32_t coefficients, uint16_t row, int bin)
+{
+#if EIDSP_QUANTIZE_FILTERBANK
+    const quantized_matrix_t *m = (const quantized_matrix_t *)dense;
+    return m->dequantization_fn(m->buffer[row * coefficients + bin]);
+#else
+    const matrix_t *m = (const matrix_t *)dense;
+    return m->buffer[row * coefficients + bin];
+#endif
+}
+
+/** Returns the number of mismatches of one filterbank configuration */
+static int check_filterbank(const FILTERBANK_CONFIG *config, int frames, float *max_dct_diff)
+{
+    const int coefficients = config->fft_length / 2 + 1;
+    const uint32_t high_freq = config->high_freq ? config->high_freq : config->sampling_freq / 2;
+    int failed = 0;
+
+#if EIDSP_QUANTIZE_FILTERBANK
+    quantized_matrix_t dense(config->num_filters, coefficients, &numpy::dequantize_zero_one);
+#else
+    matrix_t dense(config->num_filters, coefficients);
+#endif
+    speechpy::sparse_filterbank_t sparse;
+    if (speechpy::feature::filterbanks(&dense, config->num_filters, coefficients, config->sampling_freq,
+            config->low_freq, high_freq) != EIDSP_OK ||
+        speechpy::feature::sparse_filterbanks(&sparse, config->num_filters, coefficients,
+            config->sampling_freq, config->low_freq, high_freq) != EIDSP_OK) {
+        fprintf(stderr, "%u filters, fft %u: filterbank failed\n", config->num_filters, config->fft_length);
+        return 1;
+    }
+
+    // every dense weight is either in the run of its filter or zero
+    const float *w = sparse.weights;
+    for (uint16_t i = 0; i < config->num_filters; i++) {
+        const int first = sparse.runs[2 * i];
+        const int length = sparse.runs[2 * i + 1];
+        for (int bin = 0; bin < coefficients; bin++) {
+            const float expected = dense_weight(&dense, coefficients, i, bin);
+            const float actual = bin >= first && bin < first + length ? w[bin - first] : 0.0f;
+            if (expected != actual) {
+                fprintf(stderr, "%u filters, fft %u: filter %u bin %d is %g, dense %g\n", config->num_filters,
+                    config->fft_length, i, bin, actual, expected);
+                failed++;
+            }
+        }
+        w += length;
+    }
+
+    std::vector<float> frame(coefficients);
+    std::vector<float> mel_sparse(config->num_filters);
+    std::vector<float> mel_dense(config->num_filters);
+    const uint8_t num_cepstral = config->num_filters / 2 + 1;
+    std::vector<float> dct(num_cepstral * config->num_filters);
+    speechpy::feature::dct2_rows(dct.data(), num_cepstral, config->num_filters);
+
+    for (int f = 0; f < frames; f++) {
+        // power spectrum over a wide dynamic range, with some silent bins
+        for (int bin = 0; bin < coefficients; bin++) {
+            const float u = rng_unit();
+            frame[bin] = u < 0.05f ? 0.0f : powf(10.0f, 8.0f * rng_unit() - 4.0f);
+        }
+
+        speechpy::feature::apply_filterbank(&sparse, frame.data(), mel_sparse.data());
+        for (uint16_t i = 0; i < config->num_filters; i++) {
+            float acc = 0.0f;
+            for (int bin = 0; bin < coefficients; bin++) {
+                acc += frame[bin] * dense_weight(&dense, coefficients, i, bin);
+            }
+            mel_dense[i] = acc;
+            if (mel_sparse[i] != acc) {
+                fprintf(stderr, "%u filters, fft %u: frame %d filter %u is %.9g, dense %.9g\n",
+                    config->num_filters, config->fft_length, f, i, mel_sparse[i], acc);
+                failed++;
+            }
+        }
+
+        // the log mel energies as mfcc_from_mfe sees them, through both DCTs
+        for (uint16_t i = 0; i < config->num_filters; i++) {
+            mel_dense[i] = logf(mel_dense[i] < 1e-30f ? 1e-30f : mel_dense[i]);
+        }
+        float scale = 0.0f;
+        for (uint16_t i = 0; i < config->num_filters; i++) {
+            scale = fmaxf(scale, fabsf(mel_dense[i]));
+        }
+        for (uint16_t i = 0; i < num_cepstral; i++) {
+            float acc = 0.0f;
+            for (uint16_t k = 0; k < config->num_filters; k++) {
+                acc += dct[i * config->num_filters + k] * mel_dense[k];
+            }
+            mel_sparse[i] = acc;
+        }
+        if (numpy::dct2(mel_dense.data(), config->num_filters, DCT_NORMALIZATION_ORTHO) != EIDSP_OK) {
+            fprintf(stderr, "%u filters: dct2 failed\n", config->num_filters);
+            return failed + 1;
+        }
+        // dct::transform only writes the first num_filters / 2 + 1 coefficients,
+        // the MFCC keeps fewer (num_cepstral 13 of 32 for the impulse)
+        for (uint16_t i = 0; i < num_cepstral; i++) {
+            // relative to the largest log energy of the frame
+            const float diff = fabsf(mel_sparse[i] - mel_dense[i]) / scale;
+            if (diff > *max_dct_diff) {
+                *max_dct_diff = diff;
+            }
+        }
+    }
+
+    return failed;
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [-n frames] [-t tolerance]\n"
+        "  -n frames     random power spectra per configuration (default 200)\n"
+        "  -t tolerance  largest DCT difference relative to the log energies (default 1e-5)\n", name);
+}
+
+int main(int argc, char **argv)
+{
+    int frames = 200;
+    float tolerance = 1e-5f;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:t:")) != -1) {
+        switch (opt) {
+        case 'n':
+            frames = atoi(optarg);
+            break;
+        case 't':
+            tolerance = strtof(optarg, NULL);
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    int failed = 0;
+    for (size_t ix = 0; ix < sizeof(configs) / sizeof(configs[0]); ix++) {
+        float max_dct_diff = 0.0f;
+        int n = check_filterbank(&configs[ix], frames, &max_dct_diff);
+        printf("%2u filters, fft %4u, %5u Hz: %d mismatching, DCT max relative diff %.2g\n",
+            configs[ix].num_filters, configs[ix].fft_length, (unsigned)configs[ix].sampling_freq, n,
+            max_dct_diff);
+        if (max_dct_diff > tolerance) {
+            n++;
+        }
+        failed += n;
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,109 @@
+/*
+ * WAV files on the host
+ * BreatheRight v1.0
+ * wav.c
+ *
+ * Copyright (C) 2020 Upbeat Labs LLC or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "wav.h"
+#include "esp_log.h"
+
+static const char *TAG = "WAV";
+
+static uint32_t read_le32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint16_t read_le16(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+int16_t *wav_read(const char *path, size_t *samples, uint32_t *sample_rate)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        ESP_LOGE(TAG, "%s: cannot open", path);
+        return NULL;
+    }
+
+    uint8_t header[12];
+    if (fread(header, 1, sizeof(header), f) != sizeof(header) ||
+        memcmp(header, "RIFF", 4) != 0 || memcmp(header + 8, "WAVE", 4) != 0) {
+        ESP_LOGE(TAG, "%s: not a WAV file", path);
+        fclose(f);
+        return NULL;
+    }
+
+    uint16_t channels = 0, bits = 0;
+    int16_t *out = NULL;
+    uint8_t chunk[8];
+    while (fread(chunk, 1, sizeof(chunk), f) == sizeof(chunk)) {
+        uint32_t size = read_le32(chunk + 4);
+
+        if (memcmp(chunk, "fmt ", 4) == 0 && size >= 16) {
+            uint8_t fmt[16];
+            if (fread(fmt, 1, sizeof(fmt), f) != sizeof(fmt)) {
+                break;
+            }
+            uint16_t format = read_le16(fmt);
+            channels = read_le16(fmt + 2);
+            *sample_rate = read_le32(fmt + 4);
+            bits = read_le16(fmt + 14);
+            // 0xfffe is WAVE_FORMAT_EXTENSIBLE, 16 bit ones are plain PCM in practice
+            if ((format != 1 && format != 0xfffe) || bits != 16 || channels == 0) {
+                ESP_LOGE(TAG, "%s: format %u, %u bits, %u channels, need 16 bit PCM", path, format, bits, channels);
+                break;
+            }
+            fseek(f, (size - 16 + 1) & ~1u, SEEK_CUR);
+        }
+        else if (memcmp(chunk, "data", 4) == 0 && channels > 0) {
+            size_t frames = size / (2 * channels);
+            int16_t *interleaved = (int16_t *)malloc(frames * 2 * channels + 1);
+            if (interleaved == NULL) {
+                ESP_LOGE(TAG, "%s: out of memory", path);
+                break;
+            }
+            frames = fread(interleaved, 2 * channels, frames, f);
+            for (size_t ix = 0; ix < frames; ix++) {
+                interleaved[ix] = interleaved[ix * channels];
+            }
+            *samples = frames;
+            out = interleaved;
+            break;
+        }
+        else {
+            // Chunks are padded to an even size
+            fseek(f, (size + 1) & ~1u, SEEK_CUR);
+        }
+    }
+    fclose(f);
+
+    if (out == NULL && bits == 16) {
+        ESP_LOGE(TAG, "%s: no audio data", path);
+    }
+    return out;
+}
@@ -0,0 +1,238 @@
+/*
+ * Host model window benchmark
+ * BreatheRight v1.0
+ * window_bench.cpp
+ *
+ * Copyright (C) 2020 Upbeat Labs LLC or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Cycles and heap per model window of the continuous classifier, the slices
+ * of 16000 samples of audio fed through slice_classifier_run like
+ * inferenceTask does. Built twice, window_bench_i16 with the int16 signal
+ * path (extract_mfcc_per_slice_features_i16) and window_bench_f32 with the
+ * float one, so the two are measured on the same audio.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <Cough_Tutorial_inferencing.h>
+#include "slice_classifier.h"
+#include "xtensa/hal.h"
+#include "wav.h"
+
+#if CONFIG_AUDIO_I16_SIGNAL_PATH
+#define SIGNAL_PATH "int16"
+#else
+#define SIGNAL_PATH "float"
+#endif
+
+/** Ahead of every ei_malloc block, so ei_free knows what it returns */
+#define HEAP_HEADER 16
+
+/** What the SDK holds through ei_malloc / ei_calloc */
+typedef struct HEAP_STATS {
+    size_t live;                // bytes allocated and not freed
+    size_t peak;                // most live bytes since the last reset
+    uint32_t allocs;            // calls since the last reset
+} HEAP_STATS;
+
+static HEAP_STATS heap;
+
+static void *heap_track(void *block, size_t size)
+{
+    if (block == NULL) {
+        return NULL;
+    }
+    *(size_t *)block = size;
+    heap.live += size;
+    heap.allocs++;
+    if (heap.live > heap.peak) {
+        heap.peak = heap.live;
+    }
+    return (uint8_t *)block + HEAP_HEADER;
+}
+
+// Override the weak ones of the posix porting, which only count the bytes asked for
+void *ei_malloc(size_t size)
+{
+    return heap_track(malloc(size + HEAP_HEADER), size);
+}
+
+void *ei_calloc(size_t nitems, size_t size)
+{
+    if (size != 0 && nitems > (SIZE_MAX - HEAP_HEADER) / size) {
+        return NULL;
+    }
+    return heap_track(calloc(1, nitems * size + HEAP_HEADER), nitems * size);
+}
+
+void ei_free(void *ptr)
+{
+    if (ptr == NULL) {
+        return;
+    }
+    uint8_t *block = (uint8_t *)ptr - HEAP_HEADER;
+    heap.live -= *(size_t *)block;
+    free(block);
+}
+
+/** Best and mean of the windows of all runs */
+typedef struct WINDOW_STATS {
+    uint32_t windows;
+    uint64_t cycles;
+    uint32_t best_cycles;
+    uint64_t mfcc_us;           // preemphasis to DCT, the per slice feature extraction
+    size_t peak;                // most bytes held above the start of a window
+    uint32_t allocs;
+} WINDOW_STATS;
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [-n runs] [file.wav]\n"
+        "  -n runs  passes over the input (default 5)\n"
+        "Without a file, 10 s of noise with a burst is used. Cycles are TSC ticks on x86.\n", name);
+}
+
+int main(int argc, char **argv)
+{
+    int runs = 5;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        switch (opt) {
+        case 'n':
+            runs = atoi(optarg);
+            if (runs < 1) {
+                usage(argv[0]);
+                return 2;
+            }
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (optind < argc - 1) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    size_t count;
+    int16_t *in;
+    if (optind < argc) {
+        uint32_t sample_rate;
+        in = wav_read(argv[optind], &count, &sample_rate);
+        if (in == NULL) {
+            return 1;
+        }
+        if (sample_rate != EI_CLASSIFIER_FREQUENCY) {
+            fprintf(stderr, "%s: %u Hz, the model takes %d Hz\n", argv[optind], sample_rate, EI_CLASSIFIER_FREQUENCY);
+            free(in);
+            return 1;
+        }
+    }
+    else {
+        // Quiet noise with a loud second in the middle, so the MFCC sees both
+        count = 10 * EI_CLASSIFIER_FREQUENCY;
+        in = (int16_t *)malloc(count * sizeof(int16_t));
+        uint32_t seed = 1;
+        for (size_t ix = 0; ix < count; ix++) {
+            seed = seed * 1664525u + 1013904223u;
+            const bool burst = ix >= count / 2 && ix < count / 2 + EI_CLASSIFIER_FREQUENCY;
+            in[ix] = (int16_t)((int16_t)(seed >> 16) / (burst ? 2 : 64));
+        }
+    }
+
+    const uint32_t slices = slice_classifier_slices();
+    const size_t slice_size = slice_classifier_slice_size(slices);
+    // The first window only fills the feature matrix, time the ones after it
+    if (count < 2 * slices * slice_size) {
+        fprintf(stderr, "need at least %zu samples\n", 2 * slices * slice_size);
+        free(in);
+        return 1;
+    }
+    const size_t windows = count / (slices * slice_size);
+
+    WINDOW_STATS stats = {};
+    stats.best_cycles = UINT32_MAX;
+    size_t resident = 0;
+    int failed = 0;
+    for (int run = 0; run < runs; run++) {
+        slice_classifier_reset();
+        const size_t before_run = heap.live;
+        for (size_t window = 0; window < windows; window++) {
+            heap.peak = heap.live;
+            heap.allocs = 0;
+            const size_t start_live = heap.live;
+            uint32_t cycles = 0;
+            uint64_t mfcc_us = 0;
+
+            for (uint32_t slice = 0; slice < slices; slice++) {
+                ei_impulse_result_t result;
+                memset(&result, 0, sizeof(result));
+                const int16_t *at = &in[(window * slices + slice) * slice_size];
+
+                uint32_t start = xthal_get_ccount();
+                EI_IMPULSE_ERROR res = slice_classifier_run(at, &result, false);
+                cycles += xthal_get_ccount() - start;
+                failed += res != EI_IMPULSE_OK;
+
+                ei_stage_times_t times;
+                ei_get_stage_times(&times);
+                for (int stage = EI_STAGE_PREEMPHASIS; stage <= EI_STAGE_DCT; stage++) {
+                    mfcc_us += times.us[stage];
+                }
+            }
+
+            if (window == 0) {
+                continue;
+            }
+            stats.windows++;
+            stats.cycles += cycles;
+            stats.mfcc_us += mfcc_us;
+            if (cycles < stats.best_cycles) {
+                stats.best_cycles = cycles;
+            }
+            if (heap.peak - start_live > stats.peak) {
+                stats.peak = heap.peak - start_live;
+            }
+            stats.allocs += heap.allocs;
+        }
+        resident = heap.live - before_run;
+        slice_classifier_deinit();
+    }
+    free(in);
+
+    printf("%s signal path, %u slices of %zu samples per window, %u windows\n", SIGNAL_PATH,
+        (unsigned)slices, slice_size, (unsigned)stats.windows);
+    printf("cycles per window: %.0f mean, %u best (%.1f per sample)\n", (double)stats.cycles / stats.windows,
+        stats.best_cycles, (double)stats.cycles / stats.windows / (slices * slice_size));
+    printf("MFCC per window: %.0f us\n", (double)stats.mfcc_us / stats.windows);
+    printf("heap per window: %zu bytes peak above the start, %.1f allocations; %zu bytes held between windows\n",
+        stats.peak, (double)stats.allocs / stats.windows, resident);
+    if (failed) {
+        fprintf(stderr, "%d slices failed\n", failed);
+        return 1;
+    }
+    return 0;
+}
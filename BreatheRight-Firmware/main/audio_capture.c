@@ -0,0 +1,253 @@
+/*
+ * Audio capture engine
+ * BreatheRight v1.0
+ * audio_capture.c
+ * 
+ * Copyright (C) 2020 Upbeat Labs LLC or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "driver/i2s.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "xtensa/hal.h"
+
+#include "microphone.h"
+
+#include "audio_capture.h"
+#include "audio_decimator.h"
+#include "task_plan.h"
+
+#define RING_SAMPLES        CONFIG_AUDIO_RING_SAMPLES
+#define RING_MASK           (RING_SAMPLES - 1)
+#define DMA_BUF_COUNT       CONFIG_AUDIO_DMA_BUF_COUNT
+#define DMA_BUF_SAMPLES     CONFIG_AUDIO_DMA_BUF_LEN
+#define DMA_BUF_BYTES       (DMA_BUF_SAMPLES * sizeof(int16_t))
+
+// The driver holds at most DMA_BUF_COUNT - 1 filled buffers and drops the oldest one
+// when another completes. More RX_DONE events pending than that means the difference
+// was overwritten; the event queue is twice as deep so it can still count them.
+#define DMA_BUF_HELD        (DMA_BUF_COUNT - 1)
+#define EVENT_QUEUE_LEN     (2 * DMA_BUF_COUNT)
+
+#if (RING_SAMPLES & RING_MASK) != 0
+#error "CONFIG_AUDIO_RING_SAMPLES must be a power of two"
+#endif
+
+#ifdef CONFIG_AUDIO_DC_BLOCK
+#define DC_BLOCK 1
+#else
+#define DC_BLOCK 0
+#endif
+
+static const char* TAG = AUDIO_CAPTURE_TAG;
+
+static QueueHandle_t i2s_event_queue;
+static TaskHandle_t capture_handle;
+static TaskHandle_t consumer_handle;
+static AUDIO_CAPTURE_TAP tap;
+
+// Single producer (capture task) / single consumer ring. Indices run freely and are
+// masked on access; head is only written by the producer, tail only by the consumer.
+static int16_t* ring;
+static uint32_t ring_head;
+static uint32_t ring_tail;
+
+// raw_buf holds one DMA buffer at the I2S rate, pcm_buf the same buffer after
+// decimation. With a factor of 1 the decimator runs in place.
+static int16_t raw_buf[DMA_BUF_SAMPLES];
+static int16_t pcm_buf[DMA_BUF_SAMPLES / CONFIG_AUDIO_DECIMATION + 1];
+static AUDIO_DECIMATOR decimator;
+static AUDIO_CAPTURE_STATS stats;
+
+static void capture_dma_buffer() {
+    uint32_t head = ring_head;
+    uint32_t tail = __atomic_load_n(&ring_tail, __ATOMIC_ACQUIRE);
+    size_t bytes_read = 0;
+
+    // Always drain the DMA buffer so the driver keeps running.
+    i2s_read(MIC_I2S_NUMBER, raw_buf, DMA_BUF_BYTES, &bytes_read, 0);
+    if (bytes_read < DMA_BUF_BYTES) {
+        stats.short_reads++;
+    }
+
+    if (RING_SAMPLES - (head - tail) < sizeof(pcm_buf) / sizeof(pcm_buf[0])) {
+        // Never overwrite what the consumer has not read.
+        stats.ring_overflows++;
+        stats.dropped_samples += bytes_read / sizeof(int16_t) / CONFIG_AUDIO_DECIMATION;
+        return;
+    }
+
+    uint32_t start = xthal_get_ccount();
+    size_t n = audio_decimator_process(&decimator, raw_buf, bytes_read / sizeof(int16_t), pcm_buf);
+    stats.dsp_cycles += xthal_get_ccount() - start;
+    stats.input_samples += bytes_read / sizeof(int16_t);
+
+    uint32_t offset = head & RING_MASK;
+    uint32_t first = RING_SAMPLES - offset;
+    if (first > n) {
+        first = n;
+    }
+    memcpy(&ring[offset], pcm_buf, first * sizeof(int16_t));
+    memcpy(&ring[0], pcm_buf + first, (n - first) * sizeof(int16_t));
+
+    head += n;
+    __atomic_store_n(&ring_head, head, __ATOMIC_RELEASE);
+
+    stats.dma_buffers++;
+    stats.samples += n;
+    if (head - tail > stats.max_fill) {
+        stats.max_fill = head - tail;
+    }
+
+    TaskHandle_t consumer = __atomic_load_n(&consumer_handle, __ATOMIC_ACQUIRE);
+    if (consumer != NULL) {
+        xTaskNotifyGive(consumer);
+    }
+
+    AUDIO_CAPTURE_TAP t = __atomic_load_n(&tap, __ATOMIC_ACQUIRE);
+    if (t != NULL) {
+        t(pcm_buf, n);
+    }
+}
+
+// Called with one RX_DONE event received. Every event stands for one DMA buffer, so if
+// more are pending than the driver can hold, the oldest buffers are gone: their events
+// are dropped unread, the rest still line up with the buffers i2s_read returns. An
+// event queue found full may have lost events too, the count is then a lower bound.
+static void skip_lost_buffers() {
+    UBaseType_t pending = uxQueueMessagesWaiting(i2s_event_queue) + 1;
+    i2s_event_t event;
+
+    while (pending > DMA_BUF_HELD && xQueueReceive(i2s_event_queue, &event, 0) == pdTRUE) {
+        pending--;
+        if (event.type == I2S_EVENT_RX_DONE) {
+            stats.dma_overflows++;
+            stats.dropped_samples += DMA_BUF_SAMPLES / CONFIG_AUDIO_DECIMATION;
+        } else if (event.type == I2S_EVENT_DMA_ERROR) {
+            stats.dma_errors++;
+        }
+    }
+}
+
+static void audio_capture_task(void* pvParameters) {
+    ESP_LOGI(TAG, "Starting audio capture Task");
+    i2s_event_t event;
+
+    for (;;) {
+        if (xQueueReceive(i2s_event_queue, &event, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+
+        switch (event.type) {
+            case I2S_EVENT_RX_DONE:
+                skip_lost_buffers();
+                capture_dma_buffer();
+                break;
+            case I2S_EVENT_DMA_ERROR:
+                stats.dma_errors++;
+                break;
+            default:
+                break;
+        }
+    }
+    vTaskDelete(NULL); // Should never get to here...
+}
+
+bool audio_capture_start() {
+    ring = (int16_t*)heap_caps_malloc(RING_SAMPLES * sizeof(int16_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (ring == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate %d sample capture ring", RING_SAMPLES);
+        return false;
+    }
+    ring_head = 0;
+    ring_tail = 0;
+    memset(&stats, 0, sizeof(stats));
+    audio_decimator_init(&decimator, CONFIG_AUDIO_DECIMATION, CONFIG_AUDIO_GAIN_Q8, DC_BLOCK);
+
+    Microphone_Init_Config(CONFIG_AUDIO_I2S_SAMPLE_RATE, DMA_BUF_COUNT, DMA_BUF_SAMPLES, EVENT_QUEUE_LEN, &i2s_event_queue);
+    if (i2s_event_queue == NULL) {
+        ESP_LOGE(TAG, "Failed to install I2S driver");
+        heap_caps_free(ring);
+        ring = NULL;
+        return false;
+    }
+
+    ESP_LOGI(TAG, "Capture at %d Hz -> %d Hz, %d x %d sample DMA ring (%d ms), %d sample ring (%d ms)",
+        CONFIG_AUDIO_I2S_SAMPLE_RATE, CONFIG_AUDIO_SAMPLE_RATE, DMA_BUF_COUNT, DMA_BUF_SAMPLES,
+        DMA_BUF_COUNT * DMA_BUF_SAMPLES * 1000 / CONFIG_AUDIO_I2S_SAMPLE_RATE,
+        RING_SAMPLES, RING_SAMPLES * 1000 / CONFIG_AUDIO_SAMPLE_RATE);
+
+    task_plan_create(TASK_AUDIO_CAPTURE, audio_capture_task, NULL, &capture_handle);
+    return true;
+}
+
+size_t audio_capture_read(int16_t* dst, size_t samples, TickType_t ticks_to_wait) {
+    if (ring == NULL || samples > RING_SAMPLES) {
+        return 0;
+    }
+
+    __atomic_store_n(&consumer_handle, xTaskGetCurrentTaskHandle(), __ATOMIC_RELEASE);
+
+    TickType_t start = xTaskGetTickCount();
+    uint32_t tail = ring_tail;
+    uint32_t head = __atomic_load_n(&ring_head, __ATOMIC_ACQUIRE);
+
+    while (head - tail < samples) {
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        if (elapsed >= ticks_to_wait) {
+            return 0;
+        }
+        ulTaskNotifyTake(pdTRUE, ticks_to_wait - elapsed);
+        head = __atomic_load_n(&ring_head, __ATOMIC_ACQUIRE);
+    }
+
+    uint32_t offset = tail & RING_MASK;
+    uint32_t first = RING_SAMPLES - offset;
+    if (first > samples) {
+        first = samples;
+    }
+    memcpy(dst, &ring[offset], first * sizeof(int16_t));
+    memcpy(dst + first, &ring[0], (samples - first) * sizeof(int16_t));
+
+    __atomic_store_n(&ring_tail, tail + samples, __ATOMIC_RELEASE);
+    return samples;
+}
+
+size_t audio_capture_available() {
+    return __atomic_load_n(&ring_head, __ATOMIC_ACQUIRE) - __atomic_load_n(&ring_tail, __ATOMIC_ACQUIRE);
+}
+
+void audio_capture_set_tap(AUDIO_CAPTURE_TAP t) {
+    __atomic_store_n(&tap, t, __ATOMIC_RELEASE);
+}
+
+void audio_capture_get_stats(AUDIO_CAPTURE_STATS* out) {
+    memcpy(out, &stats, sizeof(stats));
+}
+
+uint32_t audio_capture_gaps(const AUDIO_CAPTURE_STATS* s) {
+    return s->dma_errors + s->dma_overflows + s->ring_overflows + s->short_reads;
+}
@@ -0,0 +1,496 @@
+/*
+ * Raw audio recorder
+ * BreatheRight v1.0
+ * audio_recorder.c
+ *
+ * Copyright (C) 2020 Upbeat Labs LLC or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+
+#if CONFIG_AUDIO_RECORDER_SDCARD
+#include "core2forAWS.h"
+#else
+#include "esp_spiffs.h"
+#endif
+
+#include "audio_capture.h"
+#include "audio_recorder.h"
+#include "task_plan.h"
+
+static const char* TAG = AUDIO_RECORDER_TAG;
+
+#if CONFIG_AUDIO_RECORDER
+
+#define BLOCK_BYTES         CONFIG_AUDIO_RECORDER_BLOCK_BYTES
+#define BLOCK_SAMPLES       (BLOCK_BYTES / sizeof(int16_t))
+#define SECTOR_BYTES        512
+
+// Segments are cut on block boundaries
+#define SEGMENT_BLOCKS      ((CONFIG_AUDIO_RECORDER_SEGMENT_S * CONFIG_AUDIO_SAMPLE_RATE + BLOCK_SAMPLES - 1) / BLOCK_SAMPLES)
+#define SEGMENT_BYTES       ((uint32_t)SEGMENT_BLOCKS * BLOCK_BYTES)
+
+// Without a final block from the capture task the capture is not running
+#define STOP_TIMEOUT_MS     1000
+
+#if (BLOCK_BYTES % SECTOR_BYTES) != 0
+#error "CONFIG_AUDIO_RECORDER_BLOCK_BYTES must be a multiple of 512"
+#endif
+
+#if CONFIG_AUDIO_RECORDER_SDCARD
+#define MOUNT_POINT         "/sdcard"
+#else
+#define MOUNT_POINT         "/spiffs"
+#endif
+
+#if CONFIG_AUDIO_RECORDER_WAV
+#define FILE_EXTENSION      "WAV"
+#else
+#define FILE_EXTENSION      "RAW"
+#endif
+
+/** One block handed from the capture task to recorderTask. */
+typedef struct RECORDER_BLOCK {
+    uint8_t index;
+    bool last;                  // recording stopped, close the segment after this block
+    uint16_t samples;
+} RECORDER_BLOCK;
+
+/**
+ * 44 byte canonical header plus a JUNK chunk that pads it to one sector,
+ * so the PCM data starts sector aligned.
+ */
+typedef struct __attribute__((packed)) WAV_HEADER {
+    char riff_id[4];
+    uint32_t riff_size;
+    char wave_id[4];
+    char fmt_id[4];
+    uint32_t fmt_size;
+    uint16_t format;
+    uint16_t channels;
+    uint32_t sample_rate;
+    uint32_t byte_rate;
+    uint16_t block_align;
+    uint16_t bits_per_sample;
+    char junk_id[4];
+    uint32_t junk_size;
+    uint8_t junk[SECTOR_BYTES - 52];
+    char data_id[4];
+    uint32_t data_size;
+} WAV_HEADER;
+
+_Static_assert(sizeof(WAV_HEADER) == SECTOR_BYTES, "WAV header must fill one sector");
+
+static TaskHandle_t recorder_handle;
+static QueueHandle_t block_queue;
+
+// Both blocks come from DMA capable internal RAM so the SD driver writes them
+// without bouncing. Allocated when recording starts the first time.
+static int16_t* blocks[2];
+
+// Set by audio_recorder_enable, followed by recorderTask
+static bool requested;
+
+// Set by the writer once a segment is open, cleared by the capture task when it
+// hands over the last block. The fill state below belongs to the capture task
+// while recording is set and to the writer otherwise.
+static bool recording;
+static bool stop_requested;
+static bool block_busy[2];
+static uint8_t fill_block;
+static uint32_t fill_samples;
+
+// recorderTask only
+static bool active;
+static bool stopping;
+static TickType_t stop_start;
+static bool mounted;
+static uint32_t next_index;
+static int fd = -1;
+static char path[32];
+static uint32_t segment_bytes;
+static uint64_t segment_write_us;
+static uint32_t segment_dropped;
+
+static AUDIO_RECORDER_STATS stats;
+
+static void storage_lock() {
+#if CONFIG_AUDIO_RECORDER_SDCARD
+    // The SD card shares the SPI bus with the display
+    xSemaphoreTake(spi_mutex, portMAX_DELAY);
+    spi_poll();
+#endif
+}
+
+static void storage_unlock() {
+#if CONFIG_AUDIO_RECORDER_SDCARD
+    xSemaphoreGive(spi_mutex);
+#endif
+}
+
+/** Continue numbering after the highest RECnnnnn file already on the storage. */
+static uint32_t find_next_index() {
+    uint32_t next = 0;
+
+    storage_lock();
+    DIR* dir = opendir(MOUNT_POINT);
+    if (dir != NULL) {
+        struct dirent* entry;
+        while ((entry = readdir(dir)) != NULL) {
+            unsigned int index;
+            if (strncmp(entry->d_name, "REC", 3) == 0 && sscanf(entry->d_name + 3, "%5u", &index) == 1 &&
+                index >= next) {
+                next = index + 1;
+            }
+        }
+        closedir(dir);
+    }
+    storage_unlock();
+
+    return next;
+}
+
+static bool storage_mount() {
+    if (mounted) {
+        return true;
+    }
+
+#if CONFIG_AUDIO_RECORDER_SDCARD
+    sdmmc_card_t* card;
+    storage_lock();
+    esp_err_t err = Core2ForAWS_SDcard_Mount(MOUNT_POINT, &card);
+    storage_unlock();
+#else
+    esp_vfs_spiffs_conf_t conf = {
+        .base_path = MOUNT_POINT,
+        .partition_label = NULL,
+        .max_files = 2,
+        .format_if_mount_failed = true,
+    };
+    esp_err_t err = esp_vfs_spiffs_register(&conf);
+#endif
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to mount %s (%s)", MOUNT_POINT, esp_err_to_name(err));
+        return false;
+    }
+
+    mounted = true;
+    next_index = find_next_index();
+    ESP_LOGI(TAG, "Mounted %s, next segment REC%05u." FILE_EXTENSION, MOUNT_POINT, next_index);
+    return true;
+}
+
+static void wav_header(WAV_HEADER* header, uint32_t data_size) {
+    memset(header, 0, sizeof(*header));
+    memcpy(header->riff_id, "RIFF", 4);
+    header->riff_size = sizeof(WAV_HEADER) - 8 + data_size;
+    memcpy(header->wave_id, "WAVE", 4);
+    memcpy(header->fmt_id, "fmt ", 4);
+    header->fmt_size = 16;
+    header->format = 1;
+    header->channels = 1;
+    header->sample_rate = CONFIG_AUDIO_SAMPLE_RATE;
+    header->byte_rate = CONFIG_AUDIO_SAMPLE_RATE * sizeof(int16_t);
+    header->block_align = sizeof(int16_t);
+    header->bits_per_sample = 16;
+    memcpy(header->junk_id, "JUNK", 4);
+    header->junk_size = sizeof(header->junk);
+    memcpy(header->data_id, "data", 4);
+    header->data_size = data_size;
+}
+
+static bool segment_open() {
+    snprintf(path, sizeof(path), MOUNT_POINT "/REC%05u." FILE_EXTENSION, next_index++);
+
+    storage_lock();
+    fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    bool ok = fd >= 0;
+#if CONFIG_AUDIO_RECORDER_WAV
+    if (ok) {
+        // Sizes are filled in when the segment is closed
+        WAV_HEADER header;
+        wav_header(&header, 0);
+        ok = write(fd, &header, sizeof(header)) == sizeof(header);
+    }
+#endif
+    storage_unlock();
+
+    if (!ok) {
+        ESP_LOGE(TAG, "Failed to create %s", path);
+        if (fd >= 0) {
+            close(fd);
+            fd = -1;
+        }
+        stats.write_errors++;
+        return false;
+    }
+
+    segment_bytes = 0;
+    segment_write_us = 0;
+    segment_dropped = stats.blocks_dropped;
+    stats.segments++;
+    return true;
+}
+
+static void segment_close() {
+    if (fd < 0) {
+        return;
+    }
+
+    storage_lock();
+#if CONFIG_AUDIO_RECORDER_WAV
+    WAV_HEADER header;
+    wav_header(&header, segment_bytes);
+    if (lseek(fd, 0, SEEK_SET) != 0 || write(fd, &header, sizeof(header)) != sizeof(header)) {
+        stats.write_errors++;
+        ESP_LOGE(TAG, "Failed to finalize the header of %s", path);
+    }
+#endif
+    close(fd);
+    storage_unlock();
+    fd = -1;
+
+    ESP_LOGI(TAG, "Closed %s: %u KiB, %.1f s, written at %u KiB/s, %u blocks dropped",
+        path, segment_bytes / 1024, segment_bytes / (float)(CONFIG_AUDIO_SAMPLE_RATE * sizeof(int16_t)),
+        segment_write_us > 0 ? (uint32_t)((uint64_t)segment_bytes * 1000000 / 1024 / segment_write_us) : 0,
+        stats.blocks_dropped - segment_dropped);
+}
+
+static bool write_block(const RECORDER_BLOCK* block) {
+    if (segment_bytes >= SEGMENT_BYTES) {
+        segment_close();
+        if (!segment_open()) {
+            return false;
+        }
+    }
+
+    size_t bytes = block->samples * sizeof(int16_t);
+
+    storage_lock();
+    int64_t start = esp_timer_get_time();
+    ssize_t written = write(fd, blocks[block->index], bytes);
+    uint32_t elapsed = (uint32_t)(esp_timer_get_time() - start);
+    storage_unlock();
+
+    if (written != (ssize_t)bytes) {
+        ESP_LOGE(TAG, "Write to %s failed after %u bytes, storage full or removed?", path, segment_bytes);
+        stats.write_errors++;
+        return false;
+    }
+
+    segment_bytes += bytes;
+    segment_write_us += elapsed;
+    stats.blocks_written++;
+    stats.bytes_written += bytes;
+    stats.write_us += elapsed;
+    if (elapsed > stats.max_write_us) {
+        stats.max_write_us = elapsed;
+    }
+    return true;
+}
+
+/** Hand the block being filled to the writer. Capture task only. */
+static void hand_off(bool last) {
+    uint8_t next = fill_block ^ 1;
+
+    // The writer still owns the other block: keep filling this one and lose what it held
+    if (!last && __atomic_load_n(&block_busy[next], __ATOMIC_ACQUIRE)) {
+        stats.blocks_dropped++;
+        fill_samples = 0;
+        return;
+    }
+
+    RECORDER_BLOCK block = { .index = fill_block, .last = last, .samples = (uint16_t)fill_samples };
+    __atomic_store_n(&block_busy[fill_block], true, __ATOMIC_RELEASE);
+    xQueueSend(block_queue, &block, 0);
+
+    fill_block = next;
+    fill_samples = 0;
+}
+
+/** Capture tap, runs in the capture task for every decimated DMA buffer. */
+static void recorder_tap(const int16_t* pcm, size_t samples) {
+    if (!__atomic_load_n(&recording, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+
+    while (samples > 0) {
+        size_t n = BLOCK_SAMPLES - fill_samples;
+        if (n > samples) {
+            n = samples;
+        }
+        memcpy(blocks[fill_block] + fill_samples, pcm, n * sizeof(int16_t));
+        fill_samples += n;
+        pcm += n;
+        samples -= n;
+
+        if (fill_samples == BLOCK_SAMPLES) {
+            hand_off(false);
+        }
+    }
+
+    if (__atomic_load_n(&stop_requested, __ATOMIC_ACQUIRE)) {
+        hand_off(true);
+        __atomic_store_n(&recording, false, __ATOMIC_RELEASE);
+    }
+}
+
+static void recording_start() {
+    for (int i = 0; i < 2; i++) {
+        if (blocks[i] == NULL) {
+            blocks[i] = (int16_t*)heap_caps_malloc(BLOCK_BYTES, MALLOC_CAP_DMA);
+        }
+    }
+    if (blocks[0] == NULL || blocks[1] == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate 2 x %d byte recorder blocks", BLOCK_BYTES);
+        __atomic_store_n(&requested, false, __ATOMIC_RELEASE);
+        return;
+    }
+
+    if (!storage_mount() || !segment_open()) {
+        __atomic_store_n(&requested, false, __ATOMIC_RELEASE);
+        return;
+    }
+
+    fill_block = 0;
+    fill_samples = 0;
+    block_busy[0] = false;
+    block_busy[1] = false;
+    __atomic_store_n(&stop_requested, false, __ATOMIC_RELEASE);
+    __atomic_store_n(&recording, true, __ATOMIC_RELEASE);
+
+    active = true;
+    stats.recording = true;
+    ESP_LOGI(TAG, "Recording to %s, %d s segments, 2 x %d byte blocks", path, CONFIG_AUDIO_RECORDER_SEGMENT_S,
+        BLOCK_BYTES);
+}
+
+static void recording_finish() {
+    segment_close();
+    active = false;
+    stopping = false;
+    stats.recording = false;
+    ESP_LOGI(TAG, "Recording stopped: %u segments, %u blocks written at %u KiB/s (slowest %u ms), %u dropped, %u errors",
+        stats.segments, stats.blocks_written, audio_recorder_throughput_kbs(&stats), stats.max_write_us / 1000,
+        stats.blocks_dropped, stats.write_errors);
+}
+
+static void recorder_task(void* pvParameters) {
+    ESP_LOGI(TAG, "Starting recorder Task");
+    RECORDER_BLOCK block;
+
+    for (;;) {
+        if (xQueueReceive(block_queue, &block, pdMS_TO_TICKS(100)) == pdTRUE) {
+            if (block.samples > 0 && fd >= 0 && !write_block(&block)) {
+                // Drop the segment's open file and let the capture task wind down
+                segment_close();
+                __atomic_store_n(&requested, false, __ATOMIC_RELEASE);
+            }
+            __atomic_store_n(&block_busy[block.index], false, __ATOMIC_RELEASE);
+
+            if (block.last) {
+                recording_finish();
+            }
+        }
+
+        bool want = __atomic_load_n(&requested, __ATOMIC_ACQUIRE);
+        if (want && !active) {
+            recording_start();
+        }
+        else if (!want && active && !stopping) {
+            stopping = true;
+            stop_start = xTaskGetTickCount();
+            __atomic_store_n(&stop_requested, true, __ATOMIC_RELEASE);
+        }
+        else if (stopping && xTaskGetTickCount() - stop_start > pdMS_TO_TICKS(STOP_TIMEOUT_MS) &&
+                 uxQueueMessagesWaiting(block_queue) == 0) {
+            // The capture task never came back for the last block, it is not running
+            __atomic_store_n(&recording, false, __ATOMIC_RELEASE);
+            recording_finish();
+        }
+    }
+    vTaskDelete(NULL); // Should never get to here...
+}
+
+bool audio_recorder_init() {
+    block_queue = xQueueCreate(2, sizeof(RECORDER_BLOCK));
+    if (block_queue == NULL) {
+        ESP_LOGE(TAG, "Failed to create the block queue");
+        return false;
+    }
+
+    if (task_plan_create(TASK_RECORDER, recorder_task, NULL, &recorder_handle) != pdPASS) {
+        return false;
+    }
+
+    audio_capture_set_tap(recorder_tap);
+    return true;
+}
+
+void audio_recorder_enable(bool enable) {
+    __atomic_store_n(&requested, enable, __ATOMIC_RELEASE);
+}
+
+bool audio_recorder_enabled() {
+    return __atomic_load_n(&requested, __ATOMIC_ACQUIRE);
+}
+
+void audio_recorder_get_stats(AUDIO_RECORDER_STATS* out) {
+    memcpy(out, &stats, sizeof(stats));
+}
+
+uint32_t audio_recorder_throughput_kbs(const AUDIO_RECORDER_STATS* s) {
+    return s->write_us > 0 ? (uint32_t)(s->bytes_written * 1000000 / 1024 / s->write_us) : 0;
+}
+
+#else
+
+bool audio_recorder_init() {
+    ESP_LOGI(TAG, "Audio recorder is disabled (AUDIO_RECORDER)");
+    return false;
+}
+
+void audio_recorder_enable(bool enable) {
+}
+
+bool audio_recorder_enabled() {
+    return false;
+}
+
+void audio_recorder_get_stats(AUDIO_RECORDER_STATS* out) {
+    memset(out, 0, sizeof(*out));
+}
+
+uint32_t audio_recorder_throughput_kbs(const AUDIO_RECORDER_STATS* s) {
+    return 0;
+}
+
+#endif // CONFIG_AUDIO_RECORDER
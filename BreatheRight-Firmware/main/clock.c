@@ -38,6 +38,7 @@
 #include "core2forAWS.h"
 
 #include "clock.h"
+#include "task_plan.h"
 
 static const char* TAG = CLOCK_TAB_NAME;
 
@@ -133,7 +134,7 @@ static char* generate_roller_str(int number)
 }
 
 void display_clock_info(lv_obj_t* core2forAWS_screen_obj){
-    xTaskCreatePinnedToCore(clock_task, "clockTask", configMINIMAL_STACK_SIZE * 3, (void*) core2forAWS_screen_obj, 0, &clock_handle, 1);
+    task_plan_create(TASK_CLOCK, clock_task, (void*) core2forAWS_screen_obj, &clock_handle);
 }
 
 void clock_task(void* pvParameters){
@@ -4,3 +4,45 @@
 # (Uses default behaviour of compiling all source files in directory, adding 'include' to include path.)
 
 CXXFLAGS += -std=c++11
+
+CPPFLAGS += -DEI_CLASSIFIER_SLICES_PER_MODEL_WINDOW=$(CONFIG_CLASSIFIER_SLICES_PER_WINDOW)
+
+ifdef CONFIG_AUDIO_MFCC_FIXED_POINT
+CPPFLAGS += -DEIDSP_MFCC_FIXED_POINT=1
+endif
+
+ifdef CONFIG_AUDIO_MFCC_STATIC_TABLES
+CPPFLAGS += -DEIDSP_MFCC_STATIC=1
+endif
+
+ifdef CONFIG_AUDIO_MFCC_DUAL_CORE
+CPPFLAGS += -DEIDSP_MFCC_PARALLEL=1
+endif
+
+ifdef CONFIG_AUDIO_FFT_PLAN_CACHE
+CPPFLAGS += -DEIDSP_CACHE_FFT_PLANS=1
+endif
+
+ifdef CONFIG_AUDIO_FUSED_POWER_SPECTRUM
+CPPFLAGS += -DEIDSP_FUSED_POWER_SPECTRUM=1
+endif
+
+ifdef CONFIG_CLASSIFIER_PERSISTENT_MODEL
+CPPFLAGS += -DEI_CLASSIFIER_PERSISTENT_MODEL=1
+endif
+
+ifdef CONFIG_CLASSIFIER_FUSED_INPUT_QUANTIZATION
+CPPFLAGS += -DEI_CLASSIFIER_FUSED_INPUT_QUANTIZATION=1
+endif
+
+ifdef CONFIG_CLASSIFIER_XTENSA_KERNELS
+CPPFLAGS += -DEI_CLASSIFIER_TFLITE_ENABLE_XTENSA_KERNELS=1
+endif
+
+ifdef CONFIG_CLASSIFIER_LAYER_PROFILE
+CPPFLAGS += -DEI_CLASSIFIER_PROFILE_LAYERS=1
+endif
+
+ifdef CONFIG_INFERENCE_PROFILER
+CPPFLAGS += -DEIDSP_PROFILE_STAGES=1
+endif
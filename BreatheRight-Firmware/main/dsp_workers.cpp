@@ -0,0 +1,149 @@
+/*
+ * DSP worker on the second core
+ * BreatheRight v1.0
+ * dsp_workers.cpp
+ * 
+ * Copyright (C) 2020 Upbeat Labs LLC or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <atomic>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+
+#include "edge-impulse-sdk/porting/ei_classifier_porting.h"
+#include "task_plan.h"
+#include "dsp_workers.h"
+
+#define DSP_WORKERS 2
+
+/** Where the posted loop is: dspWorkerTask only joins a loop it moves from POSTED to RUNNING */
+enum {
+    JOB_IDLE = 0,
+    JOB_POSTED,
+    JOB_RUNNING
+};
+
+/** The loop ei_dsp_parallel_for is running */
+typedef struct DSP_JOB {
+    ei_dsp_work_fn fn;
+    void* ctx;
+    size_t count;
+    std::atomic<size_t> next;   // next item to claim
+    std::atomic<int> result;    // first error of an item
+} DSP_JOB;
+
+static TaskHandle_t worker_handle;
+static SemaphoreHandle_t job_done;
+static DSP_JOB job;
+static std::atomic<int> job_state(JOB_IDLE);
+static int workers_limit = DSP_WORKERS;
+
+/** Items each worker took and loops run, for dsp_workers_log. Each counter has a single writer */
+static uint32_t items_taken[DSP_WORKERS];
+static uint32_t loops;
+
+/** Claim and run items of job until none are left, or one fails */
+static void run_items(int worker) {
+    size_t ix;
+    while ((ix = job.next.fetch_add(1)) < job.count) {
+        int ret = job.fn(job.ctx, ix, ix + 1, worker);
+        items_taken[worker]++;
+        if (ret != 0) {
+            int expected = 0;
+            job.result.compare_exchange_strong(expected, ret);
+            job.next.store(job.count);
+        }
+    }
+}
+
+static void dsp_worker_task(void* pvParameters) {
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        int expected = JOB_POSTED;
+        if (!job_state.compare_exchange_strong(expected, JOB_RUNNING)) {
+            // The caller finished the loop alone and took it back
+            continue;
+        }
+        run_items(1);
+        job_state.store(JOB_IDLE);
+        xSemaphoreGive(job_done);
+    }
+    vTaskDelete(NULL); // Should never get to here...
+}
+
+int ei_dsp_parallel_for(size_t count, ei_dsp_work_fn fn, void* ctx) {
+    if (worker_handle == NULL || workers_limit < 2 || count < 2) {
+        return fn(ctx, 0, count, 0);
+    }
+
+    job.fn = fn;
+    job.ctx = ctx;
+    job.count = count;
+    job.next.store(0);
+    job.result.store(0);
+    job_state.store(JOB_POSTED);
+    xTaskNotifyGive(worker_handle);
+    loops++;
+
+    run_items(0);
+
+    int expected = JOB_POSTED;
+    if (!job_state.compare_exchange_strong(expected, JOB_IDLE)) {
+        // dspWorkerTask joined, wait until it is off its last item
+        xSemaphoreTake(job_done, portMAX_DELAY);
+    }
+    return job.result.load();
+}
+
+int ei_dsp_workers(void) {
+    return worker_handle != NULL && workers_limit >= 2 ? DSP_WORKERS : 1;
+}
+
+int ei_set_dsp_workers(int n) {
+    int previous = workers_limit;
+    workers_limit = n < 1 ? 1 : n > DSP_WORKERS ? DSP_WORKERS : n;
+    return previous;
+}
+
+bool dsp_workers_start(void) {
+    job_done = xSemaphoreCreateBinary();
+    if (job_done == NULL) {
+        return false;
+    }
+    if (task_plan_create(TASK_DSP_WORKER, dsp_worker_task, NULL, &worker_handle) != pdPASS) {
+        worker_handle = NULL;
+        return false;
+    }
+    return true;
+}
+
+void dsp_workers_log(const char* tag) {
+    uint32_t worker_items = items_taken[1];
+    uint32_t total = items_taken[0] + worker_items;
+    ESP_LOGI(tag, "DSP workers: %u parallel loops, %u items, %.1f%% on %s", loops, total,
+        total ? 100.0f * worker_items / total : 0.0f, task_plan[TASK_DSP_WORKER].name);
+    items_taken[0] = 0;
+    items_taken[1] = 0;
+    loops = 0;
+}
@@ -62,5 +62,33 @@
 #endif // CPU_ARC
 #endif // EI_CLASSIFIER_TFLITE_ENABLE_ARC
 
+// Replace the reference int8 Conv2D and FullyConnected kernels with the ones
+// in kernels/internal/optimized/integer_ops, tuned for cores without SIMD
+// such as the ESP32 (Xtensa LX6). They produce bit exact results. Only used
+// when neither CMSIS-NN nor ARC MLI kernels are enabled
+#ifndef EI_CLASSIFIER_TFLITE_ENABLE_XTENSA_KERNELS
+#define EI_CLASSIFIER_TFLITE_ENABLE_XTENSA_KERNELS  0
+#endif // EI_CLASSIFIER_TFLITE_ENABLE_XTENSA_KERNELS
+
+// Keep the EON compiled model (tensor arena, tensors and prepared kernels)
+// resident from run_classifier_init until run_classifier_deinit, instead of
+// setting it up and tearing it down around every inference
+#ifndef EI_CLASSIFIER_PERSISTENT_MODEL
+#define EI_CLASSIFIER_PERSISTENT_MODEL              0
+#endif // EI_CLASSIFIER_PERSISTENT_MODEL
+
+// Normalize the MFCC features of run_classifier_continuous straight into the
+// int8 input tensor of the resident model (EI_CLASSIFIER_PERSISTENT_MODEL),
+// quantizing in the same pass, instead of through a float copy of them
+#ifndef EI_CLASSIFIER_FUSED_INPUT_QUANTIZATION
+#define EI_CLASSIFIER_FUSED_INPUT_QUANTIZATION      0
+#endif // EI_CLASSIFIER_FUSED_INPUT_QUANTIZATION
+
+// Count the time spent in every layer of the EON compiled model, in CPU
+// cycles on Xtensa and in microseconds elsewhere
+#ifndef EI_CLASSIFIER_PROFILE_LAYERS
+#define EI_CLASSIFIER_PROFILE_LAYERS                0
+#endif // EI_CLASSIFIER_PROFILE_LAYERS
+
 // clang-format on
 #endif // _EI_CLASSIFIER_CONFIG_H_
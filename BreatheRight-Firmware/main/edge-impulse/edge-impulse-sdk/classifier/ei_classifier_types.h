@@ -60,8 +60,8 @@ typedef struct {
 typedef struct {
     uint32_t buf_idx;
     float running_sum;
-#if (EI_CLASSIFIER_SLICES_PER_MODEL_WINDOW > 1)
-    float maf_buffer[(EI_CLASSIFIER_SLICES_PER_MODEL_WINDOW >> 1)];
+#if (EI_CLASSIFIER_MAX_SLICES_PER_MODEL_WINDOW > 1)
+    float maf_buffer[(EI_CLASSIFIER_MAX_SLICES_PER_MODEL_WINDOW >> 1)];
 #else
     float maf_buffer[1];
 #endif
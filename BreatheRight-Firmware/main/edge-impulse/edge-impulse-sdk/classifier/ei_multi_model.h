@@ -0,0 +1,77 @@
+/* Edge Impulse inferencing library
+ * Copyright (c) 2021 EdgeImpulse Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _EDGE_IMPULSE_MULTI_MODEL_H_
+#define _EDGE_IMPULSE_MULTI_MODEL_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "ei_classifier_types.h"
+#include "edge-impulse-sdk/tensorflow/lite/c/common.h"
+
+// Labels a model run by run_classifier_continuous_multi may have
+#ifndef EI_MULTI_MODEL_MAX_LABELS
+#define EI_MULTI_MODEL_MAX_LABELS   8
+#endif // EI_MULTI_MODEL_MAX_LABELS
+
+/**
+ * An EON compiled model, as generated into tflite-model/<prefix>_compiled.cpp.
+ * Several of these share one feature window, see run_classifier_continuous_multi.
+ */
+typedef struct {
+    const char *name;
+    const char **labels;
+    size_t label_count;
+    // MFCC config the model was trained with, NULL for the one of the impulse
+    const ei_dsp_config_mfcc_t *dsp_config;
+    TfLiteStatus (*init)(void *(*alloc_fnc)(size_t, size_t));
+    TfLiteTensor *(*input)(int index);
+    TfLiteTensor *(*output)(int index);
+    TfLiteStatus (*invoke)(void);
+    TfLiteStatus (*reset)(void (*free_fnc)(void *ptr));
+} ei_compiled_model_t;
+
+/**
+ * Descriptor of the EON model generated with the given function prefix, e.g.
+ * EI_COMPILED_MODEL(wheeze_model, wheeze_categories, &wheeze_dsp_config)
+ */
+#define EI_COMPILED_MODEL(prefix, model_labels, model_dsp_config) \
+    { #prefix, model_labels, sizeof(model_labels) / sizeof(model_labels[0]), model_dsp_config, \
+      prefix##_init, prefix##_input, prefix##_output, prefix##_invoke, prefix##_reset }
+
+/**
+ * State and result of one model in run_classifier_continuous_multi
+ */
+typedef struct {
+    const ei_compiled_model_t *model;
+    bool resident;                  // arena allocated and model prepared
+    bool ran;                       // classification holds the result of the last window
+    ei_impulse_result_classification_t classification[EI_MULTI_MODEL_MAX_LABELS];
+    ei_impulse_maf maf[EI_MULTI_MODEL_MAX_LABELS];
+    // Totals since run_classifier_multi_init, in microseconds
+    uint32_t runs;
+    uint64_t input_us;              // quantization into the input tensor
+    uint64_t invoke_us;
+    uint64_t output_us;             // output tensor to scores, moving average filter
+} ei_model_slot_t;
+
+#endif // _EDGE_IMPULSE_MULTI_MODEL_H_
@@ -30,12 +30,14 @@
 #endif
 #include "ei_run_dsp.h"
 #include "ei_classifier_types.h"
+#include "ei_multi_model.h"
 #include "ei_classifier_smooth.h"
 #include "ei_signal_with_axes.h"
 #if defined(EI_CLASSIFIER_HAS_SAMPLER) && EI_CLASSIFIER_HAS_SAMPLER == 1
 #include "ei_sampler.h"
 #endif
 #include "edge-impulse-sdk/porting/ei_classifier_porting.h"
+#include "edge-impulse-sdk/dsp/stage_clock.hpp"
 #include "model-parameters/dsp_blocks.h"
 
 #if (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE) && (EI_CLASSIFIER_COMPILED != 1)
@@ -102,6 +104,20 @@ EiTrt* ei_trt_handle = NULL;
 #error "Unknown inferencing engine"
 #endif
 
+#if EI_CLASSIFIER_PERSISTENT_MODEL == 1 && \
+    ((EI_CLASSIFIER_INFERENCING_ENGINE != EI_CLASSIFIER_TFLITE) || (EI_CLASSIFIER_COMPILED != 1))
+#error "EI_CLASSIFIER_PERSISTENT_MODEL requires an EON compiled TFLite model"
+#endif
+
+// The fused path writes into the input tensor, which only exists between
+// inferences when the model is resident
+#if (EI_CLASSIFIER_FUSED_INPUT_QUANTIZATION == 1) && (EI_CLASSIFIER_PERSISTENT_MODEL == 1) && \
+    (EI_CLASSIFIER_TFLITE_INPUT_QUANTIZED == 1) && (EI_CLASSIFIER_OBJECT_DETECTION != 1)
+#define EI_CLASSIFIER_CONTINUOUS_FUSED_INPUT    1
+#else
+#define EI_CLASSIFIER_CONTINUOUS_FUSED_INPUT    0
+#endif
+
 #if ECM3532
 void*   __dso_handle = (void*) &__dso_handle;
 #endif
@@ -114,9 +130,12 @@ namespace {
 extern "C" EI_IMPULSE_ERROR run_inference(ei::matrix_t *fmatrix, ei_impulse_result_t *result, bool debug);
 extern "C" EI_IMPULSE_ERROR run_classifier_image_quantized(signal_t *signal, ei_impulse_result_t *result, bool debug);
 static EI_IMPULSE_ERROR can_run_classifier_image_quantized();
-static void calc_cepstral_mean_and_var_normalization_mfcc(ei_matrix *matrix, void *config_ptr);
+static void calc_cepstral_mean_and_var_normalization_mfcc(ei_matrix *matrix, ei_matrix *out_matrix, void *config_ptr);
 static void calc_cepstral_mean_and_var_normalization_mfe(ei_matrix *matrix, void *config_ptr);
 static void calc_cepstral_mean_and_var_normalization_spectrogram(ei_matrix *matrix, void *config_ptr);
+#if EI_CLASSIFIER_CONTINUOUS_FUSED_INPUT == 1
+static EI_IMPULSE_ERROR run_inference_fused_mfcc(ei::matrix_t *features_matrix, ei_impulse_result_t *result, bool debug);
+#endif
 
 /* Private variables ------------------------------------------------------- */
 #if EI_CLASSIFIER_LABEL_COUNT > 0
@@ -127,12 +146,56 @@ ei_impulse_maf classifier_maf[0];
 
 static uint64_t classifier_continuous_features_written = 0;
 
+#if EI_CLASSIFIER_SLICES_PER_MODEL_WINDOW > EI_CLASSIFIER_MAX_SLICES_PER_MODEL_WINDOW
+#error "EI_CLASSIFIER_SLICES_PER_MODEL_WINDOW is larger than EI_CLASSIFIER_MAX_SLICES_PER_MODEL_WINDOW"
+#endif
+
+static size_t classifier_slices_per_model_window = EI_CLASSIFIER_SLICES_PER_MODEL_WINDOW;
+
+#if EI_CLASSIFIER_PERSISTENT_MODEL == 1
+static bool classifier_model_resident = false;
+#endif
+
 /* Private functions ------------------------------------------------------- */
 
+#if EI_CLASSIFIER_PERSISTENT_MODEL == 1
+/**
+ * @brief      Allocate the tensor arena and prepare the compiled model, once.
+ *             Later calls return immediately until the model is torn down.
+ *
+ * @return     EI_IMPULSE_OK if the model is resident
+ */
+static EI_IMPULSE_ERROR persistent_model_init(void)
+{
+    if (classifier_model_resident) {
+        return EI_IMPULSE_OK;
+    }
+
+    TfLiteStatus init_status = trained_model_init(ei_aligned_malloc);
+    if (init_status != kTfLiteOk) {
+        ei_printf("Failed to allocate TFLite arena (error code %d)\n", init_status);
+        return EI_IMPULSE_TFLITE_ARENA_ALLOC_FAILED;
+    }
+
+    classifier_model_resident = true;
+    return EI_IMPULSE_OK;
+}
+#endif // EI_CLASSIFIER_PERSISTENT_MODEL == 1
+
+/**
+ * @brief      Length of the moving average filter for the current number of
+ *             slices per model window
+ */
+static inline size_t moving_average_filter_length(void)
+{
+    size_t length = classifier_slices_per_model_window >> 1;
+    return length > 0 ? length : 1;
+}
+
 /**
  * @brief      Run a moving average filter over the classification result.
  *             The size of the filter determines the response of the filter.
- *             It is now set to the number of slices per window.
+ *             It is now set to half the number of slices per window.
  * @param      maf             Pointer to maf object
  * @param[in]  classification  Classification output on current slice
  *
@@ -140,19 +203,17 @@ static uint64_t classifier_continuous_features_written = 0;
  */
 extern "C" float run_moving_average_filter(ei_impulse_maf *maf, float classification)
 {
+    const size_t length = moving_average_filter_length();
+
     maf->running_sum -= maf->maf_buffer[maf->buf_idx];
     maf->running_sum += classification;
     maf->maf_buffer[maf->buf_idx] = classification;
 
-    if (++maf->buf_idx >= (EI_CLASSIFIER_SLICES_PER_MODEL_WINDOW >> 1)) {
+    if (++maf->buf_idx >= length) {
         maf->buf_idx = 0;
     }
 
-#if (EI_CLASSIFIER_SLICES_PER_MODEL_WINDOW > 1)
-    return maf->running_sum / (float)(EI_CLASSIFIER_SLICES_PER_MODEL_WINDOW >> 1);
-#else
-    return maf->running_sum;
-#endif
+    return maf->running_sum / (float)length;
 }
 
 /**
@@ -163,12 +224,43 @@ extern "C" float run_moving_average_filter(ei_impulse_maf *maf, float classifica
 static void clear_moving_average_filter(ei_impulse_maf *maf)
 {
     maf->running_sum = 0;
+    maf->buf_idx = 0;
 
-    for (int i = 0; i < (EI_CLASSIFIER_SLICES_PER_MODEL_WINDOW >> 1); i++) {
+    for (size_t i = 0; i < sizeof(maf->maf_buffer) / sizeof(maf->maf_buffer[0]); i++) {
         maf->maf_buffer[i] = 0.f;
     }
 }
 
+/**
+ * @brief      Change the number of slices per model window of the continuous
+ *             classifier, i.e. the hop between inferences, and the length of
+ *             the moving average filter with it. The slices passed to
+ *             run_classifier_continuous must be EI_CLASSIFIER_RAW_SAMPLE_COUNT
+ *             divided by this. Takes effect with the next run_classifier_init,
+ *             which also clears the feature window and the filters.
+ *
+ * @param[in]  slices  1 to EI_CLASSIFIER_MAX_SLICES_PER_MODEL_WINDOW
+ *
+ * @return     false if out of range
+ */
+extern "C" bool run_classifier_set_slices_per_model_window(size_t slices)
+{
+    if (slices < 1 || slices > EI_CLASSIFIER_MAX_SLICES_PER_MODEL_WINDOW) {
+        return false;
+    }
+
+    classifier_slices_per_model_window = slices;
+    return true;
+}
+
+/**
+ * @brief      Current number of slices per model window
+ */
+extern "C" size_t run_classifier_slices_per_model_window(void)
+{
+    return classifier_slices_per_model_window;
+}
+
 /**
  * @brief      Init static vars
  */
@@ -180,35 +272,186 @@ extern "C" void run_classifier_init(void)
     for (size_t ix = 0; ix < EI_CLASSIFIER_LABEL_COUNT; ix++) {
         clear_moving_average_filter(&classifier_maf[ix]);
     }
+
+#if EI_CLASSIFIER_PERSISTENT_MODEL == 1
+    // On failure the first inference retries (and reports the error)
+    persistent_model_init();
+#endif
 }
 
 /**
- * @brief      Fill the complete matrix with sample slices. From there, run inference
- *             on the matrix.
- *
- * @param      signal  Sample data
- * @param      result  Classification output
- * @param[in]  debug   Debug output enable boot
- * @param      enable_maf Enables the moving average filter
+ * @brief      Release the resident model (tensor arena and kernel buffers)
+ *             and the cached FFT plans of the DSP.
+ *             The next inference, or run_classifier_init, sets them up again.
+ *             The model is only resident with EI_CLASSIFIER_PERSISTENT_MODEL.
+ */
+extern "C" void run_classifier_deinit(void)
+{
+#if EI_CLASSIFIER_PERSISTENT_MODEL == 1
+    if (classifier_model_resident) {
+        trained_model_reset(ei_aligned_free);
+        classifier_model_resident = false;
+    }
+#endif
+
+    ei::numpy::release_fft_plans();
+}
+
+/**
+ * @brief      Features of the current model window, shared by the float and
+ *             int16 continuous classifiers
  *
- * @return     The ei impulse error.
+ * @return     The matrix, or a matrix without buffer if allocation failed
  */
-extern "C" EI_IMPULSE_ERROR run_classifier_continuous(signal_t *signal, ei_impulse_result_t *result,
-                                                      bool debug = false, bool enable_maf = true)
+static ei::matrix_t *continuous_features_matrix(void)
 {
     static ei::matrix_t static_features_matrix(1, EI_CLASSIFIER_NN_INPUT_FRAME_SIZE);
-    if (!static_features_matrix.buffer) {
-        return EI_IMPULSE_ALLOC_FAILED;
+    return &static_features_matrix;
+}
+
+/**
+ * @brief      Normalized copy of the features that is handed to the network
+ *
+ * @return     The matrix, or a matrix without buffer if allocation failed
+ */
+static ei::matrix_t *continuous_classify_matrix(void)
+{
+    static ei::matrix_t static_classify_matrix(1, EI_CLASSIFIER_NN_INPUT_FRAME_SIZE);
+    return &static_classify_matrix;
+}
+
+/**
+ * @brief      Normalize the features of a complete model window into the
+ *             classify matrix
+ *
+ * @param      features_matrix  Features of the model window
+ * @param[in]  is_mfcc          Features come from an MFCC block
+ * @param[in]  is_mfe           Features come from an MFE block
+ * @param[in]  is_spectrogram   Features come from a spectrogram block
+ *
+ * @return     The classify matrix, NULL if allocation failed
+ */
+static ei::matrix_t *continuous_normalize(ei::matrix_t *features_matrix, bool is_mfcc, bool is_mfe,
+                                          bool is_spectrogram)
+{
+    ei::stage_clock clock;
+    ei::matrix_t *classify_matrix = continuous_classify_matrix();
+    if (!classify_matrix->buffer) {
+        return NULL;
     }
 
+    if (is_mfcc) {
+        /* Normalizes straight from the features into the classify matrix */
+        calc_cepstral_mean_and_var_normalization_mfcc(features_matrix, classify_matrix, ei_dsp_blocks[0].config);
+    }
+    else {
+        /* Create a copy of the matrix for normalization */
+        for (size_t m_ix = 0; m_ix < EI_CLASSIFIER_NN_INPUT_FRAME_SIZE; m_ix++) {
+            classify_matrix->buffer[m_ix] = features_matrix->buffer[m_ix];
+        }
+
+        if (is_spectrogram) {
+            calc_cepstral_mean_and_var_normalization_spectrogram(classify_matrix, ei_dsp_blocks[0].config);
+        }
+        else if (is_mfe) {
+            calc_cepstral_mean_and_var_normalization_mfe(classify_matrix, ei_dsp_blocks[0].config);
+        }
+    }
+    clock.mark(EI_STAGE_CMVN);
+
+    return classify_matrix;
+}
+
+/**
+ * @brief      Normalize the features of a complete model window and run inference
+ *             on them, followed by the moving average filter.
+ *
+ * @param      features_matrix  Features of the model window
+ * @param      result           Classification output
+ * @param[in]  debug            Debug output enable boot
+ * @param[in]  enable_maf       Enables the moving average filter
+ * @param[in]  dsp_start_ms     Start of the DSP stage
+ * @param[in]  is_mfcc          Features come from an MFCC block
+ * @param[in]  is_mfe           Features come from an MFE block
+ * @param[in]  is_spectrogram   Features come from a spectrogram block
+ *
+ * @return     The ei impulse error.
+ */
+static EI_IMPULSE_ERROR run_classifier_continuous_window(ei::matrix_t *features_matrix, ei_impulse_result_t *result,
+                                                         bool debug, bool enable_maf, uint64_t dsp_start_ms,
+                                                         bool is_mfcc, bool is_mfe, bool is_spectrogram)
+{
     EI_IMPULSE_ERROR ei_impulse_error = EI_IMPULSE_OK;
 
-    uint64_t dsp_start_ms = ei_read_timer_ms();
+    result->timing.dsp = ei_read_timer_ms() - dsp_start_ms;
+
+    if (debug) {
+        ei_printf("\r\nFeatures (%d ms.): ", result->timing.dsp);
+        for (size_t ix = 0; ix < features_matrix->cols; ix++) {
+            ei_printf_float(features_matrix->buffer[ix]);
+            ei_printf(" ");
+        }
+        ei_printf("\n");
+    }
+
+    if (classifier_continuous_features_written >= EI_CLASSIFIER_NN_INPUT_FRAME_SIZE) {
+#if EI_CLASSIFIER_INFERENCING_ENGINE != EI_CLASSIFIER_NONE
+        if (debug) {
+            ei_printf("Running neural network...\n");
+        }
+#endif
+
+#if EI_CLASSIFIER_CONTINUOUS_FUSED_INPUT == 1
+        if (is_mfcc) {
+            ei_impulse_error = run_inference_fused_mfcc(features_matrix, result, debug);
+        }
+        else
+#endif
+        {
+            dsp_start_ms = ei_read_timer_ms();
+            ei::matrix_t *classify_matrix = continuous_normalize(features_matrix, is_mfcc, is_mfe, is_spectrogram);
+            if (!classify_matrix) {
+                return EI_IMPULSE_ALLOC_FAILED;
+            }
+            result->timing.dsp += ei_read_timer_ms() - dsp_start_ms;
+
+            ei_impulse_error = run_inference(classify_matrix, result, debug);
+        }
+
+        // run_inference charges its own stages
+        ei::stage_clock clock;
+        if (enable_maf) {
+            for (size_t ix = 0; ix < EI_CLASSIFIER_LABEL_COUNT; ix++) {
+    #if EI_CLASSIFIER_OBJECT_DETECTION != 1
+                result->classification[ix].value =
+                    run_moving_average_filter(&classifier_maf[ix], result->classification[ix].value);
+    #endif
+            }
+        }
+        clock.mark(EI_STAGE_POSTPROCESS);
+    }
+    return ei_impulse_error;
+}
+
+/**
+ * @brief      Run the DSP blocks on one slice and append the features to the
+ *             features of the model window
+ *
+ * @param      signal          Sample data
+ * @param[out] is_mfcc         Set when the features come from an MFCC block
+ * @param[out] is_mfe          Set when the features come from an MFE block
+ * @param[out] is_spectrogram  Set when the features come from a spectrogram block
+ *
+ * @return     The ei impulse error.
+ */
+static EI_IMPULSE_ERROR continuous_extract(signal_t *signal, bool *is_mfcc, bool *is_mfe, bool *is_spectrogram)
+{
+    ei::matrix_t *static_features_matrix = continuous_features_matrix();
+    if (!static_features_matrix->buffer) {
+        return EI_IMPULSE_ALLOC_FAILED;
+    }
 
     size_t out_features_index = 0;
-    bool is_mfcc = false;
-    bool is_mfe = false;
-    bool is_spectrogram = false;
 
     for (size_t ix = 0; ix < ei_dsp_blocks_size; ix++) {
         ei_model_dsp_t block = ei_dsp_blocks[ix];
@@ -219,22 +462,22 @@ extern "C" EI_IMPULSE_ERROR run_classifier_continuous(signal_t *signal, ei_impul
         }
 
         ei::matrix_t fm(1, block.n_output_features,
-                        static_features_matrix.buffer + out_features_index);
+                        static_features_matrix->buffer + out_features_index);
 
         int (*extract_fn_slice)(ei::signal_t *signal, ei::matrix_t *output_matrix, void *config, const float frequency, matrix_size_t *out_matrix_size);
 
         /* Switch to the slice version of the mfcc feature extract function */
         if (block.extract_fn == extract_mfcc_features) {
             extract_fn_slice = &extract_mfcc_per_slice_features;
-            is_mfcc = true;
+            *is_mfcc = true;
         }
         else if (block.extract_fn == extract_spectrogram_features) {
             extract_fn_slice = &extract_spectrogram_per_slice_features;
-            is_spectrogram = true;
+            *is_spectrogram = true;
         }
         else if (block.extract_fn == extract_mfe_features) {
             extract_fn_slice = &extract_mfe_per_slice_features;
-            is_mfe = true;
+            *is_mfe = true;
         }
         else {
             ei_printf("ERR: Unknown extract function, only MFCC, MFE and spectrogram supported\n");
@@ -268,56 +511,520 @@ extern "C" EI_IMPULSE_ERROR run_classifier_continuous(signal_t *signal, ei_impul
         out_features_index += block.n_output_features;
     }
 
-    result->timing.dsp = ei_read_timer_ms() - dsp_start_ms;
+    return EI_IMPULSE_OK;
+}
 
-    if (debug) {
-        ei_printf("\r\nFeatures (%d ms.): ", result->timing.dsp);
-        for (size_t ix = 0; ix < static_features_matrix.cols; ix++) {
-            ei_printf_float(static_features_matrix.buffer[ix]);
-            ei_printf(" ");
-        }
-        ei_printf("\n");
+/**
+ * @brief      Same as continuous_extract, for raw int16 audio. Only single
+ *             axis MFCC blocks are supported.
+ *
+ * @param      signal  Sample data
+ *
+ * @return     The ei impulse error.
+ */
+static EI_IMPULSE_ERROR continuous_extract_i16(signal_i16_t *signal)
+{
+    ei::matrix_t *static_features_matrix = continuous_features_matrix();
+    if (!static_features_matrix->buffer) {
+        return EI_IMPULSE_ALLOC_FAILED;
     }
 
-    if (classifier_continuous_features_written >= EI_CLASSIFIER_NN_INPUT_FRAME_SIZE) {
-        dsp_start_ms = ei_read_timer_ms();
-        ei::matrix_t classify_matrix(1, EI_CLASSIFIER_NN_INPUT_FRAME_SIZE);
+    size_t out_features_index = 0;
 
-        /* Create a copy of the matrix for normalization */
-        for (size_t m_ix = 0; m_ix < EI_CLASSIFIER_NN_INPUT_FRAME_SIZE; m_ix++) {
-            classify_matrix.buffer[m_ix] = static_features_matrix.buffer[m_ix];
+    for (size_t ix = 0; ix < ei_dsp_blocks_size; ix++) {
+        ei_model_dsp_t block = ei_dsp_blocks[ix];
+
+        if (out_features_index + block.n_output_features > EI_CLASSIFIER_NN_INPUT_FRAME_SIZE) {
+            ei_printf("ERR: Would write outside feature buffer\n");
+            return EI_IMPULSE_DSP_ERROR;
         }
 
-        if (is_mfcc) {
-            calc_cepstral_mean_and_var_normalization_mfcc(&classify_matrix, ei_dsp_blocks[0].config);
+        if (block.extract_fn != extract_mfcc_features || block.axes_size != 1) {
+            ei_printf("ERR: Unknown extract function, only single axis MFCC supported for int16 signals\n");
+            return EI_IMPULSE_DSP_ERROR;
         }
-        else if (is_spectrogram) {
-            calc_cepstral_mean_and_var_normalization_spectrogram(&classify_matrix, ei_dsp_blocks[0].config);
+
+        ei::matrix_t fm(1, block.n_output_features,
+                        static_features_matrix->buffer + out_features_index);
+
+        matrix_size_t features_written;
+
+        int ret = extract_mfcc_per_slice_features_i16(signal, &fm, block.config, EI_CLASSIFIER_FREQUENCY, &features_written);
+        if (ret != EIDSP_OK) {
+            ei_printf("ERR: Failed to run DSP process (%d)\n", ret);
+            return EI_IMPULSE_DSP_ERROR;
         }
-        else if (is_mfe) {
-            calc_cepstral_mean_and_var_normalization_mfe(&classify_matrix, ei_dsp_blocks[0].config);
+
+        if (ei_run_impulse_check_canceled() == EI_IMPULSE_CANCELED) {
+            return EI_IMPULSE_CANCELED;
         }
-        result->timing.dsp += ei_read_timer_ms() - dsp_start_ms;
 
-#if EI_CLASSIFIER_INFERENCING_ENGINE != EI_CLASSIFIER_NONE
-        if (debug) {
-            ei_printf("Running neural network...\n");
+        classifier_continuous_features_written += (features_written.rows * features_written.cols);
+
+        out_features_index += block.n_output_features;
+    }
+
+    return EI_IMPULSE_OK;
+}
+
+/**
+ * @brief      Fill the complete matrix with sample slices. From there, run inference
+ *             on the matrix.
+ *
+ * @param      signal  Sample data
+ * @param      result  Classification output
+ * @param[in]  debug   Debug output enable boot
+ * @param      enable_maf Enables the moving average filter
+ *
+ * @return     The ei impulse error.
+ */
+extern "C" EI_IMPULSE_ERROR run_classifier_continuous(signal_t *signal, ei_impulse_result_t *result,
+                                                      bool debug = false, bool enable_maf = true)
+{
+    uint64_t dsp_start_ms = ei_read_timer_ms();
+
+    bool is_mfcc = false;
+    bool is_mfe = false;
+    bool is_spectrogram = false;
+
+    EI_IMPULSE_ERROR res = continuous_extract(signal, &is_mfcc, &is_mfe, &is_spectrogram);
+    if (res != EI_IMPULSE_OK) {
+        return res;
+    }
+
+    return run_classifier_continuous_window(continuous_features_matrix(), result, debug, enable_maf, dsp_start_ms,
+                                            is_mfcc, is_mfe, is_spectrogram);
+}
+
+/**
+ * @brief      Same as run_classifier_continuous, but for raw int16 audio. The
+ *             slice stays int16 until the FFT input, so there is no float copy
+ *             of the slice nor a separate preemphasis pass. Only single axis
+ *             MFCC blocks are supported.
+ *
+ * @param      signal  Sample data
+ * @param      result  Classification output
+ * @param[in]  debug   Debug output enable boot
+ * @param      enable_maf Enables the moving average filter
+ *
+ * @return     The ei impulse error.
+ */
+extern "C" EI_IMPULSE_ERROR run_classifier_continuous_i16(signal_i16_t *signal, ei_impulse_result_t *result,
+                                                          bool debug = false, bool enable_maf = true)
+{
+    uint64_t dsp_start_ms = ei_read_timer_ms();
+
+    EI_IMPULSE_ERROR res = continuous_extract_i16(signal);
+    if (res != EI_IMPULSE_OK) {
+        return res;
+    }
+
+    return run_classifier_continuous_window(continuous_features_matrix(), result, debug, enable_maf, dsp_start_ms,
+                                            true, false, false);
+}
+
+#if (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE) && (EI_CLASSIFIER_COMPILED == 1) && \
+    (EI_CLASSIFIER_OBJECT_DETECTION != 1)
+
+/**
+ * The EON model of the impulse, to run next to other models on the same
+ * features with run_classifier_continuous_multi
+ */
+__attribute__((unused)) static const ei_compiled_model_t ei_impulse_compiled_model =
+    EI_COMPILED_MODEL(trained_model, ei_classifier_inferencing_categories, NULL);
+
+/**
+ * @brief      Check that a model can be fed the features of the impulse
+ *
+ * @param      model  The model
+ *
+ * @return     The ei impulse error.
+ */
+static EI_IMPULSE_ERROR compiled_model_check_config(const ei_compiled_model_t *model)
+{
+    if (ei_dsp_blocks_size != 1 || ei_dsp_blocks[0].extract_fn != extract_mfcc_features) {
+        ei_printf("ERR: Multi model inference needs an impulse with a single MFCC block\n");
+        return EI_IMPULSE_DSP_ERROR;
+    }
+
+    const ei_dsp_config_mfcc_t *impulse = (const ei_dsp_config_mfcc_t *)ei_dsp_blocks[0].config;
+    const ei_dsp_config_mfcc_t *config = model->dsp_config;
+    if (config && (config->implementation_version != impulse->implementation_version ||
+                   config->axes != impulse->axes ||
+                   config->num_cepstral != impulse->num_cepstral ||
+                   config->frame_length != impulse->frame_length ||
+                   config->frame_stride != impulse->frame_stride ||
+                   config->num_filters != impulse->num_filters ||
+                   config->fft_length != impulse->fft_length ||
+                   config->win_size != impulse->win_size ||
+                   config->low_frequency != impulse->low_frequency ||
+                   config->high_frequency != impulse->high_frequency ||
+                   config->pre_cof != impulse->pre_cof ||
+                   config->pre_shift != impulse->pre_shift)) {
+        ei_printf("ERR: %s was trained with other MFCC parameters than the impulse\n", model->name);
+        return EI_IMPULSE_DSP_ERROR;
+    }
+
+    if (model->label_count > EI_MULTI_MODEL_MAX_LABELS) {
+        ei_printf("ERR: %s has %d labels, at most %d are supported\n", model->name,
+            (int)model->label_count, EI_MULTI_MODEL_MAX_LABELS);
+        return EI_IMPULSE_ERROR_SHAPES_DONT_MATCH;
+    }
+
+    return EI_IMPULSE_OK;
+}
+
+/**
+ * @brief      Number of elements of a tensor
+ */
+static size_t compiled_model_tensor_size(const TfLiteTensor *tensor)
+{
+    size_t size = 1;
+    for (int ix = 0; ix < tensor->dims->size; ix++) {
+        size *= tensor->dims->data[ix];
+    }
+    return size;
+}
+
+/**
+ * @brief      Check that the tensors of a prepared model match the features
+ *             of the impulse and the labels of the model
+ *
+ * @param      model  The model
+ *
+ * @return     The ei impulse error.
+ */
+static EI_IMPULSE_ERROR compiled_model_check_tensors(const ei_compiled_model_t *model)
+{
+    TfLiteTensor *input = model->input(0);
+    TfLiteTensor *output = model->output(0);
+    if (!input) {
+        return EI_IMPULSE_INPUT_TENSOR_WAS_NULL;
+    }
+    if (!output) {
+        return EI_IMPULSE_OUTPUT_TENSOR_WAS_NULL;
+    }
+
+    if ((input->type != kTfLiteInt8 && input->type != kTfLiteFloat32) ||
+        (output->type != kTfLiteInt8 && output->type != kTfLiteFloat32)) {
+        ei_printf("ERR: %s must have int8 or float32 input and output tensors\n", model->name);
+        return EI_IMPULSE_ERROR_SHAPES_DONT_MATCH;
+    }
+
+    if (compiled_model_tensor_size(input) != EI_CLASSIFIER_NN_INPUT_FRAME_SIZE ||
+        compiled_model_tensor_size(output) != model->label_count) {
+        ei_printf("ERR: %s expects %d features and %d labels, the impulse has %d features\n", model->name,
+            (int)compiled_model_tensor_size(input), (int)compiled_model_tensor_size(output),
+            EI_CLASSIFIER_NN_INPUT_FRAME_SIZE);
+        return EI_IMPULSE_ERROR_SHAPES_DONT_MATCH;
+    }
+
+    return EI_IMPULSE_OK;
+}
+
+/**
+ * @brief      Release the arena of a model, if it has one
+ */
+static void compiled_model_reset(ei_model_slot_t *slot)
+{
+    if (!slot->resident) {
+        return;
+    }
+
+#if EI_CLASSIFIER_PERSISTENT_MODEL == 1
+    if (slot->model->init == trained_model_init) {
+        // The impulse model is shared with run_classifier
+        if (classifier_model_resident) {
+            trained_model_reset(ei_aligned_free);
+            classifier_model_resident = false;
         }
+    }
+    else
+#endif
+    {
+        slot->model->reset(ei_aligned_free);
+    }
+    slot->resident = false;
+}
+
+/**
+ * @brief      Check a model and allocate its arena, once. Later calls return
+ *             immediately until the model is reset.
+ *
+ * @param      slot  Slot of the model
+ *
+ * @return     The ei impulse error.
+ */
+static EI_IMPULSE_ERROR compiled_model_init(ei_model_slot_t *slot)
+{
+    const ei_compiled_model_t *model = slot->model;
+
+#if EI_CLASSIFIER_PERSISTENT_MODEL == 1
+    // run_classifier_deinit releases the impulse model behind our back
+    if (model->init == trained_model_init && !classifier_model_resident) {
+        slot->resident = false;
+    }
 #endif
-        ei_impulse_error = run_inference(&classify_matrix, result, debug);
 
+    if (slot->resident) {
+        return EI_IMPULSE_OK;
+    }
+
+    EI_IMPULSE_ERROR res = compiled_model_check_config(model);
+    if (res != EI_IMPULSE_OK) {
+        return res;
+    }
+
+#if EI_CLASSIFIER_PERSISTENT_MODEL == 1
+    if (model->init == trained_model_init) {
+        res = persistent_model_init();
+    }
+    else
+#endif
+    {
+        TfLiteStatus init_status = model->init(ei_aligned_malloc);
+        if (init_status != kTfLiteOk) {
+            ei_printf("Failed to allocate TFLite arena of %s (error code %d)\n", model->name, init_status);
+            res = EI_IMPULSE_TFLITE_ARENA_ALLOC_FAILED;
+        }
+    }
+    if (res != EI_IMPULSE_OK) {
+        return res;
+    }
+    slot->resident = true;
+
+    res = compiled_model_check_tensors(model);
+    if (res != EI_IMPULSE_OK) {
+        compiled_model_reset(slot);
+    }
+    return res;
+}
+
+/**
+ * @brief      Quantize the normalized features into the input of one model,
+ *             run it and filter its scores into the slot
+ *
+ * @param      slot        Slot of the model
+ * @param      fmatrix     Normalized features
+ * @param[in]  debug       Print the raw scores
+ * @param[in]  enable_maf  Enables the moving average filter
+ *
+ * @return     The ei impulse error.
+ */
+static EI_IMPULSE_ERROR run_compiled_model(ei_model_slot_t *slot, ei::matrix_t *fmatrix, bool debug, bool enable_maf)
+{
+    const ei_compiled_model_t *model = slot->model;
+
+    EI_IMPULSE_ERROR res = compiled_model_init(slot);
+    if (res != EI_IMPULSE_OK) {
+        return res;
+    }
+
+    TfLiteTensor *input = model->input(0);
+    TfLiteTensor *output = model->output(0);
+
+    uint64_t start_us = ei_read_timer_us();
+    ei::stage_clock clock;
+
+    if (input->type == kTfLiteInt8) {
+        // saturating, as the fused path quantizes; one column of features
+        speechpy::processing::quantize_store store(input->data.int8, EI_CLASSIFIER_NN_INPUT_FRAME_SIZE, 1,
+            input->params.scale, input->params.zero_point);
+        for (size_t ix = 0; ix < EI_CLASSIFIER_NN_INPUT_FRAME_SIZE; ix++) {
+            store(static_cast<int>(ix), 0, fmatrix->buffer[ix]);
+        }
+    }
+    else {
+        for (size_t ix = 0; ix < EI_CLASSIFIER_NN_INPUT_FRAME_SIZE; ix++) {
+            input->data.f[ix] = fmatrix->buffer[ix];
+        }
+    }
+    clock.mark(EI_STAGE_CMVN);
+    uint64_t input_us = ei_read_timer_us();
+
+    TfLiteStatus invoke_status = model->invoke();
+    clock.mark(EI_STAGE_INVOKE);
+    uint64_t invoke_us = ei_read_timer_us();
+
+    if (invoke_status != kTfLiteOk) {
+        ei_printf("ERR: Failed to invoke %s (error code %d)\n", model->name, invoke_status);
+        return EI_IMPULSE_TFLITE_ERROR;
+    }
+
+    for (size_t ix = 0; ix < model->label_count; ix++) {
+        float value;
+        if (output->type == kTfLiteInt8) {
+            value = static_cast<float>(output->data.int8[ix] - output->params.zero_point) * output->params.scale;
+        }
+        else {
+            value = output->data.f[ix];
+        }
+        if (debug) {
+            ei_printf("%s %s:\t", model->name, model->labels[ix]);
+            ei_printf_float(value);
+            ei_printf("\n");
+        }
         if (enable_maf) {
-            for (size_t ix = 0; ix < EI_CLASSIFIER_LABEL_COUNT; ix++) {
-    #if EI_CLASSIFIER_OBJECT_DETECTION != 1
-                result->classification[ix].value =
-                    run_moving_average_filter(&classifier_maf[ix], result->classification[ix].value);
-    #endif
-            }
+            value = run_moving_average_filter(&slot->maf[ix], value);
         }
+        slot->classification[ix].label = model->labels[ix];
+        slot->classification[ix].value = value;
     }
-    return ei_impulse_error;
+    clock.mark(EI_STAGE_POSTPROCESS);
+
+    slot->ran = true;
+    slot->runs++;
+    slot->input_us += input_us - start_us;
+    slot->invoke_us += invoke_us - input_us;
+    slot->output_us += ei_read_timer_us() - invoke_us;
+
+    if (ei_run_impulse_check_canceled() == EI_IMPULSE_CANCELED) {
+        return EI_IMPULSE_CANCELED;
+    }
+
+    return EI_IMPULSE_OK;
+}
+
+/**
+ * @brief      Prepare the models of a multi model run: clear their moving
+ *             average filters and allocate the arenas. All models stay
+ *             resident until run_classifier_multi_deinit. The totals of the
+ *             slots are kept.
+ *             Call after run_classifier_init, which clears the shared features.
+ *
+ * @param      slots  One slot per model, with the model set
+ * @param[in]  count  Number of slots
+ *
+ * @return     The first error, the models after a failing one are still set up
+ */
+extern "C" EI_IMPULSE_ERROR run_classifier_multi_init(ei_model_slot_t *slots, size_t count)
+{
+    EI_IMPULSE_ERROR first_error = EI_IMPULSE_OK;
+
+    for (size_t ix = 0; ix < count; ix++) {
+        slots[ix].ran = false;
+        for (size_t label = 0; label < EI_MULTI_MODEL_MAX_LABELS; label++) {
+            clear_moving_average_filter(&slots[ix].maf[label]);
+        }
+
+        EI_IMPULSE_ERROR res = compiled_model_init(&slots[ix]);
+        if (res != EI_IMPULSE_OK && first_error == EI_IMPULSE_OK) {
+            first_error = res;
+        }
+    }
+
+    return first_error;
+}
+
+/**
+ * @brief      Release the arenas of all models
+ */
+extern "C" void run_classifier_multi_deinit(ei_model_slot_t *slots, size_t count)
+{
+    for (size_t ix = 0; ix < count; ix++) {
+        compiled_model_reset(&slots[ix]);
+    }
+}
+
+/**
+ * @brief      Normalize the features of the model window once and run every
+ *             model on them
+ *
+ * @return     The ei impulse error.
+ */
+static EI_IMPULSE_ERROR run_classifier_multi_window(ei_model_slot_t *slots, size_t count, uint32_t *dsp_us,
+                                                    uint64_t dsp_start_us, bool debug, bool enable_maf,
+                                                    bool is_mfcc, bool is_mfe, bool is_spectrogram)
+{
+    for (size_t ix = 0; ix < count; ix++) {
+        slots[ix].ran = false;
+    }
+
+    if (classifier_continuous_features_written < EI_CLASSIFIER_NN_INPUT_FRAME_SIZE) {
+        *dsp_us = ei_read_timer_us() - dsp_start_us;
+        return EI_IMPULSE_OK;
+    }
+
+    ei::matrix_t *classify_matrix = continuous_normalize(continuous_features_matrix(), is_mfcc, is_mfe,
+                                                         is_spectrogram);
+    if (!classify_matrix) {
+        return EI_IMPULSE_ALLOC_FAILED;
+    }
+    *dsp_us = ei_read_timer_us() - dsp_start_us;
+
+    if (debug) {
+        ei_printf("\r\nFeatures (%d us.): ", (int)*dsp_us);
+        for (size_t ix = 0; ix < classify_matrix->cols; ix++) {
+            ei_printf_float(classify_matrix->buffer[ix]);
+            ei_printf(" ");
+        }
+        ei_printf("\n");
+    }
+
+    for (size_t ix = 0; ix < count; ix++) {
+        EI_IMPULSE_ERROR res = run_compiled_model(&slots[ix], classify_matrix, debug, enable_maf);
+        if (res != EI_IMPULSE_OK) {
+            return res;
+        }
+    }
+
+    return EI_IMPULSE_OK;
+}
+
+/**
+ * @brief      Like run_classifier_continuous, but the features of the model
+ *             window are computed and normalized once and handed to several
+ *             EON compiled models. Every model writes its scores into its
+ *             own slot, and adds to the timing totals of the slot.
+ *
+ * @param      signal      Sample data
+ * @param      slots       One slot per model, see run_classifier_multi_init
+ * @param[in]  count       Number of slots
+ * @param[out] dsp_us      Time spent on features and normalization
+ * @param[in]  debug       Debug output enable
+ * @param[in]  enable_maf  Enables the moving average filter
+ *
+ * @return     The ei impulse error. The slots that ran have ran set.
+ */
+extern "C" EI_IMPULSE_ERROR run_classifier_continuous_multi(signal_t *signal, ei_model_slot_t *slots, size_t count,
+                                                            uint32_t *dsp_us, bool debug = false,
+                                                            bool enable_maf = true)
+{
+    uint64_t dsp_start_us = ei_read_timer_us();
+
+    bool is_mfcc = false;
+    bool is_mfe = false;
+    bool is_spectrogram = false;
+
+    EI_IMPULSE_ERROR res = continuous_extract(signal, &is_mfcc, &is_mfe, &is_spectrogram);
+    if (res != EI_IMPULSE_OK) {
+        return res;
+    }
+
+    return run_classifier_multi_window(slots, count, dsp_us, dsp_start_us, debug, enable_maf,
+                                       is_mfcc, is_mfe, is_spectrogram);
 }
 
+/**
+ * @brief      Same as run_classifier_continuous_multi, for raw int16 audio
+ */
+extern "C" EI_IMPULSE_ERROR run_classifier_continuous_multi_i16(signal_i16_t *signal, ei_model_slot_t *slots,
+                                                                size_t count, uint32_t *dsp_us, bool debug = false,
+                                                                bool enable_maf = true)
+{
+    uint64_t dsp_start_us = ei_read_timer_us();
+
+    EI_IMPULSE_ERROR res = continuous_extract_i16(signal);
+    if (res != EI_IMPULSE_OK) {
+        return res;
+    }
+
+    return run_classifier_multi_window(slots, count, dsp_us, dsp_start_us, debug, enable_maf,
+                                       true, false, false);
+}
+
+#endif // EON compiled TFLite classifier
+
 #if EI_CLASSIFIER_OBJECT_DETECTION
 
 /**
@@ -431,7 +1138,12 @@ static EI_IMPULSE_ERROR inference_tflite_setup(uint64_t *ctx_start_ms, TfLiteTen
     tflite::MicroInterpreter** micro_interpreter,
 #endif
     uint8_t** micro_tensor_arena) {
-#if (EI_CLASSIFIER_COMPILED == 1)
+#if (EI_CLASSIFIER_COMPILED == 1) && (EI_CLASSIFIER_PERSISTENT_MODEL == 1)
+    EI_IMPULSE_ERROR init_res = persistent_model_init();
+    if (init_res != EI_IMPULSE_OK) {
+        return init_res;
+    }
+#elif (EI_CLASSIFIER_COMPILED == 1)
     TfLiteStatus init_status = trained_model_init(ei_aligned_malloc);
     if (init_status != kTfLiteOk) {
         ei_printf("Failed to allocate TFLite arena (error code %d)\n", init_status);
@@ -565,6 +1277,7 @@ static EI_IMPULSE_ERROR inference_tflite_run(uint64_t ctx_start_ms,
     uint8_t* tensor_arena,
     ei_impulse_result_t *result,
     bool debug) {
+    ei::stage_clock clock;
 #if (EI_CLASSIFIER_COMPILED == 1)
     trained_model_invoke();
 #else
@@ -577,6 +1290,7 @@ static EI_IMPULSE_ERROR inference_tflite_run(uint64_t ctx_start_ms,
     }
     delete interpreter;
 #endif
+    clock.mark(EI_STAGE_INVOKE);
 
     uint64_t ctx_end_ms = ei_read_timer_ms();
 
@@ -598,8 +1312,11 @@ static EI_IMPULSE_ERROR inference_tflite_run(uint64_t ctx_start_ms,
         fill_result_struct_f32(result, output->data.f, debug);
     }
 #endif
+    clock.mark(EI_STAGE_POSTPROCESS);
 
-#if (EI_CLASSIFIER_COMPILED == 1)
+#if (EI_CLASSIFIER_COMPILED == 1) && (EI_CLASSIFIER_PERSISTENT_MODEL == 1)
+    // the model stays resident until run_classifier_deinit()
+#elif (EI_CLASSIFIER_COMPILED == 1)
     trained_model_reset(ei_aligned_free);
 #else
     ei_aligned_free(tensor_arena);
@@ -658,6 +1375,9 @@ extern "C" EI_IMPULSE_ERROR run_inference(
             return init_res;
         }
 
+        // the input copy (and quantization) is charged to the normalization
+        ei::stage_clock clock;
+
         // Place our calculated x value in the model's input tensor
 #if EI_CLASSIFIER_OBJECT_DETECTION
         bool uint8_input = input->type == TfLiteType::kTfLiteUInt8;
@@ -682,6 +1402,7 @@ extern "C" EI_IMPULSE_ERROR run_inference(
             }
         }
 #endif
+        clock.mark(EI_STAGE_CMVN);
 
 #if (EI_CLASSIFIER_COMPILED == 1)
         EI_IMPULSE_ERROR run_res = inference_tflite_run(ctx_start_ms, output,
@@ -933,6 +1654,55 @@ extern "C" EI_IMPULSE_ERROR run_inference(
     return EI_IMPULSE_OK;
 }
 
+#if EI_CLASSIFIER_CONTINUOUS_FUSED_INPUT == 1
+/**
+ * @brief      Normalize the MFCC features of a complete model window straight
+ *             into the int8 input tensor of the resident model and run it.
+ *             Takes the place of continuous_normalize and run_inference: the
+ *             features are quantized as the CMVN produces them, so there is
+ *             no float copy of them and no separate quantization pass.
+ *
+ * @param      features_matrix  Features of the model window
+ * @param      result           Output classifier results
+ * @param[in]  debug            Debug output enable
+ *
+ * @return     The ei impulse error.
+ */
+static EI_IMPULSE_ERROR run_inference_fused_mfcc(ei::matrix_t *features_matrix, ei_impulse_result_t *result, bool debug)
+{
+    EI_IMPULSE_ERROR init_res = persistent_model_init();
+    if (init_res != EI_IMPULSE_OK) {
+        return init_res;
+    }
+
+    TfLiteTensor *input = trained_model_input(0);
+    TfLiteTensor *output = trained_model_output(0);
+    if (input->type != kTfLiteInt8) {
+        return EI_IMPULSE_ERROR_SHAPES_DONT_MATCH;
+    }
+
+    uint64_t cmvn_start_ms = ei_read_timer_ms();
+    ei::stage_clock clock;
+
+    ei_dsp_config_mfcc_t *config = (ei_dsp_config_mfcc_t *)ei_dsp_blocks[0].config;
+
+    /* One row per frame for the normalization */
+    ei::matrix_t frames(EI_CLASSIFIER_NN_INPUT_FRAME_SIZE / config->num_cepstral, config->num_cepstral,
+                        features_matrix->buffer);
+    int ret = speechpy::processing::cmvnw_sliding_i8(&frames, input->data.int8, input->params.scale,
+                                                     input->params.zero_point, config->win_size, true);
+    if (ret != EIDSP_OK) {
+        ei_printf("ERR: cmvnw failed (%d)\n", ret);
+        return EI_IMPULSE_DSP_ERROR;
+    }
+    clock.mark(EI_STAGE_CMVN);
+
+    result->timing.dsp += ei_read_timer_ms() - cmvn_start_ms;
+
+    return inference_tflite_run(ei_read_timer_ms(), output, NULL, result, debug);
+}
+#endif // EI_CLASSIFIER_CONTINUOUS_FUSED_INPUT == 1
+
 extern "C" EI_IMPULSE_ERROR run_inference_i16(
     ei::matrix_i32_t *fmatrix,
     ei_impulse_result_t *result,
@@ -1204,29 +1974,26 @@ extern "C" EI_IMPULSE_ERROR run_classifier_i16(
 /**
  * @brief      Calculates the cepstral mean and variable normalization.
  *
- * @param      matrix      Source and destination matrix
+ * @param      matrix      Source matrix
+ * @param      out_matrix  Destination matrix, same size as the source
  * @param      config_ptr  ei_dsp_config_mfcc_t struct pointer
  */
-static void calc_cepstral_mean_and_var_normalization_mfcc(ei_matrix *matrix, void *config_ptr)
+static void calc_cepstral_mean_and_var_normalization_mfcc(ei_matrix *matrix, ei_matrix *out_matrix, void *config_ptr)
 {
     ei_dsp_config_mfcc_t *config = (ei_dsp_config_mfcc_t *)config_ptr;
 
     uint32_t original_matrix_size = matrix->rows * matrix->cols;
 
-    /* Modify rows and colums ration for matrix normalization */
-    matrix->rows = original_matrix_size / config->num_cepstral;
-    matrix->cols = config->num_cepstral;
+    /* One row per frame for the normalization */
+    ei::matrix_t frames(original_matrix_size / config->num_cepstral, config->num_cepstral, matrix->buffer);
+    ei::matrix_t out_frames(original_matrix_size / config->num_cepstral, config->num_cepstral, out_matrix->buffer);
 
     // cepstral mean and variance normalization
-    int ret = speechpy::processing::cmvnw(matrix, config->win_size, true, false);
+    int ret = speechpy::processing::cmvnw_sliding(&frames, &out_frames, config->win_size, true);
     if (ret != EIDSP_OK) {
         ei_printf("ERR: cmvnw failed (%d)\n", ret);
         return;
     }
-
-    /* Reset rows and columns ratio */
-    matrix->rows = 1;
-    matrix->cols = original_matrix_size;
 }
 
 /**
@@ -51,6 +51,13 @@ static float *ei_dsp_cont_current_frame = nullptr;
 static size_t ei_dsp_cont_current_frame_size = 0;
 static int ei_dsp_cont_current_frame_ix = 0;
 
+// int16 variant for the int16 signal path, [0] holds the sample preceding the frame
+static EIDSP_i16 *ei_dsp_cont_current_frame_i16 = nullptr;
+static size_t ei_dsp_cont_current_frame_i16_size = 0;
+static int ei_dsp_cont_current_frame_i16_ix = 0;
+// last sample of the previous slice, preemphasis carries over slice boundaries
+static EIDSP_i16 ei_dsp_cont_last_sample_i16 = 0;
+
 __attribute__((unused)) int extract_spectral_analysis_features(signal_t *signal, matrix_t *output_matrix, void *config_ptr, const float frequency) {
     ei_dsp_config_spectral_analysis_t config = *((ei_dsp_config_spectral_analysis_t*)config_ptr);
 
@@ -674,6 +681,263 @@ __attribute__((unused)) int extract_mfcc_per_slice_features(signal_t *signal, ma
 #endif
 }
 
+static int ei_dsp_cont_frame_i16_get_data(size_t offset, size_t length, EIDSP_i16 *out_ptr) {
+    memcpy(out_ptr, ei_dsp_cont_current_frame_i16 + 1 + offset, length * sizeof(EIDSP_i16));
+    return EIDSP_OK;
+}
+
+#if EIDSP_MFCC_STATIC == 1 && EIDSP_MFCC_FIXED_POINT == 0 && defined(EI_CLASSIFIER_MFCC_NUM_FILTERS)
+#define EI_DSP_MFCC_STATIC 1
+
+// MFCC with the tables for the model's DSP config generated at compile time
+typedef speechpy::feature_static<EI_CLASSIFIER_FREQUENCY, EI_CLASSIFIER_MFCC_NUM_FILTERS,
+    EI_CLASSIFIER_MFCC_FFT_LENGTH, EI_CLASSIFIER_MFCC_NUM_CEPSTRAL,
+    EI_CLASSIFIER_MFCC_LOW_FREQUENCY, EI_CLASSIFIER_MFCC_HIGH_FREQUENCY> ei_dsp_mfcc_static_t;
+
+/**
+ * Whether a config can use ei_dsp_mfcc_static_t, any other config (e.g. another
+ * DSP block in the impulse) takes the generic path.
+ */
+static bool ei_dsp_mfcc_static_matches(const ei_dsp_config_mfcc_t *config, uint32_t frequency) {
+    return frequency == EI_CLASSIFIER_FREQUENCY &&
+        config->implementation_version == 2 &&
+        config->num_cepstral == EI_CLASSIFIER_MFCC_NUM_CEPSTRAL &&
+        config->num_filters == EI_CLASSIFIER_MFCC_NUM_FILTERS &&
+        config->fft_length == EI_CLASSIFIER_MFCC_FFT_LENGTH &&
+        config->low_frequency == EI_CLASSIFIER_MFCC_LOW_FREQUENCY &&
+        config->high_frequency == EI_CLASSIFIER_MFCC_HIGH_FREQUENCY;
+}
+#else
+#define EI_DSP_MFCC_STATIC 0
+#endif
+
+static int extract_mfcc_run_slice_i16(signal_i16_t *signal, size_t offset, size_t length, EIDSP_i16 prev_sample,
+    matrix_t *output_matrix, ei_dsp_config_mfcc_t *config, const float sampling_frequency, matrix_size_t *matrix_size_out)
+{
+    uint32_t frequency = (uint32_t)sampling_frequency;
+
+    int x;
+
+    // calculate the size of the spectrogram matrix
+    matrix_size_t out_matrix_size =
+        speechpy::feature::calculate_mfcc_buffer_size(
+            length, frequency, config->frame_length, config->frame_stride, config->num_cepstral,
+            config->implementation_version);
+
+    // we roll the output matrix back so we have room at the end...
+    x = numpy::roll(output_matrix->buffer, output_matrix->rows * output_matrix->cols,
+        -(out_matrix_size.rows * out_matrix_size.cols));
+    if (x != EIDSP_OK) {
+        EIDSP_ERR(x);
+    }
+
+    // slice in the output matrix to write to
+    // the offset in the classification matrix here is always at the end
+    size_t output_matrix_offset = (output_matrix->rows * output_matrix->cols) -
+        (out_matrix_size.rows * out_matrix_size.cols);
+
+    matrix_t output_matrix_slice(out_matrix_size.rows, out_matrix_size.cols, output_matrix->buffer + output_matrix_offset);
+
+    // and run the MFCC extraction, preemphasis is applied inside
+#if EI_DSP_MFCC_STATIC
+    if (ei_dsp_mfcc_static_matches(config, frequency)) {
+        x = ei_dsp_mfcc_static_t::mfcc_i16(&output_matrix_slice, signal, offset, length, prev_sample, config->pre_cof,
+            config->frame_length, config->frame_stride, true);
+    }
+    else
+#endif
+    {
+#if EIDSP_MFCC_FIXED_POINT
+        x = speechpy::feature_fixed::mfcc(&output_matrix_slice, signal, offset, length, prev_sample, config->pre_cof,
+#else
+        x = speechpy::feature::mfcc_i16(&output_matrix_slice, signal, offset, length, prev_sample, config->pre_cof,
+#endif
+            frequency, config->frame_length, config->frame_stride, config->num_cepstral, config->num_filters, config->fft_length,
+            config->low_frequency, config->high_frequency, true, config->implementation_version);
+    }
+    if (x != EIDSP_OK) {
+        ei_printf("ERR: MFCC failed (%d)\n", x);
+        EIDSP_ERR(x);
+    }
+
+    matrix_size_out->rows += out_matrix_size.rows;
+    if (out_matrix_size.cols > 0) {
+        matrix_size_out->cols = out_matrix_size.cols;
+    }
+
+    return EIDSP_OK;
+}
+
+/**
+ * Continuous MFCC over an int16 slice. Same framing as `extract_mfcc_per_slice_features`,
+ * but the audio stays int16 until the FFT input and the leftover between slices is kept
+ * as raw samples. Preemphasis runs over the stream, so the first sample of a slice uses
+ * the last sample of the previous slice rather than wrapping around within the slice.
+ * Only implementation version 2 with a preemphasis shift of 1 is supported.
+ */
+__attribute__((unused)) int extract_mfcc_per_slice_features_i16(signal_i16_t *signal, matrix_t *output_matrix, void *config_ptr, const float sampling_frequency, matrix_size_t *matrix_size_out) {
+#if defined(__cplusplus) && EI_C_LINKAGE == 1
+    ei_printf("ERR: Continuous audio is not supported when EI_C_LINKAGE is defined\n");
+    EIDSP_ERR(EIDSP_NOT_SUPPORTED);
+#else
+
+    ei_dsp_config_mfcc_t config = *((ei_dsp_config_mfcc_t*)config_ptr);
+
+    if (config.axes != 1) {
+        EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+    }
+
+    if (config.implementation_version != 2) {
+        EIDSP_ERR(EIDSP_BLOCK_VERSION_INCORRECT);
+    }
+
+    if (config.pre_shift != 1) {
+        ei_printf("ERR: int16 MFCC only supports a preemphasis shift of 1 (%d)\n", config.pre_shift);
+        EIDSP_ERR(EIDSP_NOT_SUPPORTED);
+    }
+
+    if (signal->total_length == 0) {
+        EIDSP_ERR(EIDSP_PARAMETER_INVALID);
+    }
+
+    const uint32_t frequency = static_cast<uint32_t>(sampling_frequency);
+
+    // Go from the time (e.g. 0.25 seconds to number of frames based on freq)
+    const size_t frame_length_values = frequency * config.frame_length;
+    const size_t frame_stride_values = frequency * config.frame_stride;
+    const int frame_overlap_values = static_cast<int>(frame_length_values) - static_cast<int>(frame_stride_values);
+
+    if (frame_overlap_values < 0) {
+        ei_printf("ERR: frame_length (%f) cannot be lower than frame_stride (%f) for continuous classification\n",
+            config.frame_length, config.frame_stride);
+        EIDSP_ERR(EIDSP_PARAMETER_INVALID);
+    }
+
+    if (frame_length_values > signal->total_length) {
+        ei_printf("ERR: frame_length (%d) cannot be larger than signal's total length (%d) for continuous classification\n",
+            (int)frame_length_values, (int)signal->total_length);
+        EIDSP_ERR(EIDSP_PARAMETER_INVALID);
+    }
+
+    int x;
+
+    // have current frame, but wrong size? then free
+    if (ei_dsp_cont_current_frame_i16 && ei_dsp_cont_current_frame_i16_size != frame_length_values) {
+        ei_free(ei_dsp_cont_current_frame_i16);
+        ei_dsp_cont_current_frame_i16 = nullptr;
+    }
+
+    if (!ei_dsp_cont_current_frame_i16) {
+        ei_dsp_cont_current_frame_i16 = (EIDSP_i16*)ei_calloc((frame_length_values + 1) * sizeof(EIDSP_i16), 1);
+        if (!ei_dsp_cont_current_frame_i16) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+        ei_dsp_cont_current_frame_i16_size = frame_length_values;
+        ei_dsp_cont_current_frame_i16_ix = 0;
+    }
+
+    matrix_size_out->rows = 0;
+    matrix_size_out->cols = 0;
+
+    // this is the offset in the signal from which we'll work
+    size_t offset_in_signal = 0;
+
+    if (ei_dsp_cont_current_frame_i16_ix > (int)ei_dsp_cont_current_frame_i16_size) {
+        ei_printf("ERR: ei_dsp_cont_current_frame_i16_ix is larger than frame size\n");
+        EIDSP_ERR(EIDSP_PARAMETER_INVALID);
+    }
+
+    signal_i16_t frame_signal;
+    frame_signal.total_length = frame_length_values;
+    frame_signal.get_data = &ei_dsp_cont_frame_i16_get_data;
+
+    // if we still have some code from previous run
+    while (ei_dsp_cont_current_frame_i16_ix > 0) {
+        // then from the current frame we need to read `frame_length_values - ei_dsp_cont_current_frame_i16_ix`
+        // starting at offset 0
+        x = signal->get_data(0, frame_length_values - ei_dsp_cont_current_frame_i16_ix,
+            ei_dsp_cont_current_frame_i16 + 1 + ei_dsp_cont_current_frame_i16_ix);
+        if (x != EIDSP_OK) {
+            EIDSP_ERR(x);
+        }
+
+        // now ei_dsp_cont_current_frame_i16 is complete
+        x = extract_mfcc_run_slice_i16(&frame_signal, 0, frame_length_values, ei_dsp_cont_current_frame_i16[0],
+            output_matrix, &config, sampling_frequency, matrix_size_out);
+        if (x != EIDSP_OK) {
+            EIDSP_ERR(x);
+        }
+
+        // if there's overlap between frames we roll through, keeping the preceding sample at [0]
+        if (frame_stride_values > 0) {
+            memmove(ei_dsp_cont_current_frame_i16, ei_dsp_cont_current_frame_i16 + frame_stride_values,
+                (frame_length_values + 1 - frame_stride_values) * sizeof(EIDSP_i16));
+        }
+
+        ei_dsp_cont_current_frame_i16_ix -= frame_stride_values;
+    }
+
+    if (ei_dsp_cont_current_frame_i16_ix < 0) {
+        offset_in_signal = -ei_dsp_cont_current_frame_i16_ix;
+        ei_dsp_cont_current_frame_i16_ix = 0;
+    }
+
+    if (offset_in_signal >= signal->total_length) {
+        offset_in_signal -= signal->total_length;
+        return signal->get_data(signal->total_length - 1, 1, &ei_dsp_cont_last_sample_i16);
+    }
+
+    EIDSP_i16 prev_sample = ei_dsp_cont_last_sample_i16;
+    if (offset_in_signal > 0) {
+        x = signal->get_data(offset_in_signal - 1, 1, &prev_sample);
+        if (x != EIDSP_OK) {
+            EIDSP_ERR(x);
+        }
+    }
+
+    // then we'll just go through normal processing of the rest of the signal:
+    size_t range_length = signal->total_length - offset_in_signal;
+    x = extract_mfcc_run_slice_i16(signal, offset_in_signal, range_length, prev_sample,
+        output_matrix, &config, sampling_frequency, matrix_size_out);
+    if (x != EIDSP_OK) {
+        EIDSP_ERR(x);
+    }
+
+    // update offset
+    int length_of_signal_used = speechpy::processing::calculate_signal_used(range_length, sampling_frequency,
+        config.frame_length, config.frame_stride, false, config.implementation_version);
+    offset_in_signal += length_of_signal_used;
+
+    // see what's left?
+    int bytes_left_end_of_frame = signal->total_length - offset_in_signal;
+    bytes_left_end_of_frame += frame_overlap_values;
+
+    if (bytes_left_end_of_frame > 0) {
+        // then read that (and the sample before it) into the ei_dsp_cont_current_frame_i16 buffer
+        size_t start = signal->total_length - bytes_left_end_of_frame;
+        if (start > 0) {
+            x = signal->get_data(start - 1, bytes_left_end_of_frame + 1, ei_dsp_cont_current_frame_i16);
+        }
+        else {
+            ei_dsp_cont_current_frame_i16[0] = ei_dsp_cont_last_sample_i16;
+            x = signal->get_data(0, bytes_left_end_of_frame, ei_dsp_cont_current_frame_i16 + 1);
+        }
+        if (x != EIDSP_OK) {
+            EIDSP_ERR(x);
+        }
+    }
+
+    ei_dsp_cont_current_frame_i16_ix = bytes_left_end_of_frame;
+
+    x = signal->get_data(signal->total_length - 1, 1, &ei_dsp_cont_last_sample_i16);
+    if (x != EIDSP_OK) {
+        EIDSP_ERR(x);
+    }
+
+    return EIDSP_OK;
+#endif
+}
+
 __attribute__((unused)) int extract_spectrogram_features(signal_t *signal, matrix_t *output_matrix, void *config_ptr, const float sampling_frequency) {
     ei_dsp_config_spectrogram_t config = *((ei_dsp_config_spectrogram_t*)config_ptr);
 
@@ -1439,6 +1703,15 @@ __attribute__((unused)) int ei_dsp_clear_continuous_audio_state() {
     ei_dsp_cont_current_frame_size = 0;
     ei_dsp_cont_current_frame_ix = 0;
 
+    if (ei_dsp_cont_current_frame_i16) {
+        ei_free(ei_dsp_cont_current_frame_i16);
+    }
+
+    ei_dsp_cont_current_frame_i16 = nullptr;
+    ei_dsp_cont_current_frame_i16_size = 0;
+    ei_dsp_cont_current_frame_i16_ix = 0;
+    ei_dsp_cont_last_sample_i16 = 0;
+
     return EIDSP_OK;
 }
 
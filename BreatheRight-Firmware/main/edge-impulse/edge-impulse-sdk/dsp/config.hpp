@@ -83,6 +83,49 @@
 #define EIDSP_QUANTIZE_FILTERBANK    1
 #endif // EIDSP_QUANTIZE_FILTERBANK
 
+// Run the MFCC of the int16 signal path (run_classifier_continuous_i16) in fixed point
+// rather than float, see speechpy::feature_fixed
+#ifndef EIDSP_MFCC_FIXED_POINT
+#define EIDSP_MFCC_FIXED_POINT       0
+#endif // EIDSP_MFCC_FIXED_POINT
+
+// Run the float MFCC of the int16 signal path with tables generated at compile time
+// for the DSP config in model_metadata.h, see speechpy::feature_static
+#ifndef EIDSP_MFCC_STATIC
+#define EIDSP_MFCC_STATIC            0
+#endif // EIDSP_MFCC_STATIC
+
+// Split the frames of feature_static::mfcc_i16 between the DSP workers of the
+// port (ei_dsp_parallel_for), every frame is still computed by the same code so
+// the features do not depend on the number of workers
+#ifndef EIDSP_MFCC_PARALLEL
+#define EIDSP_MFCC_PARALLEL          0
+#endif // EIDSP_MFCC_PARALLEL
+
+// Keep the kissfft real FFT plans between calls instead of building them (malloc,
+// twiddles) for every frame, see numpy::release_fft_plans
+#ifndef EIDSP_CACHE_FFT_PLANS
+#define EIDSP_CACHE_FFT_PLANS        0
+#endif // EIDSP_CACHE_FFT_PLANS
+
+// number of FFT lengths the plan cache holds
+#ifndef EIDSP_FFT_PLAN_CACHE_SLOTS
+#define EIDSP_FFT_PLAN_CACHE_SLOTS   2
+#endif // EIDSP_FFT_PLAN_CACHE_SLOTS
+
+// Compute the power spectrum as (r * r + i * i) / N straight from the FFT output,
+// instead of squaring the magnitudes from numpy::rfft. Set to 0 to compare with the
+// old path, see processing::power_spectrum
+#ifndef EIDSP_FUSED_POWER_SPECTRUM
+#define EIDSP_FUSED_POWER_SPECTRUM   0
+#endif // EIDSP_FUSED_POWER_SPECTRUM
+
+// Charge the time of the MFCC and classifier stages to ei_add_stage_time(), see
+// ei::stage_clock. Costs one timer read per stage per frame
+#ifndef EIDSP_PROFILE_STAGES
+#define EIDSP_PROFILE_STAGES         0
+#endif // EIDSP_PROFILE_STAGES
+
 // prints buffer allocations to stdout, useful when debugging
 #ifndef EIDSP_TRACK_ALLOCATIONS
 #define EIDSP_TRACK_ALLOCATIONS      0
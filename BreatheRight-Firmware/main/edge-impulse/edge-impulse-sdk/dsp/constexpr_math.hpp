@@ -0,0 +1,152 @@
+/* Edge Impulse inferencing library
+ * Copyright (c) 2021 EdgeImpulse Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _EIDSP_CONSTEXPR_MATH_H_
+#define _EIDSP_CONSTEXPR_MATH_H_
+
+#include <stddef.h>
+
+/**
+ * C++11 constexpr math, enough to build DSP tables at compile time. Everything
+ * is computed in double, callers round to float where the runtime code they
+ * mirror does. C++11 only allows a single return statement in a constexpr
+ * function, hence the recursion.
+ */
+namespace ei {
+namespace cx {
+
+constexpr double pi = 3.14159265358979323846264338327950288;
+constexpr double ln2 = 0.693147180559945309417232121458176568;
+
+constexpr double abs(double x) {
+    return x < 0 ? -x : x;
+}
+
+constexpr double floor(double x) {
+    return static_cast<double>(static_cast<long long>(x)) == x || x >= 0 ?
+        static_cast<double>(static_cast<long long>(x)) :
+        static_cast<double>(static_cast<long long>(x) - 1);
+}
+
+constexpr double ceil(double x) {
+    return -floor(-x);
+}
+
+constexpr double sqrt_newton(double x, double guess, int iterations) {
+    return iterations == 0 ? guess :
+        sqrt_newton(x, 0.5 * (guess + x / guess), iterations - 1);
+}
+
+/** Square root, for 0 <= x < 2^40 */
+constexpr double sqrt(double x) {
+    return x == 0 ? 0 : sqrt_newton(x, x > 1 ? x : 1, 48);
+}
+
+constexpr double exp_series(double x, double term, int k) {
+    return k > 24 ? term : term + exp_series(x, term * x / k, k + 1);
+}
+
+/** e^x, halves the argument down to |x| < 0.5 and squares back up */
+constexpr double exp(double x) {
+    return abs(x) < 0.5 ? exp_series(x, 1.0, 1) :
+        exp(x / 2) * exp(x / 2);
+}
+
+constexpr double log_series(double y2, double term, int k) {
+    return k > 41 ? term / k : term / k + log_series(y2, term * y2, k + 2);
+}
+
+/** Natural log for x > 0, scales x into [0.75, 1.5) then uses 2 atanh((x - 1) / (x + 1)) */
+constexpr double log(double x) {
+    return x >= 1.5 ? log(x / 2) + ln2 :
+        x < 0.75 ? log(x * 2) - ln2 :
+        2 * log_series(((x - 1) / (x + 1)) * ((x - 1) / (x + 1)), (x - 1) / (x + 1), 1);
+}
+
+constexpr double sin_series(double x2, double term, int k) {
+    return k > 30 ? term : term + sin_series(x2, -term * x2 / ((2 * k) * (2 * k + 1)), k + 1);
+}
+
+constexpr double reduce_angle(double x) {
+    return x - 2 * pi * floor(x / (2 * pi) + 0.5);
+}
+
+/** sin(x), reduced to [-pi, pi] first */
+constexpr double sin(double x) {
+    return sin_series(reduce_angle(x) * reduce_angle(x), reduce_angle(x), 1);
+}
+
+constexpr double cos(double x) {
+    return sin(x + pi / 2);
+}
+
+/** Compile time list of indices, builds tables from generator functions */
+template <size_t... I>
+struct index_sequence {
+    static constexpr size_t size = sizeof...(I);
+};
+
+template <class A, class B>
+struct concat_sequence;
+
+template <size_t... A, size_t... B>
+struct concat_sequence<index_sequence<A...>, index_sequence<B...> > {
+    typedef index_sequence<A..., (sizeof...(A) + B)...> type;
+};
+
+/** index_sequence<0, ..., N - 1>, in logarithmic template depth */
+template <size_t N>
+struct make_index_sequence {
+    typedef typename concat_sequence<
+        typename make_index_sequence<N / 2>::type,
+        typename make_index_sequence<N - N / 2>::type>::type type;
+};
+
+template <>
+struct make_index_sequence<0> {
+    typedef index_sequence<> type;
+};
+
+template <>
+struct make_index_sequence<1> {
+    typedef index_sequence<0> type;
+};
+
+/**
+ * A table of N values computed at compile time, data[i] = Generator::get(i).
+ * Generator needs a value_type and a static constexpr get(size_t).
+ */
+template <class Generator, size_t N, class Sequence = typename make_index_sequence<N>::type>
+struct table;
+
+template <class Generator, size_t N, size_t... I>
+struct table<Generator, N, index_sequence<I...> > {
+    static constexpr typename Generator::value_type data[N] = { Generator::get(I)... };
+};
+
+template <class Generator, size_t N, size_t... I>
+constexpr typename Generator::value_type table<Generator, N, index_sequence<I...> >::data[N];
+
+} // namespace cx
+} // namespace ei
+
+#endif // _EIDSP_CONSTEXPR_MATH_H_
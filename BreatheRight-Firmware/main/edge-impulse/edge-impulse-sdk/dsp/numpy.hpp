@@ -49,7 +49,7 @@ namespace ei {
 
 // clang-format off
 // lookup table for quantized values between 0.0f and 1.0f
-static const float quantized_values_one_zero[] = { (0.0f / 1.0f), (1.0f / 100.0f), (2.0f / 100.0f), (3.0f / 100.0f), (4.0f / 100.0f), (1.0f / 22.0f), (1.0f / 21.0f), (1.0f / 20.0f), (1.0f / 19.0f), (1.0f / 18.0f), (1.0f / 17.0f), (6.0f / 100.0f), (1.0f / 16.0f), (1.0f / 15.0f), (7.0f / 100.0f), (1.0f / 14.0f), (1.0f / 13.0f), (8.0f / 100.0f), (1.0f / 12.0f), (9.0f / 100.0f), (1.0f / 11.0f), (2.0f / 21.0f), (1.0f / 10.0f), (2.0f / 19.0f), (11.0f / 100.0f), (1.0f / 9.0f), (2.0f / 17.0f), (12.0f / 100.0f), (1.0f / 8.0f), (13.0f / 100.0f), (2.0f / 15.0f), (3.0f / 22.0f), (14.0f / 100.0f), (1.0f / 7.0f), (3.0f / 20.0f), (2.0f / 13.0f), (3.0f / 19.0f), (16.0f / 100.0f), (1.0f / 6.0f), (17.0f / 100.0f), (3.0f / 17.0f), (18.0f / 100.0f), (2.0f / 11.0f), (3.0f / 16.0f), (19.0f / 100.0f), (4.0f / 21.0f), (1.0f / 5.0f), (21.0f / 100.0f), (4.0f / 19.0f), (3.0f / 14.0f), (22.0f / 100.0f), (2.0f / 9.0f), (5.0f / 22.0f), (23.0f / 100.0f), (3.0f / 13.0f), (4.0f / 17.0f), (5.0f / 21.0f), (24.0f / 100.0f), (1.0f / 4.0f), (26.0f / 100.0f), (5.0f / 19.0f), (4.0f / 15.0f), (27.0f / 100.0f), (3.0f / 11.0f), (5.0f / 18.0f), (28.0f / 100.0f), (2.0f / 7.0f), (29.0f / 100.0f), (5.0f / 17.0f), (3.0f / 10.0f), (4.0f / 13.0f), (31.0f / 100.0f), (5.0f / 16.0f), (6.0f / 19.0f), (7.0f / 22.0f), (32.0f / 100.0f), (33.0f / 100.0f), (1.0f / 3.0f), (34.0f / 100.0f), (7.0f / 20.0f), (6.0f / 17.0f), (5.0f / 14.0f), (36.0f / 100.0f), (4.0f / 11.0f), (7.0f / 19.0f), (37.0f / 100.0f), (3.0f / 8.0f), (38.0f / 100.0f), (8.0f / 21.0f), (5.0f / 13.0f), (7.0f / 18.0f), (39.0f / 100.0f), (2.0f / 5.0f), (9.0f / 22.0f), (41.0f / 100.0f), (7.0f / 17.0f), (5.0f / 12.0f), (42.0f / 100.0f), (8.0f / 19.0f), (3.0f / 7.0f), (43.0f / 100.0f), (7.0f / 16.0f), (44.0f / 100.0f), (4.0f / 9.0f), (9.0f / 20.0f), (5.0f / 11.0f), (46.0f / 100.0f), (6.0f / 13.0f), (7.0f / 15.0f), (47.0f / 100.0f), (8.0f / 17.0f), (9.0f / 19.0f), (10.0f / 21.0f), (48.0f / 100.0f), (49.0f / 100.0f), (1.0f / 2.0f), (51.0f / 100.0f), (52.0f / 100.0f), (11.0f / 21.0f), (10.0f / 19.0f), (9.0f / 17.0f), (53.0f / 100.0f), (8.0f / 15.0f), (7.0f / 13.0f), (54.0f / 100.0f), (6.0f / 11.0f), (11.0f / 20.0f), (5.0f / 9.0f), (56.0f / 100.0f), (9.0f / 16.0f), (57.0f / 100.0f), (4.0f / 7.0f), (11.0f / 19.0f), (58.0f / 100.0f), (7.0f / 12.0f), (10.0f / 17.0f), (59.0f / 100.0f), (13.0f / 22.0f), (3.0f / 5.0f), (61.0f / 100.0f), (11.0f / 18.0f), (8.0f / 13.0f), (13.0f / 21.0f), (62.0f / 100.0f), (5.0f / 8.0f), (63.0f / 100.0f), (12.0f / 19.0f), (7.0f / 11.0f), (64.0f / 100.0f), (9.0f / 14.0f), (11.0f / 17.0f), (13.0f / 20.0f), (66.0f / 100.0f), (2.0f / 3.0f), (67.0f / 100.0f), (68.0f / 100.0f), (15.0f / 22.0f), (13.0f / 19.0f), (11.0f / 16.0f), (69.0f / 100.0f), (9.0f / 13.0f), (7.0f / 10.0f), (12.0f / 17.0f), (71.0f / 100.0f), (5.0f / 7.0f), (72.0f / 100.0f), (13.0f / 18.0f), (8.0f / 11.0f), (73.0f / 100.0f), (11.0f / 15.0f), (14.0f / 19.0f), (74.0f / 100.0f), (3.0f / 4.0f), (76.0f / 100.0f), (16.0f / 21.0f), (13.0f / 17.0f), (10.0f / 13.0f), (77.0f / 100.0f), (17.0f / 22.0f), (7.0f / 9.0f), (78.0f / 100.0f), (11.0f / 14.0f), (15.0f / 19.0f), (79.0f / 100.0f), (4.0f / 5.0f), (17.0f / 21.0f), (81.0f / 100.0f), (13.0f / 16.0f), (9.0f / 11.0f), (82.0f / 100.0f), (14.0f / 17.0f), (83.0f / 100.0f), (5.0f / 6.0f), (84.0f / 100.0f), (16.0f / 19.0f), (11.0f / 13.0f), (17.0f / 20.0f), (6.0f / 7.0f), (86.0f / 100.0f), (19.0f / 22.0f), (13.0f / 15.0f), (87.0f / 100.0f), (7.0f / 8.0f), (88.0f / 100.0f), (15.0f / 17.0f), (8.0f / 9.0f), (89.0f / 100.0f), (17.0f / 19.0f), (9.0f / 10.0f), (19.0f / 21.0f), (10.0f / 11.0f), (91.0f / 100.0f), (11.0f / 12.0f), (92.0f / 100.0f), (12.0f / 13.0f), (13.0f / 14.0f), (93.0f / 100.0f), (14.0f / 15.0f), (15.0f / 16.0f), (94.0f / 100.0f), (16.0f / 17.0f), (17.0f / 18.0f), (18.0f / 19.0f), (19.0f / 20.0f), (20.0f / 21.0f), (21.0f / 22.0f), (96.0f / 100.0f), (97.0f / 100.0f), (98.0f / 100.0f), (99.0f / 100.0f), (1.0f / 1.0f) ,
+static constexpr float quantized_values_one_zero[] = { (0.0f / 1.0f), (1.0f / 100.0f), (2.0f / 100.0f), (3.0f / 100.0f), (4.0f / 100.0f), (1.0f / 22.0f), (1.0f / 21.0f), (1.0f / 20.0f), (1.0f / 19.0f), (1.0f / 18.0f), (1.0f / 17.0f), (6.0f / 100.0f), (1.0f / 16.0f), (1.0f / 15.0f), (7.0f / 100.0f), (1.0f / 14.0f), (1.0f / 13.0f), (8.0f / 100.0f), (1.0f / 12.0f), (9.0f / 100.0f), (1.0f / 11.0f), (2.0f / 21.0f), (1.0f / 10.0f), (2.0f / 19.0f), (11.0f / 100.0f), (1.0f / 9.0f), (2.0f / 17.0f), (12.0f / 100.0f), (1.0f / 8.0f), (13.0f / 100.0f), (2.0f / 15.0f), (3.0f / 22.0f), (14.0f / 100.0f), (1.0f / 7.0f), (3.0f / 20.0f), (2.0f / 13.0f), (3.0f / 19.0f), (16.0f / 100.0f), (1.0f / 6.0f), (17.0f / 100.0f), (3.0f / 17.0f), (18.0f / 100.0f), (2.0f / 11.0f), (3.0f / 16.0f), (19.0f / 100.0f), (4.0f / 21.0f), (1.0f / 5.0f), (21.0f / 100.0f), (4.0f / 19.0f), (3.0f / 14.0f), (22.0f / 100.0f), (2.0f / 9.0f), (5.0f / 22.0f), (23.0f / 100.0f), (3.0f / 13.0f), (4.0f / 17.0f), (5.0f / 21.0f), (24.0f / 100.0f), (1.0f / 4.0f), (26.0f / 100.0f), (5.0f / 19.0f), (4.0f / 15.0f), (27.0f / 100.0f), (3.0f / 11.0f), (5.0f / 18.0f), (28.0f / 100.0f), (2.0f / 7.0f), (29.0f / 100.0f), (5.0f / 17.0f), (3.0f / 10.0f), (4.0f / 13.0f), (31.0f / 100.0f), (5.0f / 16.0f), (6.0f / 19.0f), (7.0f / 22.0f), (32.0f / 100.0f), (33.0f / 100.0f), (1.0f / 3.0f), (34.0f / 100.0f), (7.0f / 20.0f), (6.0f / 17.0f), (5.0f / 14.0f), (36.0f / 100.0f), (4.0f / 11.0f), (7.0f / 19.0f), (37.0f / 100.0f), (3.0f / 8.0f), (38.0f / 100.0f), (8.0f / 21.0f), (5.0f / 13.0f), (7.0f / 18.0f), (39.0f / 100.0f), (2.0f / 5.0f), (9.0f / 22.0f), (41.0f / 100.0f), (7.0f / 17.0f), (5.0f / 12.0f), (42.0f / 100.0f), (8.0f / 19.0f), (3.0f / 7.0f), (43.0f / 100.0f), (7.0f / 16.0f), (44.0f / 100.0f), (4.0f / 9.0f), (9.0f / 20.0f), (5.0f / 11.0f), (46.0f / 100.0f), (6.0f / 13.0f), (7.0f / 15.0f), (47.0f / 100.0f), (8.0f / 17.0f), (9.0f / 19.0f), (10.0f / 21.0f), (48.0f / 100.0f), (49.0f / 100.0f), (1.0f / 2.0f), (51.0f / 100.0f), (52.0f / 100.0f), (11.0f / 21.0f), (10.0f / 19.0f), (9.0f / 17.0f), (53.0f / 100.0f), (8.0f / 15.0f), (7.0f / 13.0f), (54.0f / 100.0f), (6.0f / 11.0f), (11.0f / 20.0f), (5.0f / 9.0f), (56.0f / 100.0f), (9.0f / 16.0f), (57.0f / 100.0f), (4.0f / 7.0f), (11.0f / 19.0f), (58.0f / 100.0f), (7.0f / 12.0f), (10.0f / 17.0f), (59.0f / 100.0f), (13.0f / 22.0f), (3.0f / 5.0f), (61.0f / 100.0f), (11.0f / 18.0f), (8.0f / 13.0f), (13.0f / 21.0f), (62.0f / 100.0f), (5.0f / 8.0f), (63.0f / 100.0f), (12.0f / 19.0f), (7.0f / 11.0f), (64.0f / 100.0f), (9.0f / 14.0f), (11.0f / 17.0f), (13.0f / 20.0f), (66.0f / 100.0f), (2.0f / 3.0f), (67.0f / 100.0f), (68.0f / 100.0f), (15.0f / 22.0f), (13.0f / 19.0f), (11.0f / 16.0f), (69.0f / 100.0f), (9.0f / 13.0f), (7.0f / 10.0f), (12.0f / 17.0f), (71.0f / 100.0f), (5.0f / 7.0f), (72.0f / 100.0f), (13.0f / 18.0f), (8.0f / 11.0f), (73.0f / 100.0f), (11.0f / 15.0f), (14.0f / 19.0f), (74.0f / 100.0f), (3.0f / 4.0f), (76.0f / 100.0f), (16.0f / 21.0f), (13.0f / 17.0f), (10.0f / 13.0f), (77.0f / 100.0f), (17.0f / 22.0f), (7.0f / 9.0f), (78.0f / 100.0f), (11.0f / 14.0f), (15.0f / 19.0f), (79.0f / 100.0f), (4.0f / 5.0f), (17.0f / 21.0f), (81.0f / 100.0f), (13.0f / 16.0f), (9.0f / 11.0f), (82.0f / 100.0f), (14.0f / 17.0f), (83.0f / 100.0f), (5.0f / 6.0f), (84.0f / 100.0f), (16.0f / 19.0f), (11.0f / 13.0f), (17.0f / 20.0f), (6.0f / 7.0f), (86.0f / 100.0f), (19.0f / 22.0f), (13.0f / 15.0f), (87.0f / 100.0f), (7.0f / 8.0f), (88.0f / 100.0f), (15.0f / 17.0f), (8.0f / 9.0f), (89.0f / 100.0f), (17.0f / 19.0f), (9.0f / 10.0f), (19.0f / 21.0f), (10.0f / 11.0f), (91.0f / 100.0f), (11.0f / 12.0f), (92.0f / 100.0f), (12.0f / 13.0f), (13.0f / 14.0f), (93.0f / 100.0f), (14.0f / 15.0f), (15.0f / 16.0f), (94.0f / 100.0f), (16.0f / 17.0f), (17.0f / 18.0f), (18.0f / 19.0f), (19.0f / 20.0f), (20.0f / 21.0f), (21.0f / 22.0f), (96.0f / 100.0f), (97.0f / 100.0f), (98.0f / 100.0f), (99.0f / 100.0f), (1.0f / 1.0f) ,
     1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f };
 // clang-format on
 
@@ -1400,6 +1400,72 @@ public:
         return EIDSP_OK;
     }
 
+    /**
+     * Power spectrum of a real input, (r * r + i * i) / n_fft per bin.
+     * Same as squaring the magnitudes from `rfft` and dividing by n_fft,
+     * without the sqrt and the intermediate magnitude array.
+     * @param src Source buffer
+     * @param src_size Size of the source buffer, zero padded or truncated to n_fft
+     * @param output Output buffer
+     * @param output_size Size of the output buffer, should be n_fft / 2 + 1
+     * @param n_fft Number of points
+     * @returns 0 if OK
+     */
+    static int rfft_power(const float *src, size_t src_size, float *output, size_t output_size, size_t n_fft) {
+        size_t n_fft_out_features = (n_fft / 2) + 1;
+        if (output_size != n_fft_out_features) {
+            EIDSP_ERR(EIDSP_BUFFER_SIZE_MISMATCH);
+        }
+
+        // truncate if needed
+        if (src_size > n_fft) {
+            src_size = n_fft;
+        }
+
+        const float scale = 1.0f / static_cast<float>(n_fft);
+
+#if EIDSP_USE_CMSIS_DSP
+        if (n_fft == 32 || n_fft == 64 || n_fft == 128 || n_fft == 256 ||
+            n_fft == 512 || n_fft == 1024 || n_fft == 2048 || n_fft == 4096) {
+            arm_rfft_fast_instance_f32 rfft_instance;
+            arm_status status = arm_rfft_fast_init_f32(&rfft_instance, n_fft);
+            if (status != ARM_MATH_SUCCESS) {
+                return status;
+            }
+
+            // arm_rfft_fast_f32 overwrites its input
+            EI_DSP_MATRIX(fft_input, 1, n_fft);
+            EI_DSP_MATRIX(fft_output, 1, n_fft);
+            memcpy(fft_input.buffer, src, src_size * sizeof(float));
+            memset(fft_input.buffer + src_size, 0, (n_fft - src_size) * sizeof(float));
+
+            arm_rfft_fast_f32(&rfft_instance, fft_input.buffer, fft_output.buffer, 0);
+
+            // DC and Nyquist are packed in the first pair
+            output[0] = fft_output.buffer[0] * fft_output.buffer[0] * scale;
+            output[n_fft_out_features - 1] = fft_output.buffer[1] * fft_output.buffer[1] * scale;
+            for (size_t ix = 1; ix < n_fft_out_features - 1; ix++) {
+                float r = fft_output.buffer[2 * ix];
+                float i = fft_output.buffer[2 * ix + 1];
+                output[ix] = (r * r + i * i) * scale;
+            }
+
+            return EIDSP_OK;
+        }
+#endif
+
+        // kiss_fftr doesn't touch its input, only copy when we need to zero pad
+        if (src_size == n_fft) {
+            return software_rfft_power(src, output, n_fft, n_fft_out_features, scale);
+        }
+
+        EI_DSP_MATRIX(fft_input, 1, n_fft);
+        memcpy(fft_input.buffer, src, src_size * sizeof(float));
+        memset(fft_input.buffer + src_size, 0, (n_fft - src_size) * sizeof(float));
+
+        return software_rfft_power(fft_input.buffer, output, n_fft, n_fft_out_features, scale);
+    }
+
     /**
      * Compute the one-dimensional discrete Fourier Transform for real input.
      * This function computes the one-dimensional n-point discrete Fourier Transform (DFT) of
@@ -2159,7 +2225,102 @@ public:
         return EIDSP_OK;
     }
 
+    /**
+     * Free the real FFT plans cached by the software rfft (EIDSP_CACHE_FFT_PLANS).
+     * Call this when the classifier is torn down, the next rfft builds them again.
+     */
+    static void release_fft_plans() {
+#if EIDSP_CACHE_FFT_PLANS
+        fft_plan_t *plans = fft_plan_cache();
+        for (size_t ix = 0; ix < EIDSP_FFT_PLAN_CACHE_SLOTS; ix++) {
+            if (plans[ix].cfg) {
+                ei_dsp_free(plans[ix].cfg, plans[ix].mem_length);
+                plans[ix].cfg = NULL;
+                plans[ix].n_fft = 0;
+                plans[ix].mem_length = 0;
+            }
+        }
+#endif
+    }
+
 private:
+#if EIDSP_CACHE_FFT_PLANS
+    typedef struct {
+        size_t n_fft;
+        size_t mem_length;
+        kiss_fftr_cfg cfg;
+    } fft_plan_t;
+
+    /**
+     * Plans kept between calls, one per FFT length. kiss_fftr uses scratch
+     * space inside the plan, so a plan must not be used by two tasks at once.
+     */
+    static fft_plan_t *fft_plan_cache() {
+        static fft_plan_t plans[EIDSP_FFT_PLAN_CACHE_SLOTS];
+        return plans;
+    }
+#endif
+
+    /**
+     * Get a real FFT plan (config and twiddles) for n_fft, hand it back with
+     * `put_fft_plan`. With EIDSP_CACHE_FFT_PLANS the plan is built on first use
+     * and then stays in the cache until `release_fft_plans`, when all slots are
+     * taken by other lengths it is built and freed per call as before.
+     * @param n_fft Number of points
+     * @param mem_length Out, size of the plan
+     * @returns The plan or NULL if out of memory
+     */
+    static kiss_fftr_cfg get_fft_plan(size_t n_fft, size_t *mem_length) {
+#if EIDSP_CACHE_FFT_PLANS
+        fft_plan_t *plans = fft_plan_cache();
+        fft_plan_t *free_slot = NULL;
+        for (size_t ix = 0; ix < EIDSP_FFT_PLAN_CACHE_SLOTS; ix++) {
+            if (plans[ix].cfg && plans[ix].n_fft == n_fft) {
+                *mem_length = plans[ix].mem_length;
+                return plans[ix].cfg;
+            }
+            if (!plans[ix].cfg && !free_slot) {
+                free_slot = &plans[ix];
+            }
+        }
+#endif
+
+        kiss_fftr_cfg cfg = kiss_fftr_alloc(n_fft, 0, NULL, NULL, mem_length);
+        if (!cfg) {
+            return NULL;
+        }
+
+        ei_dsp_register_alloc(*mem_length, cfg);
+
+#if EIDSP_CACHE_FFT_PLANS
+        if (free_slot) {
+            free_slot->n_fft = n_fft;
+            free_slot->mem_length = *mem_length;
+            free_slot->cfg = cfg;
+        }
+#endif
+
+        return cfg;
+    }
+
+    /**
+     * Hand back a plan from `get_fft_plan`, frees it unless it is cached.
+     */
+    static void put_fft_plan(kiss_fftr_cfg cfg, size_t mem_length) {
+        // only read by ei_dsp_free when EIDSP_TRACK_ALLOCATIONS is set
+        (void)mem_length;
+#if EIDSP_CACHE_FFT_PLANS
+        fft_plan_t *plans = fft_plan_cache();
+        for (size_t ix = 0; ix < EIDSP_FFT_PLAN_CACHE_SLOTS; ix++) {
+            if (plans[ix].cfg == cfg) {
+                return;
+            }
+        }
+#endif
+
+        ei_dsp_free(cfg, mem_length);
+    }
+
     static int software_rfft(float *fft_input, float *output, size_t n_fft, size_t n_fft_out_features) {
         kiss_fft_cpx *fft_output = (kiss_fft_cpx*)ei_dsp_malloc(n_fft_out_features * sizeof(kiss_fft_cpx));
         if (!fft_output) {
@@ -2168,15 +2329,13 @@ private:
 
         size_t kiss_fftr_mem_length;
 
-        // create fftr context
-        kiss_fftr_cfg cfg = kiss_fftr_alloc(n_fft, 0, NULL, NULL, &kiss_fftr_mem_length);
+        // get the fftr context
+        kiss_fftr_cfg cfg = get_fft_plan(n_fft, &kiss_fftr_mem_length);
         if (!cfg) {
             ei_dsp_free(fft_output, n_fft_out_features * sizeof(kiss_fft_cpx));
             EIDSP_ERR(EIDSP_OUT_OF_MEM);
         }
 
-        ei_dsp_register_alloc(kiss_fftr_mem_length, cfg);
-
         // execute the rfft operation
         kiss_fftr(cfg, fft_input, fft_output);
 
@@ -2185,7 +2344,7 @@ private:
             output[ix] = sqrt(pow(fft_output[ix].r, 2) + pow(fft_output[ix].i, 2));
         }
 
-        ei_dsp_free(cfg, kiss_fftr_mem_length);
+        put_fft_plan(cfg, kiss_fftr_mem_length);
         ei_dsp_free(fft_output, n_fft_out_features * sizeof(kiss_fft_cpx));
 
         return EIDSP_OK;
@@ -2193,20 +2352,46 @@ private:
 
     static int software_rfft(float *fft_input, fft_complex_t *output, size_t n_fft, size_t n_fft_out_features)
     {
-        // create fftr context
+        // get the fftr context
         size_t kiss_fftr_mem_length;
 
-        kiss_fftr_cfg cfg = kiss_fftr_alloc(n_fft, 0, NULL, NULL, &kiss_fftr_mem_length);
+        kiss_fftr_cfg cfg = get_fft_plan(n_fft, &kiss_fftr_mem_length);
         if (!cfg) {
             EIDSP_ERR(EIDSP_OUT_OF_MEM);
         }
 
-        ei_dsp_register_alloc(kiss_fftr_mem_length, cfg);
-
         // execute the rfft operation
         kiss_fftr(cfg, fft_input, (kiss_fft_cpx*)output);
 
-        ei_dsp_free(cfg, kiss_fftr_mem_length);
+        put_fft_plan(cfg, kiss_fftr_mem_length);
+
+        return EIDSP_OK;
+    }
+
+    static int software_rfft_power(const float *fft_input, float *output, size_t n_fft, size_t n_fft_out_features,
+        float scale)
+    {
+        kiss_fft_cpx *fft_output = (kiss_fft_cpx*)ei_dsp_malloc(n_fft_out_features * sizeof(kiss_fft_cpx));
+        if (!fft_output) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+
+        size_t kiss_fftr_mem_length;
+
+        kiss_fftr_cfg cfg = get_fft_plan(n_fft, &kiss_fftr_mem_length);
+        if (!cfg) {
+            ei_dsp_free(fft_output, n_fft_out_features * sizeof(kiss_fft_cpx));
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+
+        kiss_fftr(cfg, fft_input, fft_output);
+
+        for (size_t ix = 0; ix < n_fft_out_features; ix++) {
+            output[ix] = (fft_output[ix].r * fft_output[ix].r + fft_output[ix].i * fft_output[ix].i) * scale;
+        }
+
+        put_fft_plan(cfg, kiss_fftr_mem_length);
+        ei_dsp_free(fft_output, n_fft_out_features * sizeof(kiss_fft_cpx));
 
         return EIDSP_OK;
     }
@@ -25,13 +25,44 @@
 
 #include <vector>
 #include <stdint.h>
+#include <math.h>
 #include "functions.hpp"
 #include "processing.hpp"
 #include "../memory.hpp"
+#include "../stage_clock.hpp"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846264338327950288
+#endif // M_PI
 
 namespace ei {
 namespace speechpy {
 
+/**
+ * Mel filterbank stored as one run of weights per filter, from the first to
+ * the last non-zero weight of the filter. Each filter only covers a few FFT
+ * bins, so this is much smaller than the num_filters x coefficients matrix
+ * and applying it skips all the zeros.
+ * Built by `feature::sparse_filterbanks`, applied by `feature::apply_filterbank`.
+ */
+typedef struct ei_sparse_filterbank {
+    uint16_t num_filters;
+    uint16_t *runs;         // first bin and number of bins of every filter
+    float *weights;         // weights of all filters, one run after the other
+    size_t weights_size;    // allocated number of weights
+
+    ei_sparse_filterbank() : num_filters(0), runs(NULL), weights(NULL), weights_size(0) { }
+
+    ~ei_sparse_filterbank() {
+        if (runs) {
+            ei_dsp_free(runs, 2 * num_filters * sizeof(uint16_t));
+        }
+        if (weights) {
+            ei_dsp_free(weights, weights_size * sizeof(float));
+        }
+    }
+} sparse_filterbank_t;
+
 class feature {
 public:
     /**
@@ -61,15 +92,8 @@ public:
         bool output_transposed = false
         )
     {
-        const size_t mels_mem_size = (num_filter + 2) * sizeof(float);
-        const size_t hertz_mem_size = (num_filter + 2) * sizeof(float);
         const size_t freq_index_mem_size = (num_filter + 2) * sizeof(int);
 
-        float *mels = (float*)ei_dsp_malloc(mels_mem_size);
-        if (!mels) {
-            EIDSP_ERR(EIDSP_OUT_OF_MEM);
-        }
-
         if (filterbanks->rows != num_filter || filterbanks->cols != static_cast<uint32_t>(coefficients)) {
             EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
         }
@@ -80,54 +104,16 @@ public:
         memset(filterbanks->buffer, 0, filterbanks->rows * filterbanks->cols * sizeof(float));
 #endif
 
-        // Computing the Mel filterbank
-        // converting the upper and lower frequencies to Mels.
-        // num_filter + 2 is because for num_filter filterbanks we need
-        // num_filter+2 point.
-        numpy::linspace(
-            functions::frequency_to_mel(static_cast<float>(low_freq)),
-            functions::frequency_to_mel(static_cast<float>(high_freq)),
-            num_filter + 2,
-            mels);
-
-        // we should convert Mels back to Hertz because the start and end-points
-        // should be at the desired frequencies.
-        float *hertz = (float*)ei_dsp_malloc(hertz_mem_size);
-        if (!hertz) {
-            ei_dsp_free(mels, mels_mem_size);
-            EIDSP_ERR(EIDSP_OUT_OF_MEM);
-        }
-        for (uint16_t ix = 0; ix < num_filter + 2; ix++) {
-            hertz[ix] = functions::mel_to_frequency(mels[ix]);
-            if (hertz[ix] < low_freq) {
-                hertz[ix] = low_freq;
-            }
-            if (hertz[ix] > high_freq) {
-                hertz[ix] = high_freq;
-            }
-
-            // here is a really annoying bug in Speechpy which calculates the frequency index wrong for the last bucket
-            // the last 'hertz' value is not 8,000 (with sampling rate 16,000) but 7,999.999999
-            // thus calculating the bucket to 64, not 65.
-            // we're adjusting this here a tiny bit to ensure we have the same result
-            if (ix == num_filter + 2 - 1) {
-                hertz[ix] -= 0.001;
-            }
-        }
-        ei_dsp_free(mels, mels_mem_size);
-
-        // The frequency resolution required to put filters at the
-        // exact points calculated above should be extracted.
-        //  So we should round those frequencies to the closest FFT bin.
         int *freq_index = (int*)ei_dsp_malloc(freq_index_mem_size);
         if (!freq_index) {
-            ei_dsp_free(hertz, hertz_mem_size);
             EIDSP_ERR(EIDSP_OUT_OF_MEM);
         }
-        for (uint16_t ix = 0; ix < num_filter + 2; ix++) {
-            freq_index[ix] = static_cast<int>(floor((coefficients + 1) * hertz[ix] / sampling_freq));
+
+        int ret = filterbank_bins(freq_index, num_filter, coefficients, sampling_freq, low_freq, high_freq);
+        if (ret != EIDSP_OK) {
+            ei_dsp_free(freq_index, freq_index_mem_size);
+            EIDSP_ERR(ret);
         }
-        ei_dsp_free(hertz, hertz_mem_size);
 
         for (size_t i = 0; i < num_filter; i++) {
             int left = freq_index[i];
@@ -169,6 +155,110 @@ public:
         return EIDSP_OK;
     }
 
+    /**
+     * Compute the Mel-filterbanks as one run of weights per filter. Same
+     * weights as `filterbanks` (including EIDSP_QUANTIZE_FILTERBANK), without
+     * the zeros.
+     *
+     * @param filterbanks Empty sparse filterbank, allocated here
+     * @param num_filter the number of filters in the filterbank
+     * @param coefficients (fftpoints//2 + 1)
+     * @param sampling_freq  the samplerate of the signal we are working with
+     * @param low_freq lowest band edge of mel filters
+     * @param high_freq highest band edge of mel filters
+     * @returns EIDSP_OK if OK
+     */
+    static int sparse_filterbanks(sparse_filterbank_t *filterbanks,
+        uint16_t num_filter, int coefficients, uint32_t sampling_freq,
+        uint32_t low_freq, uint32_t high_freq)
+    {
+        if (filterbanks->runs || filterbanks->weights) {
+            EIDSP_ERR(EIDSP_PARAMETER_INVALID);
+        }
+
+        const size_t freq_index_mem_size = (num_filter + 2) * sizeof(int);
+        int *freq_index = (int*)ei_dsp_malloc(freq_index_mem_size);
+        if (!freq_index) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+
+        int ret = filterbank_bins(freq_index, num_filter, coefficients, sampling_freq, low_freq, high_freq);
+        if (ret != EIDSP_OK) {
+            ei_dsp_free(freq_index, freq_index_mem_size);
+            EIDSP_ERR(ret);
+        }
+
+        // room for every bin between the edges, the zeros at either end are dropped below
+        size_t weights_size = 0;
+        for (size_t i = 0; i < num_filter; i++) {
+            weights_size += freq_index[i + 2] - freq_index[i] + 1;
+        }
+
+        filterbanks->runs = (uint16_t*)ei_dsp_malloc(2 * num_filter * sizeof(uint16_t));
+        if (!filterbanks->runs) {
+            ei_dsp_free(freq_index, freq_index_mem_size);
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+        filterbanks->num_filters = num_filter;
+
+        filterbanks->weights = (float*)ei_dsp_malloc(weights_size * sizeof(float));
+        if (!filterbanks->weights) {
+            ei_dsp_free(freq_index, freq_index_mem_size);
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+        filterbanks->weights_size = weights_size;
+
+        float *w = filterbanks->weights;
+        for (size_t i = 0; i < num_filter; i++) {
+            int left = freq_index[i];
+            int middle = freq_index[i + 1];
+            int right = freq_index[i + 2] < coefficients ? freq_index[i + 2] : coefficients - 1;
+
+            int first = right + 1;
+            int last = left - 1;
+            for (int bin = left; bin <= right; bin++) {
+                float weight = filterbank_weight(bin, left, middle, freq_index[i + 2]);
+                if (weight != 0.0f) {
+                    if (first > right) {
+                        first = bin;
+                    }
+                    last = bin;
+                }
+            }
+
+            filterbanks->runs[2 * i] = first > right ? 0 : first;
+            filterbanks->runs[2 * i + 1] = first > right ? 0 : last - first + 1;
+            for (int bin = first; bin <= last; bin++) {
+                *w++ = filterbank_weight(bin, left, middle, freq_index[i + 2]);
+            }
+        }
+
+        ei_dsp_free(freq_index, freq_index_mem_size);
+
+        return EIDSP_OK;
+    }
+
+    /**
+     * Apply a sparse filterbank to one power spectrum frame.
+     * @param filterbanks Filterbank from `sparse_filterbanks`
+     * @param frame Power spectrum, coefficients values
+     * @param out Out buffer of num_filters values
+     */
+    static void apply_filterbank(const sparse_filterbank_t *filterbanks, const float *frame, float *out)
+    {
+        const float *w = filterbanks->weights;
+        for (size_t i = 0; i < filterbanks->num_filters; i++) {
+            const float *x = frame + filterbanks->runs[2 * i];
+            const uint16_t length = filterbanks->runs[2 * i + 1];
+            float acc = 0.0f;
+            for (uint16_t k = 0; k < length; k++) {
+                acc += x[k] * w[k];
+            }
+            w += length;
+            out[i] = acc;
+        }
+    }
+
     /**
      * Compute Mel-filterbank energy features from an audio signal.
      * @param out_features Use `calculate_mfe_buffer_size` to allocate the right matrix.
@@ -207,6 +297,8 @@ public:
             low_frequency = 300;
         }
 
+        stage_clock clock;
+
         stack_frames_info_t stack_frame_info = { 0 };
         stack_frame_info.signal = signal;
 
@@ -221,6 +313,7 @@ public:
         if (ret != 0) {
             EIDSP_ERR(ret);
         }
+        clock.mark(EI_STAGE_FRAMING);
 
         if (stack_frame_info.frame_ixs->size() != out_features->rows) {
             EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
@@ -242,20 +335,14 @@ public:
 
         // calculate the filterbanks first... preferably I would want to do the matrix multiplications
         // whenever they happen, but OK...
-#if EIDSP_QUANTIZE_FILTERBANK
-        EI_DSP_QUANTIZED_MATRIX(filterbanks, num_filters, coefficients, &numpy::dequantize_zero_one);
-#else
-        EI_DSP_MATRIX(filterbanks, num_filters, coefficients);
-#endif
-        if (!filterbanks.buffer) {
-            EIDSP_ERR(EIDSP_OUT_OF_MEM);
-        }
-
-        ret = feature::filterbanks(
-            &filterbanks, num_filters, coefficients, sampling_frequency, low_frequency, high_frequency, true);
+        sparse_filterbank_t filterbanks;
+        ret = feature::sparse_filterbanks(
+            &filterbanks, num_filters, coefficients, sampling_frequency, low_frequency, high_frequency);
         if (ret != 0) {
             EIDSP_ERR(ret);
         }
+        clock.mark(EI_STAGE_FILTERBANK);
+
         for (size_t ix = 0; ix < stack_frame_info.frame_ixs->size(); ix++) {
             size_t power_spectrum_frame_size = (fft_length / 2 + 1);
 
@@ -275,6 +362,8 @@ public:
                     (stack_frame_info.signal->total_length - (signal_offset + signal_length));
             }
 
+            // the signal applies the preemphasis as it is read, so it is
+            // part of the framing here
             ret = stack_frame_info.signal->get_data(
                 signal_offset,
                 signal_length,
@@ -283,6 +372,7 @@ public:
             if (ret != 0) {
                 EIDSP_ERR(ret);
             }
+            clock.mark(EI_STAGE_FRAMING);
 
             ret = processing::power_spectrum(
                 signal_frame.buffer,
@@ -295,6 +385,7 @@ public:
             if (ret != 0) {
                 EIDSP_ERR(ret);
             }
+            clock.mark(EI_STAGE_FFT);
 
             float energy = numpy::sum(power_spectrum_frame.buffer, power_spectrum_frame_size);
             if (energy == 0) {
@@ -304,20 +395,12 @@ public:
             out_energies->buffer[ix] = energy;
 
             // calculate the out_features directly here
-            ret = numpy::dot_by_row(
-                ix,
-                power_spectrum_frame.buffer,
-                power_spectrum_frame_size,
-                &filterbanks,
-                out_features
-            );
-
-            if (ret != 0) {
-                EIDSP_ERR(ret);
-            }
+            apply_filterbank(&filterbanks, power_spectrum_frame.buffer, out_features->buffer + ix * num_filters);
+            clock.mark(EI_STAGE_FILTERBANK);
         }
 
         functions::zero_handling(out_features);
+        clock.mark(EI_STAGE_FILTERBANK);
 
         return EIDSP_OK;
     }
@@ -525,36 +608,285 @@ public:
             EIDSP_ERR(ret);
         }
 
-        // ok... now we need to calculate the MFCC from this...
+        return mfcc_from_mfe(out_features, &features_matrix, &energy_matrix, num_cepstral, dc_elimination);
+    }
+
+    /**
+     * Turn MFE features into MFCC: log, DCT-II and optionally replace the
+     * first coefficient with the log frame energy. Only the kept
+     * coefficients of the DCT are computed, see `dct2_rows`.
+     * @param out_features Output, rows x num_cepstral
+     * @param features_matrix MFE features, will be modified in place
+     * @param energy_matrix Frame energies, rows x 1
+     * @param num_cepstral Number of cepstral coefficients to keep
+     * @param dc_elimination Whether the first dc component should be eliminated
+     * @returns 0 if OK
+     */
+    static int mfcc_from_mfe(matrix_t *out_features, matrix_t *features_matrix, matrix_t *energy_matrix,
+        uint8_t num_cepstral, bool dc_elimination)
+    {
+        const uint32_t num_filters = features_matrix->cols;
+
+        if (out_features->cols != num_cepstral || num_cepstral > num_filters ||
+                out_features->rows != features_matrix->rows) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+
+        stage_clock clock;
+
         // first do log() over all features...
-        ret = numpy::log(&features_matrix);
+        int ret = numpy::log(features_matrix);
         if (ret != EIDSP_OK) {
             EIDSP_ERR(ret);
         }
+        clock.mark(EI_STAGE_FILTERBANK);
 
-        // now do DST type 2
-        ret = numpy::dct2(&features_matrix, DCT_NORMALIZATION_ORTHO);
-        if (ret != EIDSP_OK) {
-            EIDSP_ERR(ret);
+        // now do DCT type 2, only for the coefficients we keep
+        EI_DSP_MATRIX(dct, num_cepstral, num_filters);
+        dct2_rows(dct.buffer, num_cepstral, num_filters);
+
+        for (size_t row = 0; row < features_matrix->rows; row++) {
+            const float *log_mel = features_matrix->buffer + row * num_filters;
+            float *out_row = out_features->buffer + row * num_cepstral;
+
+            for (size_t i = dc_elimination ? 1 : 0; i < num_cepstral; i++) {
+                const float *d = dct.buffer + i * num_filters;
+                float acc = 0.0f;
+                for (size_t k = 0; k < num_filters; k++) {
+                    acc += d[k] * log_mel[k];
+                }
+                out_row[i] = acc;
+            }
+
+            // replace first cepstral coefficient with log of frame energy for DC elimination
+            if (dc_elimination) {
+                out_row[0] = numpy::log(energy_matrix->buffer[row]);
+            }
         }
+        clock.mark(EI_STAGE_DCT);
 
-        // replace first cepstral coefficient with log of frame energy for DC elimination
-        if (dc_elimination) {
-            for (size_t row = 0; row < features_matrix.rows; row++) {
-                features_matrix.buffer[row * features_matrix.cols] = numpy::log(energy_matrix.buffer[row]);
+        return EIDSP_OK;
+    }
+
+    /**
+     * Rows of the orthonormal DCT-II matrix for the first num_cepstral
+     * coefficients, same normalization as numpy::dct2 with DCT_NORMALIZATION_ORTHO.
+     * The cosines of every column are stepped with the angle addition
+     * formulas, so this needs 2 * num_filters trig calls.
+     * @param dct Out buffer of num_cepstral x num_filters values
+     */
+    static void dct2_rows(float *dct, uint8_t num_cepstral, uint32_t num_filters)
+    {
+        const float scale_0 = sqrtf(1.0f / static_cast<float>(num_filters));
+        const float scale = sqrtf(2.0f / static_cast<float>(num_filters));
+
+        for (size_t k = 0; k < num_filters; k++) {
+            const float phase = static_cast<float>(M_PI) * static_cast<float>(2 * k + 1) /
+                static_cast<float>(2 * num_filters);
+            const float c1 = cosf(phase);
+            const float s1 = sinf(phase);
+
+            // cos(i * phase) and sin(i * phase)
+            float c = 1.0f;
+            float s = 0.0f;
+            for (size_t i = 0; i < num_cepstral; i++) {
+                dct[i * num_filters + k] = (i == 0 ? scale_0 : scale) * c;
+                float next_c = c * c1 - s * s1;
+                s = s * c1 + c * s1;
+                c = next_c;
             }
         }
+    }
+
+    /**
+     * MFE over an int16 signal. Frames are read as int16 and preemphasis is
+     * applied while converting to float straight into the FFT input, so each
+     * sample is converted exactly once and only the first fft_length samples
+     * of a frame are read. Scratch buffers are allocated once per call.
+     * Only implementation version 2 (no v1 frame length hack) is supported.
+     * @param out_features Use `calculate_mfe_buffer_size` to allocate the right matrix.
+     * @param out_energies A matrix in the form of Mx1 where M is the rows from `calculate_mfe_buffer_size`
+     * @param signal int16 audio signal
+     * @param signal_offset Offset in the signal of the first sample to process
+     * @param signal_length Number of samples to process
+     * @param prev_sample The sample preceding signal_offset, used by the preemphasis
+     * @param pre_cof Preemphasis coefficient (shift of 1)
+     * @returns 0 if OK
+     */
+    static int mfe_i16(matrix_t *out_features, matrix_t *out_energies,
+        signal_i16_t *signal, size_t signal_offset, size_t signal_length,
+        int16_t prev_sample, float pre_cof,
+        uint32_t sampling_frequency,
+        float frame_length, float frame_stride, uint16_t num_filters,
+        uint16_t fft_length, uint32_t low_frequency, uint32_t high_frequency,
+        uint16_t version
+        )
+    {
+        int ret = 0;
+
+        if (version != 2) {
+            EIDSP_ERR(EIDSP_NOT_SUPPORTED);
+        }
+
+        if (high_frequency == 0) {
+            high_frequency = sampling_frequency / 2;
+        }
 
-        // copy to the output...
-        for (size_t row = 0; row < features_matrix.rows; row++) {
-            for(int i = 0; i < num_cepstral; i++) {
-                *(out_features->buffer + (num_cepstral * row) + i) = *(features_matrix.buffer + (features_matrix.cols * row) + i);
+        if (low_frequency == 0) {
+            low_frequency = 300;
+        }
+
+        const size_t frame_sample_length = static_cast<size_t>(
+            processing::ceil_unless_very_close_to_floor(static_cast<float>(sampling_frequency) * frame_length));
+        const size_t frame_stride_values = static_cast<size_t>(
+            processing::ceil_unless_very_close_to_floor(static_cast<float>(sampling_frequency) * frame_stride));
+        const size_t num_frames = out_features->rows;
+
+        if (num_frames != static_cast<size_t>(processing::calculate_no_of_stack_frames(
+                signal_length, sampling_frequency, frame_length, frame_stride, false, version))) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+
+        if (num_filters != out_features->cols) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+
+        if (num_frames != out_energies->rows || out_energies->cols != 1) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+
+        for (uint32_t i = 0; i < out_features->rows * out_features->cols; i++) {
+            *(out_features->buffer + i) = 0;
+        }
+
+        uint16_t coefficients = fft_length / 2 + 1;
+
+        stage_clock clock;
+
+        sparse_filterbank_t filterbanks;
+        ret = feature::sparse_filterbanks(
+            &filterbanks, num_filters, coefficients, sampling_frequency, low_frequency, high_frequency);
+        if (ret != 0) {
+            EIDSP_ERR(ret);
+        }
+        clock.mark(EI_STAGE_FILTERBANK);
+
+        // the FFT truncates longer frames, so don't read what it would drop
+        const size_t read_length = frame_sample_length < fft_length ? frame_sample_length : fft_length;
+
+        // [0] holds the sample preceding the frame for the preemphasis
+        EI_DSP_i16_MATRIX(frame_i16, 1, read_length + 1);
+        EI_DSP_MATRIX(fft_frame, 1, fft_length);
+        EI_DSP_MATRIX(power_spectrum_frame, 1, coefficients);
+        if (!frame_i16.buffer || !fft_frame.buffer || !power_spectrum_frame.buffer) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+
+        for (size_t ix = 0; ix < num_frames; ix++) {
+            size_t frame_offset = signal_offset + ix * frame_stride_values;
+
+            if (ix == 0) {
+                frame_i16.buffer[0] = prev_sample;
+                ret = signal->get_data(frame_offset, read_length, frame_i16.buffer + 1);
+            }
+            else {
+                ret = signal->get_data(frame_offset - 1, read_length + 1, frame_i16.buffer);
+            }
+            if (ret != 0) {
+                EIDSP_ERR(ret);
+            }
+            clock.mark(EI_STAGE_FRAMING);
+
+            // preemphasis fused with the only int16 -> float conversion, samples
+            // are Q15 like in numpy::int16_to_float
+            for (size_t i = 0; i < read_length; i++) {
+                fft_frame.buffer[i] = (static_cast<float>(frame_i16.buffer[i + 1]) -
+                    (pre_cof * static_cast<float>(frame_i16.buffer[i]))) * (1.0f / 32768.0f);
+            }
+            for (size_t i = read_length; i < fft_length; i++) {
+                fft_frame.buffer[i] = 0.0f;
+            }
+            clock.mark(EI_STAGE_PREEMPHASIS);
+
+            ret = processing::power_spectrum(
+                fft_frame.buffer,
+                fft_length,
+                power_spectrum_frame.buffer,
+                coefficients,
+                fft_length
+            );
+            if (ret != 0) {
+                EIDSP_ERR(ret);
             }
+            clock.mark(EI_STAGE_FFT);
+
+            float energy = numpy::sum(power_spectrum_frame.buffer, coefficients);
+            if (energy == 0) {
+                energy = FLT_EPSILON;
+            }
+
+            out_energies->buffer[ix] = energy;
+
+            apply_filterbank(&filterbanks, power_spectrum_frame.buffer, out_features->buffer + ix * num_filters);
+            clock.mark(EI_STAGE_FILTERBANK);
         }
 
+        functions::zero_handling(out_features);
+        clock.mark(EI_STAGE_FILTERBANK);
+
         return EIDSP_OK;
     }
 
+    /**
+     * Compute MFCC features from a range of an int16 audio signal, see `mfe_i16`
+     * for the framing and preemphasis. Produces the same features as `mfcc`
+     * over a float signal preemphasized with a shift of 1.
+     * @returns 0 if OK
+     */
+    static int mfcc_i16(matrix_t *out_features, signal_i16_t *signal,
+        size_t signal_offset, size_t signal_length, int16_t prev_sample, float pre_cof,
+        uint32_t sampling_frequency, float frame_length, float frame_stride,
+        uint8_t num_cepstral, uint16_t num_filters, uint16_t fft_length,
+        uint32_t low_frequency, uint32_t high_frequency, bool dc_elimination,
+        uint16_t version)
+    {
+        if (out_features->cols != num_cepstral) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+
+        matrix_size_t mfe_matrix_size =
+            calculate_mfe_buffer_size(
+                signal_length,
+                sampling_frequency,
+                frame_length,
+                frame_stride,
+                num_filters,
+                version);
+
+        if (out_features->rows != mfe_matrix_size.rows) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+
+        EI_DSP_MATRIX(features_matrix, mfe_matrix_size.rows, mfe_matrix_size.cols);
+        if (!features_matrix.buffer) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+
+        EI_DSP_MATRIX(energy_matrix, mfe_matrix_size.rows, 1);
+        if (!energy_matrix.buffer) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+
+        int ret = mfe_i16(&features_matrix, &energy_matrix, signal, signal_offset, signal_length,
+            prev_sample, pre_cof, sampling_frequency, frame_length, frame_stride, num_filters, fft_length,
+            low_frequency, high_frequency, version);
+        if (ret != EIDSP_OK) {
+            EIDSP_ERR(ret);
+        }
+
+        return mfcc_from_mfe(out_features, &features_matrix, &energy_matrix, num_cepstral, dc_elimination);
+    }
+
     /**
      * Calculate the buffer size for MFCC
      * @param signal_length: Length of the signal.
@@ -583,6 +915,96 @@ public:
         size_matrix.cols = cols;
         return size_matrix;
     }
+
+private:
+    /**
+     * The FFT bins of the filter edges, filter i spans freq_index[i] to
+     * freq_index[i + 2] with its peak at freq_index[i + 1].
+     * @param freq_index Out buffer of num_filter + 2 values
+     * @returns EIDSP_OK if OK
+     */
+    static int filterbank_bins(int *freq_index,
+        uint16_t num_filter, int coefficients, uint32_t sampling_freq,
+        uint32_t low_freq, uint32_t high_freq)
+    {
+        const size_t mels_mem_size = (num_filter + 2) * sizeof(float);
+        const size_t hertz_mem_size = (num_filter + 2) * sizeof(float);
+
+        float *mels = (float*)ei_dsp_malloc(mels_mem_size);
+        if (!mels) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+
+        // Computing the Mel filterbank
+        // converting the upper and lower frequencies to Mels.
+        // num_filter + 2 is because for num_filter filterbanks we need
+        // num_filter+2 point.
+        numpy::linspace(
+            functions::frequency_to_mel(static_cast<float>(low_freq)),
+            functions::frequency_to_mel(static_cast<float>(high_freq)),
+            num_filter + 2,
+            mels);
+
+        // we should convert Mels back to Hertz because the start and end-points
+        // should be at the desired frequencies.
+        float *hertz = (float*)ei_dsp_malloc(hertz_mem_size);
+        if (!hertz) {
+            ei_dsp_free(mels, mels_mem_size);
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+        for (uint16_t ix = 0; ix < num_filter + 2; ix++) {
+            hertz[ix] = functions::mel_to_frequency(mels[ix]);
+            if (hertz[ix] < low_freq) {
+                hertz[ix] = low_freq;
+            }
+            if (hertz[ix] > high_freq) {
+                hertz[ix] = high_freq;
+            }
+
+            // here is a really annoying bug in Speechpy which calculates the frequency index wrong for the last bucket
+            // the last 'hertz' value is not 8,000 (with sampling rate 16,000) but 7,999.999999
+            // thus calculating the bucket to 64, not 65.
+            // we're adjusting this here a tiny bit to ensure we have the same result
+            if (ix == num_filter + 2 - 1) {
+                hertz[ix] -= 0.001;
+            }
+        }
+        ei_dsp_free(mels, mels_mem_size);
+
+        // The frequency resolution required to put filters at the
+        // exact points calculated above should be extracted.
+        //  So we should round those frequencies to the closest FFT bin.
+        for (uint16_t ix = 0; ix < num_filter + 2; ix++) {
+            freq_index[ix] = static_cast<int>(floor((coefficients + 1) * hertz[ix] / sampling_freq));
+        }
+        ei_dsp_free(hertz, hertz_mem_size);
+
+        return EIDSP_OK;
+    }
+
+    /**
+     * Weight of one bin in a filter, what `filterbanks` stores for it.
+     * Same as functions::triangle over the linspace of the filter's bins.
+     */
+    static float filterbank_weight(int bin, int left, int middle, int right)
+    {
+        float x = static_cast<float>(bin);
+        float weight = 0.0f;
+
+        if (x > left && x <= middle) {
+            weight = (x - left) / (middle - left);
+        }
+
+        if (x < right && middle <= x) {
+            weight = (right - x) / (right - middle);
+        }
+
+#if EIDSP_QUANTIZE_FILTERBANK
+        weight = numpy::dequantize_zero_one(numpy::quantize_zero_one(weight));
+#endif
+
+        return weight;
+    }
 };
 
 } // namespace speechpy
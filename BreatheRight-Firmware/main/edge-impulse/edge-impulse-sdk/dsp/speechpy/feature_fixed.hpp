@@ -0,0 +1,415 @@
+/* Edge Impulse inferencing library
+ * Copyright (c) 2021 EdgeImpulse Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _EIDSP_SPEECHPY_FEATURE_FIXED_H_
+#define _EIDSP_SPEECHPY_FEATURE_FIXED_H_
+
+#include <stdint.h>
+#include <math.h>
+#include <float.h>
+#include "feature.hpp"
+#include "../memory.hpp"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846264338327950288
+#endif // M_PI
+
+#ifndef M_LN2
+#define M_LN2 0.693147180559945309417232121458176568
+#endif // M_LN2
+
+namespace ei {
+namespace speechpy {
+
+/**
+ * Fixed point MFCC for int16 audio, for targets where the float MFCC is the
+ * bottleneck (select with EIDSP_MFCC_FIXED_POINT).
+ *
+ * Frames are preemphasized in Q15, block normalized, and transformed with a
+ * Q31 radix-2 real FFT that halves every stage. The power spectrum is block
+ * normalized to 32 bits per frame, the mel filterbank has Q15 weights and the
+ * log is taken in Q16 log2 with the block exponents added back, so no
+ * dynamic range is lost to the fixed point format. A Q30 table holds the
+ * orthonormal DCT-II (with ln(2) folded in) for the kept coefficients only.
+ * Only the final features are converted to float.
+ */
+class feature_fixed {
+public:
+    /**
+     * Base 2 logarithm of an unsigned value, in Q16. Uses a 64 entry table
+     * with linear interpolation, max error ~5e-5.
+     * @param value Value, must be > 0
+     */
+    static int32_t log2_q16(uint64_t value) {
+        static const int32_t table[65] = {
+            0, 1466, 2909, 4331, 5732, 7112, 8473, 9814,
+            11136, 12440, 13727, 14996, 16248, 17484, 18704, 19909,
+            21098, 22272, 23433, 24579, 25711, 26830, 27936, 29029,
+            30109, 31178, 32234, 33279, 34312, 35334, 36346, 37346,
+            38336, 39316, 40286, 41246, 42196, 43137, 44068, 44990,
+            45904, 46809, 47705, 48593, 49472, 50344, 51207, 52063,
+            52911, 53751, 54584, 55410, 56229, 57040, 57845, 58643,
+            59434, 60219, 60997, 61769, 62534, 63294, 64047, 64794,
+            65536
+        };
+
+        int exponent = 63 - __builtin_clzll(value);
+
+        // mantissa with the leading one at bit 31
+        uint32_t mantissa = exponent >= 31 ?
+            static_cast<uint32_t>(value >> (exponent - 31)) :
+            static_cast<uint32_t>(value << (31 - exponent));
+
+        uint32_t ix = (mantissa >> 25) & 63;
+        int32_t frac = static_cast<int32_t>((mantissa >> 9) & 0xffff);
+
+        return (exponent << 16) + table[ix] +
+            static_cast<int32_t>((static_cast<int64_t>(table[ix + 1] - table[ix]) * frac) >> 16);
+    }
+
+    /**
+     * Twiddle factors for `rfft_power`, W_N^k = cos - i sin for k < n_fft / 2
+     * @param twiddles Out buffer of n_fft values (cos, sin pairs) in Q31
+     * @param n_fft Number of FFT points
+     */
+    static void twiddles(int32_t *twiddles, size_t n_fft) {
+        for (size_t k = 0; k < n_fft / 2; k++) {
+            float phase = 2.0f * static_cast<float>(M_PI) * static_cast<float>(k) / static_cast<float>(n_fft);
+            twiddles[2 * k] = q31_from_float(cosf(phase));
+            twiddles[2 * k + 1] = q31_from_float(sinf(phase));
+        }
+    }
+
+    /**
+     * Power spectrum of a real Q31 frame. Every stage of the FFT is halved,
+     * so the output is |DFT(frame)|^2 / n_fft^2 in Q62. The frame should be
+     * block normalized below 2^30 so none of the stages can overflow.
+     * @param frame n_fft values, used as scratch
+     * @param n_fft Number of FFT points, power of 2
+     * @param twiddles From `twiddles`
+     * @param spectrum Out buffer of (n_fft / 2 + 1) complex values
+     * @param out_power Out buffer of n_fft / 2 + 1 values
+     */
+    static void rfft_power(int32_t *frame, size_t n_fft, const int32_t *twiddles,
+        int32_t *spectrum, uint64_t *out_power)
+    {
+        // the real frame as n_fft / 2 complex values
+        const size_t m = n_fft / 2;
+        int32_t *z = frame;
+
+        // bit reversal
+        for (size_t i = 1, j = 0; i < m; i++) {
+            size_t bit = m >> 1;
+            for (; j & bit; bit >>= 1) {
+                j ^= bit;
+            }
+            j ^= bit;
+            if (i < j) {
+                int32_t re = z[2 * i], im = z[2 * i + 1];
+                z[2 * i] = z[2 * j];
+                z[2 * i + 1] = z[2 * j + 1];
+                z[2 * j] = re;
+                z[2 * j + 1] = im;
+            }
+        }
+
+        // radix-2 butterflies, halving each stage
+        for (size_t len = 2; len <= m; len <<= 1) {
+            const size_t half = len >> 1;
+            const size_t step = n_fft / len;
+            for (size_t i = 0; i < m; i += len) {
+                for (size_t j = 0; j < half; j++) {
+                    const int32_t c = twiddles[2 * j * step];
+                    const int32_t s = twiddles[2 * j * step + 1];
+                    int32_t *a = &z[2 * (i + j)];
+                    int32_t *b = &z[2 * (i + j + half)];
+
+                    int32_t tr = q31_mul(b[0], c) + q31_mul(b[1], s);
+                    int32_t ti = q31_mul(b[1], c) - q31_mul(b[0], s);
+
+                    int32_t ar = a[0], ai = a[1];
+                    a[0] = static_cast<int32_t>((static_cast<int64_t>(ar) + tr) >> 1);
+                    a[1] = static_cast<int32_t>((static_cast<int64_t>(ai) + ti) >> 1);
+                    b[0] = static_cast<int32_t>((static_cast<int64_t>(ar) - tr) >> 1);
+                    b[1] = static_cast<int32_t>((static_cast<int64_t>(ai) - ti) >> 1);
+                }
+            }
+        }
+
+        // split the complex spectrum into the real one, halving again
+        spectrum[0] = static_cast<int32_t>((static_cast<int64_t>(z[0]) + z[1]) >> 1);
+        spectrum[1] = 0;
+        spectrum[2 * m] = static_cast<int32_t>((static_cast<int64_t>(z[0]) - z[1]) >> 1);
+        spectrum[2 * m + 1] = 0;
+
+        for (size_t k = 1; k < m; k++) {
+            const int32_t *zk = &z[2 * k];
+            const int32_t *zmk = &z[2 * (m - k)];
+
+            // even part (zk + conj(zmk)) / 4, odd part (zk - conj(zmk)) / (4i)
+            int32_t er = static_cast<int32_t>((static_cast<int64_t>(zk[0]) + zmk[0]) >> 2);
+            int32_t ei = static_cast<int32_t>((static_cast<int64_t>(zk[1]) - zmk[1]) >> 2);
+            int32_t or_ = static_cast<int32_t>((static_cast<int64_t>(zk[1]) + zmk[1]) >> 2);
+            int32_t oi = static_cast<int32_t>((static_cast<int64_t>(zmk[0]) - zk[0]) >> 2);
+
+            const int32_t c = twiddles[2 * k];
+            const int32_t s = twiddles[2 * k + 1];
+
+            spectrum[2 * k] = er + q31_mul(or_, c) + q31_mul(oi, s);
+            spectrum[2 * k + 1] = ei + q31_mul(oi, c) - q31_mul(or_, s);
+        }
+
+        for (size_t k = 0; k <= m; k++) {
+            int64_t re = spectrum[2 * k];
+            int64_t im = spectrum[2 * k + 1];
+            out_power[k] = static_cast<uint64_t>(re * re) + static_cast<uint64_t>(im * im);
+        }
+    }
+
+    /**
+     * Compute MFCC features from a range of an int16 audio signal in fixed point.
+     * Same parameters and framing as `feature::mfcc_i16`, which is the float
+     * reference for this function.
+     * @returns 0 if OK
+     */
+    static int mfcc(matrix_t *out_features, signal_i16_t *signal,
+        size_t signal_offset, size_t signal_length, int16_t prev_sample, float pre_cof,
+        uint32_t sampling_frequency, float frame_length, float frame_stride,
+        uint8_t num_cepstral, uint16_t num_filters, uint16_t fft_length,
+        uint32_t low_frequency, uint32_t high_frequency, bool dc_elimination,
+        uint16_t version)
+    {
+        int ret = 0;
+
+        if (version != 2) {
+            EIDSP_ERR(EIDSP_NOT_SUPPORTED);
+        }
+
+        if (fft_length < 4 || (fft_length & (fft_length - 1)) != 0) {
+            EIDSP_ERR(EIDSP_PARAMETER_INVALID);
+        }
+
+        if (out_features->cols != num_cepstral || num_cepstral > num_filters) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+
+        if (high_frequency == 0) {
+            high_frequency = sampling_frequency / 2;
+        }
+
+        if (low_frequency == 0) {
+            low_frequency = 300;
+        }
+
+        const size_t frame_sample_length = static_cast<size_t>(
+            processing::ceil_unless_very_close_to_floor(static_cast<float>(sampling_frequency) * frame_length));
+        const size_t frame_stride_values = static_cast<size_t>(
+            processing::ceil_unless_very_close_to_floor(static_cast<float>(sampling_frequency) * frame_stride));
+        const size_t num_frames = out_features->rows;
+
+        if (num_frames != static_cast<size_t>(processing::calculate_no_of_stack_frames(
+                signal_length, sampling_frequency, frame_length, frame_stride, false, version))) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+
+        const uint16_t coefficients = fft_length / 2 + 1;
+        const int log2_fft_length = 31 - __builtin_clz(fft_length);
+
+        stage_clock clock;
+
+        // mel weights in Q15, one run per filter
+        sparse_filterbank_t filterbanks;
+        ret = feature::sparse_filterbanks(
+            &filterbanks, num_filters, coefficients, sampling_frequency, low_frequency, high_frequency);
+        if (ret != 0) {
+            EIDSP_ERR(ret);
+        }
+
+        EI_DSP_i16_MATRIX(weights, 1, filterbanks.weights_size);
+        for (size_t ix = 0; ix < filterbanks.weights_size; ix++) {
+            weights.buffer[ix] = q15_from_float(filterbanks.weights[ix]);
+        }
+        clock.mark(EI_STAGE_FILTERBANK);
+
+        // orthonormal DCT-II rows for the kept coefficients, ln(2) folded in, Q30
+        EI_DSP_i32_MATRIX(dct, num_cepstral, num_filters);
+        for (size_t i = 0; i < num_cepstral; i++) {
+            float scale = static_cast<float>(M_LN2) *
+                sqrtf((i == 0 ? 1.0f : 2.0f) / static_cast<float>(num_filters));
+            for (size_t k = 0; k < num_filters; k++) {
+                float c = cosf(static_cast<float>(M_PI) * static_cast<float>(i) *
+                    static_cast<float>(2 * k + 1) / static_cast<float>(2 * num_filters));
+                dct.buffer[i * num_filters + k] = static_cast<int32_t>(roundf(scale * c * 1073741824.0f));
+            }
+        }
+        clock.mark(EI_STAGE_DCT);
+
+        EI_DSP_i32_MATRIX(tw, 1, fft_length);
+        twiddles(tw.buffer, fft_length);
+        clock.mark(EI_STAGE_FFT);
+
+        const int32_t pre_cof_q15 = static_cast<int32_t>(roundf(pre_cof * 32768.0f));
+
+        // the FFT truncates longer frames, so don't read what it would drop
+        const size_t read_length = frame_sample_length < fft_length ? frame_sample_length : fft_length;
+
+        // [0] holds the sample preceding the frame for the preemphasis
+        EI_DSP_i16_MATRIX(frame_i16, 1, read_length + 1);
+        EI_DSP_i32_MATRIX(frame, 1, fft_length);
+        EI_DSP_i32_MATRIX(spectrum, 1, 2 * coefficients);
+        EI_DSP_i32_MATRIX(power_q62, 1, 2 * coefficients);
+        EI_DSP_i32_MATRIX(power_q32, 1, coefficients);
+        EI_DSP_i32_MATRIX(log_mel, 1, num_filters);
+
+        // no 64 bit matrix type, these buffers are only ever accessed through these pointers
+        uint64_t *power = reinterpret_cast<uint64_t*>(power_q62.buffer);
+        uint32_t *power_u32 = reinterpret_cast<uint32_t*>(power_q32.buffer);
+
+        // log2 of the values the float path substitutes for zero mel energies (1e-10)
+        // and zero frame energies (FLT_EPSILON), in Q16
+        const int32_t log2_zero_mel_q16 = -2177059;
+        const int32_t log2_zero_energy_q16 = -23 * 65536;
+
+        for (size_t ix = 0; ix < num_frames; ix++) {
+            size_t frame_offset = signal_offset + ix * frame_stride_values;
+
+            if (ix == 0) {
+                frame_i16.buffer[0] = prev_sample;
+                ret = signal->get_data(frame_offset, read_length, frame_i16.buffer + 1);
+            }
+            else {
+                ret = signal->get_data(frame_offset - 1, read_length + 1, frame_i16.buffer);
+            }
+            if (ret != 0) {
+                EIDSP_ERR(ret);
+            }
+            clock.mark(EI_STAGE_FRAMING);
+
+            // preemphasis, x / 32768 in Q30 (fits in 31 bits for any cof < 1)
+            uint32_t max_abs = 0;
+            for (size_t i = 0; i < read_length; i++) {
+                int32_t v = (static_cast<int32_t>(frame_i16.buffer[i + 1]) << 15) -
+                    pre_cof_q15 * static_cast<int32_t>(frame_i16.buffer[i]);
+                frame.buffer[i] = v;
+                uint32_t a = v < 0 ? static_cast<uint32_t>(-static_cast<int64_t>(v)) : static_cast<uint32_t>(v);
+                if (a > max_abs) {
+                    max_abs = a;
+                }
+            }
+            for (size_t i = read_length; i < fft_length; i++) {
+                frame.buffer[i] = 0;
+            }
+
+            // block normalize so the peak is in [2^29, 2^30)
+            int norm_shift = 0;
+            if (max_abs > 0) {
+                norm_shift = 30 - (32 - __builtin_clz(max_abs));
+                for (size_t i = 0; i < read_length; i++) {
+                    frame.buffer[i] = norm_shift >= 0 ?
+                        static_cast<int32_t>(static_cast<uint32_t>(frame.buffer[i]) << norm_shift) :
+                        frame.buffer[i] >> -norm_shift;
+                }
+            }
+            clock.mark(EI_STAGE_PREEMPHASIS);
+
+            rfft_power(frame.buffer, fft_length, tw.buffer, spectrum.buffer, power);
+
+            // block normalize the power to 32 bits
+            uint64_t max_power = 0;
+            for (size_t k = 0; k < coefficients; k++) {
+                if (power[k] > max_power) {
+                    max_power = power[k];
+                }
+            }
+            int power_shift = 0;
+            if (max_power >> 32) {
+                power_shift = 32 - __builtin_clzll(max_power);
+            }
+
+            uint64_t energy = 0;
+            for (size_t k = 0; k < coefficients; k++) {
+                power_u32[k] = static_cast<uint32_t>(power[k] >> power_shift);
+                energy += power_u32[k];
+            }
+
+            // float power = power_u32 * 2^(power_shift + log2(N) - 60 - 2 * norm_shift)
+            const int32_t exponent_q16 = (power_shift + log2_fft_length - 60 - 2 * norm_shift) * 65536;
+            clock.mark(EI_STAGE_FFT);
+
+            const int16_t *w = weights.buffer;
+            for (size_t f = 0; f < num_filters; f++) {
+                const uint32_t *p = power_u32 + filterbanks.runs[2 * f];
+                const uint16_t length = filterbanks.runs[2 * f + 1];
+                uint64_t acc = 0;
+                for (size_t k = 0; k < length; k++) {
+                    acc += static_cast<uint64_t>(p[k]) * static_cast<uint16_t>(w[k]);
+                }
+                w += length;
+                log_mel.buffer[f] = acc == 0 ? log2_zero_mel_q16 :
+                    log2_q16(acc) - 15 * 65536 + exponent_q16;
+            }
+            clock.mark(EI_STAGE_FILTERBANK);
+
+            float *out_row = out_features->buffer + ix * num_cepstral;
+            for (size_t i = 0; i < num_cepstral; i++) {
+                const int32_t *d = dct.buffer + i * num_filters;
+                int64_t acc = 0;
+                for (size_t k = 0; k < num_filters; k++) {
+                    acc += static_cast<int64_t>(log_mel.buffer[k]) * d[k];
+                }
+                out_row[i] = static_cast<float>(acc) * (1.0f / 70368744177664.0f); // 2^46
+            }
+
+            // replace first cepstral coefficient with log of frame energy for DC elimination
+            if (dc_elimination) {
+                int32_t log_energy = energy == 0 ? log2_zero_energy_q16 :
+                    log2_q16(energy) + exponent_q16;
+                out_row[0] = static_cast<float>(log_energy) * (static_cast<float>(M_LN2) / 65536.0f);
+            }
+            clock.mark(EI_STAGE_DCT);
+        }
+
+        return EIDSP_OK;
+    }
+
+private:
+    static int32_t q31_mul(int32_t a, int32_t b) {
+        return static_cast<int32_t>((static_cast<int64_t>(a) * b) >> 31);
+    }
+
+    static int32_t q31_from_float(float v) {
+        if (v >= 1.0f) return INT32_MAX;
+        if (v <= -1.0f) return INT32_MIN;
+        return static_cast<int32_t>(roundf(v * 2147483648.0f));
+    }
+
+    static int16_t q15_from_float(float v) {
+        if (v >= 1.0f) return INT16_MAX;
+        if (v <= 0.0f) return 0;
+        return static_cast<int16_t>(roundf(v * 32768.0f));
+    }
+};
+
+} // namespace speechpy
+} // namespace ei
+
+#endif // _EIDSP_SPEECHPY_FEATURE_FIXED_H_
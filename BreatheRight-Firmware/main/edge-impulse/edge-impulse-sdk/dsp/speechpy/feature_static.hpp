@@ -0,0 +1,464 @@
+/* Edge Impulse inferencing library
+ * Copyright (c) 2021 EdgeImpulse Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _EIDSP_SPEECHPY_FEATURE_STATIC_H_
+#define _EIDSP_SPEECHPY_FEATURE_STATIC_H_
+
+#include <stdint.h>
+#include <float.h>
+#include "feature.hpp"
+#include "../constexpr_math.hpp"
+#include "../memory.hpp"
+
+namespace ei {
+namespace speechpy {
+
+/**
+ * Float MFCC for int16 audio, specialized at compile time for a single DSP
+ * config (select with EIDSP_MFCC_STATIC, the config comes from
+ * model_metadata.h).
+ *
+ * Everything `feature::mfcc_i16` builds on every call is a constexpr table
+ * here: the mel filterbank, stored sparsely as the bins between each
+ * filter's edges, the orthonormal DCT-II rows for the kept coefficients, the
+ * FFT twiddles and the bit reversal permutation. The filterbank is computed
+ * with the same float steps as `feature::filterbanks` (including the
+ * EIDSP_QUANTIZE_FILTERBANK rounding), so the mel weights are the same. The
+ * real FFT is a radix-2 FFT over FftLength / 2 complex points followed by
+ * the usual split, features match `feature::mfcc_i16` to float rounding.
+ */
+template <uint32_t SamplingFrequency, uint16_t NumFilters, uint16_t FftLength, uint8_t NumCepstral,
+    uint32_t LowFrequency, uint32_t HighFrequency>
+class feature_static {
+    static_assert(FftLength >= 4 && (FftLength & (FftLength - 1)) == 0, "FFT length must be a power of 2");
+    static_assert(NumFilters > 0 && NumCepstral <= NumFilters, "Need at least as many filters as cepstral coefficients");
+
+public:
+    /**
+     * Compute MFCC features from a range of an int16 audio signal. Same
+     * framing and preemphasis as `feature::mfcc_i16`, the rest of the config
+     * is fixed by the template parameters.
+     * Only implementation version 2 is supported.
+     * @returns 0 if OK
+     */
+    static int mfcc_i16(matrix_t *out_features, signal_i16_t *signal,
+        size_t signal_offset, size_t signal_length, int16_t prev_sample, float pre_cof,
+        float frame_length, float frame_stride, bool dc_elimination)
+    {
+        int ret = 0;
+
+        if (out_features->cols != NumCepstral) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+
+        const size_t frame_sample_length = static_cast<size_t>(
+            processing::ceil_unless_very_close_to_floor(static_cast<float>(SamplingFrequency) * frame_length));
+        const size_t frame_stride_values = static_cast<size_t>(
+            processing::ceil_unless_very_close_to_floor(static_cast<float>(SamplingFrequency) * frame_stride));
+        const size_t num_frames = out_features->rows;
+
+        if (num_frames != static_cast<size_t>(processing::calculate_no_of_stack_frames(
+                signal_length, SamplingFrequency, frame_length, frame_stride, false, 2))) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+
+        frame_job job;
+        job.out_features = out_features;
+        job.signal = signal;
+        job.signal_offset = signal_offset;
+        job.frame_stride_values = frame_stride_values;
+        // the FFT truncates longer frames, so don't read what it would drop
+        job.read_length = frame_sample_length < FftLength ? frame_sample_length : FftLength;
+        job.prev_sample = prev_sample;
+        job.pre_cof = pre_cof;
+        job.dc_elimination = dc_elimination;
+
+#if EIDSP_MFCC_PARALLEL
+        const int workers = num_frames > 1 ? ei_dsp_workers() : 1;
+#else
+        const int workers = 1;
+#endif
+
+        // a row per worker: the frame with the sample preceding it in [0] for
+        // the preemphasis, and the FFT frame, power spectrum and log mel energies
+        EI_DSP_i16_MATRIX(frame_i16, workers, job.read_length + 1);
+        EI_DSP_MATRIX(frame_scratch, workers, scratch_size);
+        job.frame_i16 = &frame_i16;
+        job.frame_scratch = &frame_scratch;
+
+#if EIDSP_MFCC_PARALLEL
+        if (workers > 1) {
+            ret = ei_dsp_parallel_for(num_frames, &run_frames, &job);
+        }
+        else
+#endif
+        {
+            stage_clock clock;
+            ret = frames(&job, 0, num_frames, 0, clock);
+        }
+        if (ret != 0) {
+            EIDSP_ERR(ret);
+        }
+
+        return EIDSP_OK;
+    }
+
+    /**
+     * Power spectrum |DFT(frame)|^2 / FftLength of a real frame, see
+     * `processing::power_spectrum`.
+     * @param frame FftLength values, used as scratch
+     * @param out_power Out buffer of FftLength / 2 + 1 values
+     */
+    static void rfft_power(float *frame, float *out_power)
+    {
+        typedef cx::table<twiddle_generator, FftLength> twiddles;
+        typedef cx::table<bit_reverse_generator, FftLength / 2> bit_reverse;
+
+        // the real frame as FftLength / 2 complex values
+        const size_t m = FftLength / 2;
+        float *z = frame;
+
+        for (size_t i = 1; i < m; i++) {
+            const size_t j = bit_reverse::data[i];
+            if (i < j) {
+                float re = z[2 * i], im = z[2 * i + 1];
+                z[2 * i] = z[2 * j];
+                z[2 * i + 1] = z[2 * j + 1];
+                z[2 * j] = re;
+                z[2 * j + 1] = im;
+            }
+        }
+
+        // radix-2 butterflies, W_len^j = W_FftLength^(j * FftLength / len)
+        for (size_t len = 2; len <= m; len <<= 1) {
+            const size_t half = len >> 1;
+            const size_t step = FftLength / len;
+            for (size_t i = 0; i < m; i += len) {
+                for (size_t j = 0; j < half; j++) {
+                    const float c = twiddles::data[2 * j * step];
+                    const float s = twiddles::data[2 * j * step + 1];
+                    float *a = &z[2 * (i + j)];
+                    float *b = &z[2 * (i + j + half)];
+
+                    float tr = b[0] * c + b[1] * s;
+                    float ti = b[1] * c - b[0] * s;
+
+                    b[0] = a[0] - tr;
+                    b[1] = a[1] - ti;
+                    a[0] += tr;
+                    a[1] += ti;
+                }
+            }
+        }
+
+        // split the complex spectrum into the real one
+        const float scale = 1.0f / static_cast<float>(FftLength);
+        out_power[0] = (z[0] + z[1]) * (z[0] + z[1]) * scale;
+        out_power[m] = (z[0] - z[1]) * (z[0] - z[1]) * scale;
+
+        for (size_t k = 1; k < m; k++) {
+            const float *zk = &z[2 * k];
+            const float *zmk = &z[2 * (m - k)];
+
+            // even part (zk + conj(zmk)) / 2, odd part (zk - conj(zmk)) / (2i)
+            float er = 0.5f * (zk[0] + zmk[0]);
+            float ei = 0.5f * (zk[1] - zmk[1]);
+            float or_ = 0.5f * (zk[1] + zmk[1]);
+            float oi = 0.5f * (zmk[0] - zk[0]);
+
+            const float c = twiddles::data[2 * k];
+            const float s = twiddles::data[2 * k + 1];
+
+            float re = er + or_ * c + oi * s;
+            float im = ei + oi * c - or_ * s;
+            out_power[k] = (re * re + im * im) * scale;
+        }
+    }
+
+private:
+    // floats of scratch a worker needs per frame, see frames()
+    static constexpr size_t scratch_size = FftLength + (FftLength / 2 + 1) + NumFilters;
+
+    /** Everything frames() needs to compute any frame of one mfcc_i16 call */
+    struct frame_job {
+        matrix_t *out_features;
+        signal_i16_t *signal;
+        size_t signal_offset;
+        size_t frame_stride_values;
+        size_t read_length;
+        int16_t prev_sample;
+        float pre_cof;
+        bool dc_elimination;
+        matrix_i16_t *frame_i16;
+        matrix_t *frame_scratch;
+    };
+
+    /**
+     * ei_dsp_work_fn of mfcc_i16. Only the calling task charges the stage
+     * times, so with more than one worker they are the time the frames of
+     * the slice kept the caller busy.
+     */
+    static int run_frames(void *ctx, size_t first, size_t last, int worker)
+    {
+        const frame_job *job = static_cast<const frame_job *>(ctx);
+
+        if (worker == 0) {
+            stage_clock clock;
+            return frames(job, first, last, worker, clock);
+        }
+        idle_stage_clock clock;
+        return frames(job, first, last, worker, clock);
+    }
+
+    /**
+     * Compute frames [first, last) into their rows of the features, using
+     * the scratch rows of `worker`. A frame only reads the signal and the
+     * constant tables, so the result does not depend on which worker
+     * computes it or in which order.
+     * @returns 0 if OK
+     */
+    template <typename Clock>
+    static int frames(const frame_job *job, size_t first, size_t last, int worker, Clock &clock)
+    {
+        typedef cx::table<bin_generator, NumFilters + 2> bins;
+        typedef cx::table<weight_generator, filter_offset(NumFilters)> weights;
+        typedef cx::table<dct_generator, NumCepstral * NumFilters> dct;
+
+        const size_t read_length = job->read_length;
+        int16_t *frame_i16 = job->frame_i16->buffer + worker * job->frame_i16->cols;
+        float *fft_frame = job->frame_scratch->buffer + worker * job->frame_scratch->cols;
+        float *power_spectrum_frame = fft_frame + FftLength;
+        float *log_mel = power_spectrum_frame + FftLength / 2 + 1;
+
+        for (size_t ix = first; ix < last; ix++) {
+            size_t frame_offset = job->signal_offset + ix * job->frame_stride_values;
+            int ret;
+
+            if (ix == 0) {
+                frame_i16[0] = job->prev_sample;
+                ret = job->signal->get_data(frame_offset, read_length, frame_i16 + 1);
+            }
+            else {
+                ret = job->signal->get_data(frame_offset - 1, read_length + 1, frame_i16);
+            }
+            if (ret != 0) {
+                return ret;
+            }
+            clock.mark(EI_STAGE_FRAMING);
+
+            for (size_t i = 0; i < read_length; i++) {
+                fft_frame[i] = (static_cast<float>(frame_i16[i + 1]) -
+                    (job->pre_cof * static_cast<float>(frame_i16[i]))) * (1.0f / 32768.0f);
+            }
+            for (size_t i = read_length; i < FftLength; i++) {
+                fft_frame[i] = 0.0f;
+            }
+            clock.mark(EI_STAGE_PREEMPHASIS);
+
+            rfft_power(fft_frame, power_spectrum_frame);
+            clock.mark(EI_STAGE_FFT);
+
+            float energy = numpy::sum(power_spectrum_frame, FftLength / 2 + 1);
+            if (energy == 0) {
+                energy = FLT_EPSILON;
+            }
+
+            // log mel energies, the filterbank only holds the bins from each
+            // filter's left to its right edge
+            const float *w = weights::data;
+            for (size_t i = 0; i < NumFilters; i++) {
+                const float *power = power_spectrum_frame + bins::data[i];
+                const int width = bins::data[i + 2] - bins::data[i] + 1;
+                float mel = 0.0f;
+                for (int k = 0; k < width; k++) {
+                    mel += power[k] * w[k];
+                }
+                w += width;
+                log_mel[i] = numpy::log(mel == 0 ? FLT_EPSILON : mel);
+            }
+            clock.mark(EI_STAGE_FILTERBANK);
+
+            // DCT-II, only the coefficients that are kept
+            float *out_row = job->out_features->buffer + ix * NumCepstral;
+            for (size_t i = job->dc_elimination ? 1 : 0; i < NumCepstral; i++) {
+                const float *d = dct::data + i * NumFilters;
+                float acc = 0.0f;
+                for (size_t k = 0; k < NumFilters; k++) {
+                    acc += d[k] * log_mel[k];
+                }
+                out_row[i] = acc;
+            }
+
+            // replace first cepstral coefficient with log of frame energy for DC elimination
+            if (job->dc_elimination) {
+                out_row[0] = numpy::log(energy);
+            }
+            clock.mark(EI_STAGE_DCT);
+        }
+
+        return 0;
+    }
+
+    // same defaults as feature::mfe_i16
+    static constexpr uint32_t low_frequency() {
+        return LowFrequency == 0 ? 300 : LowFrequency;
+    }
+
+    static constexpr uint32_t high_frequency() {
+        return HighFrequency == 0 ? SamplingFrequency / 2 : HighFrequency;
+    }
+
+    // functions::frequency_to_mel and mel_to_frequency, rounded to float at the same steps
+    static constexpr float frequency_to_mel(float f) {
+        return static_cast<float>(1127.0 * static_cast<float>(cx::log(1 + f / 700.0f)));
+    }
+
+    static constexpr float mel_to_frequency(float mel) {
+        return 700.0f * (static_cast<float>(cx::exp(mel / 1127.0f)) - 1.0f);
+    }
+
+    // numpy::linspace over the mel range, num_filter + 2 points
+    static constexpr float mel_point(uint32_t ix) {
+        return ix == NumFilters + 1u ?
+            frequency_to_mel(static_cast<float>(high_frequency())) :
+            frequency_to_mel(static_cast<float>(low_frequency())) + static_cast<float>(ix) *
+                ((frequency_to_mel(static_cast<float>(high_frequency())) -
+                  frequency_to_mel(static_cast<float>(low_frequency()))) / static_cast<float>(NumFilters + 1));
+    }
+
+    static constexpr float clamp_hertz(float hertz) {
+        return hertz < low_frequency() ? static_cast<float>(low_frequency()) :
+            hertz > high_frequency() ? static_cast<float>(high_frequency()) :
+            hertz;
+    }
+
+    // filter edges as FFT bins, including the last bucket adjustment in feature::filterbanks
+    static constexpr int bin(uint32_t ix) {
+        return static_cast<int>(cx::floor((FftLength / 2 + 2) *
+            (ix == NumFilters + 1u ?
+                static_cast<float>(clamp_hertz(mel_to_frequency(mel_point(ix))) - 0.001) :
+                clamp_hertz(mel_to_frequency(mel_point(ix)))) / SamplingFrequency));
+    }
+
+    // start of filter f in the sparse filterbank
+    static constexpr size_t filter_offset(uint32_t f) {
+        return f == 0 ? 0 :
+            filter_offset(f - 1) + cx::table<bin_generator, NumFilters + 2>::data[f + 1] -
+                cx::table<bin_generator, NumFilters + 2>::data[f - 1] + 1;
+    }
+
+    static constexpr uint32_t filter_of(size_t w, uint32_t f) {
+        return w < filter_offset(f + 1) ? f : filter_of(w, f + 1);
+    }
+
+    // functions::triangle
+    static constexpr float triangle(float x, int left, int middle, int right) {
+        return x < right && middle <= x ? (right - x) / (right - middle) :
+            x > left && x <= middle ? (x - left) / (middle - left) :
+            0.0f;
+    }
+
+#if EIDSP_QUANTIZE_FILTERBANK
+    // the binary search in numpy::quantize_zero_one, returns the dequantized value
+    static constexpr float quantize_search(float value, int lo, int hi) {
+        return lo > hi ?
+            ((quantized_values_one_zero[lo] - value) < (value - quantized_values_one_zero[hi]) ?
+                quantized_values_one_zero[lo] : quantized_values_one_zero[hi]) :
+            value < quantized_values_one_zero[(hi + lo) / 2] ? quantize_search(value, lo, (hi + lo) / 2 - 1) :
+            value > quantized_values_one_zero[(hi + lo) / 2] ? quantize_search(value, (hi + lo) / 2 + 1, hi) :
+            value;
+    }
+
+    static constexpr float quantize(float value) {
+        return value <= quantized_values_one_zero[0] ? quantized_values_one_zero[0] :
+            value >= 1.0f ? 1.0f :
+            quantize_search(value, 0, sizeof(quantized_values_one_zero) / sizeof(float) - 1);
+    }
+#else
+    static constexpr float quantize(float value) {
+        return value;
+    }
+#endif // EIDSP_QUANTIZE_FILTERBANK
+
+    static constexpr float weight_in_filter(size_t w, uint32_t f) {
+        return quantize(triangle(
+            static_cast<float>(cx::table<bin_generator, NumFilters + 2>::data[f] + static_cast<int>(w - filter_offset(f))),
+            cx::table<bin_generator, NumFilters + 2>::data[f],
+            cx::table<bin_generator, NumFilters + 2>::data[f + 1],
+            cx::table<bin_generator, NumFilters + 2>::data[f + 2]));
+    }
+
+    static constexpr uint16_t reverse_bits(uint16_t value, uint16_t bits) {
+        return bits == 0 ? 0 : ((value & 1) << (bits - 1)) | reverse_bits(value >> 1, bits - 1);
+    }
+
+    static constexpr uint16_t log2(uint16_t value) {
+        return value <= 1 ? 0 : 1 + log2(value >> 1);
+    }
+
+    struct bin_generator {
+        typedef int16_t value_type;
+        static constexpr int16_t get(size_t ix) {
+            return static_cast<int16_t>(bin(ix));
+        }
+    };
+
+    // mel weights, filter after filter
+    struct weight_generator {
+        typedef float value_type;
+        static constexpr float get(size_t w) {
+            return weight_in_filter(w, filter_of(w, 0));
+        }
+    };
+
+    // orthonormal DCT-II, row i holds coefficient i
+    struct dct_generator {
+        typedef float value_type;
+        static constexpr float get(size_t ix) {
+            return static_cast<float>(cx::sqrt((ix < NumFilters ? 1.0 : 2.0) / NumFilters) *
+                cx::cos(cx::pi * (ix / NumFilters) * (2 * (ix % NumFilters) + 1) / (2.0 * NumFilters)));
+        }
+    };
+
+    // cos, sin pairs of 2 pi k / FftLength for k < FftLength / 2
+    struct twiddle_generator {
+        typedef float value_type;
+        static constexpr float get(size_t ix) {
+            return static_cast<float>(ix % 2 == 0 ?
+                cx::cos(2 * cx::pi * (ix / 2) / FftLength) :
+                cx::sin(2 * cx::pi * (ix / 2) / FftLength));
+        }
+    };
+
+    // bit reversal permutation of FftLength / 2 points
+    struct bit_reverse_generator {
+        typedef uint16_t value_type;
+        static constexpr uint16_t get(size_t ix) {
+            return reverse_bits(ix, log2(FftLength / 2));
+        }
+    };
+};
+
+} // namespace speechpy
+} // namespace ei
+
+#endif // _EIDSP_SPEECHPY_FEATURE_STATIC_H_
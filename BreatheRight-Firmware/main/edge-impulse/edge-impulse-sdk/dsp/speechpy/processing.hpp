@@ -408,6 +408,9 @@ namespace processing {
             EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
         }
 
+#if EIDSP_FUSED_POWER_SPECTRUM
+        return numpy::rfft_power(frame, frame_size, out_buffer, out_buffer_size, fft_points);
+#else
         int r = numpy::rfft(frame, frame_size, out_buffer, out_buffer_size, fft_points);
         if (r != EIDSP_OK) {
             return r;
@@ -419,6 +422,7 @@ namespace processing {
         }
 
         return EIDSP_OK;
+#endif
     }
 
     /**
@@ -507,6 +511,187 @@ namespace processing {
         return EIDSP_OK;
     }
 
+    /**
+     * Row in the input for a row in the symmetrically padded input, as produced
+     * by numpy::pad_1d_symmetric (edges repeated, reflecting as often as needed)
+     * @param ix Row relative to the start of the input, may be out of range
+     * @param rows Number of rows in the input
+     */
+    static int symmetric_index(int ix, int rows) {
+        int period = rows * 2;
+        int m = ix % period;
+        if (m < 0) {
+            m += period;
+        }
+        return m < rows ? m : period - 1 - m;
+    }
+
+    /**
+     * Store of `cmvnw_sliding_i8`. Collects the normalized features of a column in
+     * a small local buffer and quantizes them a chunk at a time: the int8 stores
+     * may alias anything, done per feature they would force the CMVN to reload
+     * its state after every one.
+     */
+    class quantize_store {
+    public:
+        quantize_store(int8_t *out, size_t rows, size_t cols, float scale, int32_t zero_point)
+            : out(out), rows(static_cast<int>(rows)), cols(cols), scale(scale), zero_point(zero_point), count(0) { }
+
+        void operator()(int row, size_t col, float value) {
+            chunk[count++] = value;
+            if (count == chunk_rows || row == rows - 1) {
+                int8_t *dst = out + (row + 1 - count) * cols + col;
+                for (int ix = 0; ix < count; ix++) {
+                    float q = round(chunk[ix] / scale) + zero_point;
+                    // saturate like the TFLite quantize op, a normalized outlier must not wrap around
+                    if (q < -128.0f) q = -128.0f;
+                    else if (q > 127.0f) q = 127.0f;
+                    dst[ix * cols] = static_cast<int8_t>(q);
+                }
+                count = 0;
+            }
+        }
+
+    private:
+        static const int chunk_rows = 32;
+
+        int8_t *out;
+        int rows;
+        size_t cols;
+        float scale;
+        int32_t zero_point;
+        float chunk[chunk_rows];
+        int count;
+    };
+
+    /**
+     * Sliding window CMVN of `cmvnw_sliding` and `cmvnw_sliding_i8`, hands every
+     * normalized feature to store(row, col, value) rather than writing it. A
+     * column is produced top to bottom before the next one starts.
+     */
+    template <typename Store>
+    static int cmvnw_sliding_store(const matrix_t *features_matrix, uint16_t win_size, bool variance_normalization,
+        Store store)
+    {
+        const int rows = static_cast<int>(features_matrix->rows);
+        const size_t cols = features_matrix->cols;
+        const int pad_size = (win_size - 1) / 2;
+        const float win = static_cast<float>(win_size);
+
+        if (rows == 0) {
+            EIDSP_ERR(EIDSP_INPUT_MATRIX_EMPTY);
+        }
+
+        for (size_t col = 0; col < cols; col++) {
+            const float *in = features_matrix->buffer + col;
+
+            // sums are taken relative to the column mean to keep the variance accurate
+            float offset = 0.0f;
+            for (int row = 0; row < rows; row++) {
+                offset += in[row * cols];
+            }
+            offset /= static_cast<float>(rows);
+
+            // window for row 0 covers padded rows -pad_size .. win_size - pad_size - 1
+            float sum = 0.0f;
+            float sum_sq = 0.0f;
+            for (int ix = -pad_size; ix < win_size - pad_size; ix++) {
+                float d = in[symmetric_index(ix, rows) * cols] - offset;
+                sum += d;
+                sum_sq += d * d;
+            }
+
+            for (int row = 0; row < rows; row++) {
+                float mean = sum / win;
+                float value;
+
+                if (variance_normalization) {
+                    float mean_sq = sum_sq / win;
+                    float variance = mean_sq - (mean * mean);
+
+                    // little variance left after the subtraction, so the running sums are
+                    // mostly rounding error here, rescan this window like cmvnw does. Both
+                    // running sums restart from the rescan, the next rows slide on from it.
+                    if (variance < mean_sq * 0.1f) {
+                        sum = 0.0f;
+                        sum_sq = 0.0f;
+                        for (int ix = row - pad_size; ix < row + win_size - pad_size; ix++) {
+                            float d = in[symmetric_index(ix, rows) * cols] - offset;
+                            sum += d;
+                            sum_sq += d * d;
+                        }
+                        mean = sum / win;
+
+                        variance = 0.0f;
+                        for (int ix = row - pad_size; ix < row + win_size - pad_size; ix++) {
+                            float d = in[symmetric_index(ix, rows) * cols] - offset - mean;
+                            variance += d * d;
+                        }
+                        variance /= win;
+                    }
+                    value = (in[row * cols] - offset - mean) / (sqrt(variance) + FLT_EPSILON);
+                }
+                else {
+                    value = in[row * cols] - offset - mean;
+                }
+                store(row, col, value);
+
+                // slide the window down by one row
+                float d_out = in[symmetric_index(row - pad_size, rows) * cols] - offset;
+                float d_in = in[symmetric_index(row + win_size - pad_size, rows) * cols] - offset;
+                sum += d_in - d_out;
+                sum_sq += (d_in * d_in) - (d_out * d_out);
+            }
+        }
+
+        return EIDSP_OK;
+    }
+
+    /**
+     * Same as `cmvnw` (without scale), but in O(rows + win_size) per column rather
+     * than O(rows * win_size), and without allocating. The window mean and variance
+     * are kept as running sums that slide one row at a time, the symmetric padding
+     * is resolved by index instead of being copied.
+     * @param features_matrix input feature matrix
+     * @param out_matrix normalized features, same size as the input, must not alias it
+     * @param win_size The size of sliding window for local normalization.
+     * @param variance_normalization If the variance normilization should
+     *   be performed or not.
+     * @returns 0 if OK
+     */
+    static int cmvnw_sliding(const matrix_t *features_matrix, matrix_t *out_matrix, uint16_t win_size = 301,
+        bool variance_normalization = false)
+    {
+        if (out_matrix->rows != features_matrix->rows || out_matrix->cols != features_matrix->cols) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+
+        float *out = out_matrix->buffer;
+        const size_t cols = out_matrix->cols;
+        return cmvnw_sliding_store(features_matrix, win_size, variance_normalization,
+            [out, cols](int row, size_t col, float value) { out[row * cols + col] = value; });
+    }
+
+    /**
+     * Same as `cmvnw_sliding`, but the normalized features are quantized as they
+     * are produced, e.g. straight into the int8 input tensor of a model, so there
+     * is no float copy of them.
+     * @param features_matrix input feature matrix
+     * @param out rows * cols quantized features, same layout as the input
+     * @param scale quantization scale of out
+     * @param zero_point quantization zero point of out
+     * @param win_size The size of sliding window for local normalization.
+     * @param variance_normalization If the variance normilization should
+     *   be performed or not.
+     * @returns 0 if OK
+     */
+    static int cmvnw_sliding_i8(const matrix_t *features_matrix, int8_t *out, float scale, int32_t zero_point,
+        uint16_t win_size = 301, bool variance_normalization = false)
+    {
+        quantize_store store(out, features_matrix->rows, features_matrix->cols, scale, zero_point);
+        return cmvnw_sliding_store(features_matrix, win_size, variance_normalization, store);
+    }
+
     /**
      * Perform normalization for MFE frames, this converts the signal to dB,
      * then add a hard filter, and quantize / dequantize the output
@@ -25,6 +25,8 @@
 
 #include "../config.hpp"
 #include "feature.hpp"
+#include "feature_fixed.hpp"
+#include "feature_static.hpp"
 #include "functions.hpp"
 #include "processing.hpp"
 
@@ -0,0 +1,76 @@
+/* Edge Impulse inferencing library
+ * Copyright (c) 2021 EdgeImpulse Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _EIDSP_STAGE_CLOCK_H_
+#define _EIDSP_STAGE_CLOCK_H_
+
+#include <stdint.h>
+#include "config.hpp"
+#include "../porting/ei_classifier_porting.h"
+
+namespace ei {
+
+/**
+ * Splits a stretch of code into consecutive stages: every mark() charges the
+ * time since the previous mark (or since the clock was created) to a stage
+ * with ei_add_stage_time(), one timer read per mark. Compiles to nothing
+ * unless EIDSP_PROFILE_STAGES is set.
+ */
+class stage_clock {
+public:
+#if EIDSP_PROFILE_STAGES
+    stage_clock() : last(now()) { }
+
+    void mark(ei_stage_t stage) {
+        uint32_t t = now();
+        // 32 bit difference, the microsecond timer may wrap between marks
+        ei_add_stage_time(stage, t - last);
+        last = t;
+    }
+
+private:
+    static uint32_t now() {
+        return static_cast<uint32_t>(ei_read_timer_us());
+    }
+
+    uint32_t last;
+#else
+    void mark(ei_stage_t stage) {
+        (void)stage;
+    }
+#endif // EIDSP_PROFILE_STAGES
+};
+
+/**
+ * A stage_clock that charges nothing, for code running outside the task that
+ * owns the stage times (ei_add_stage_time is not thread safe).
+ */
+class idle_stage_clock {
+public:
+    void mark(ei_stage_t stage) {
+        (void)stage;
+    }
+};
+
+} // namespace ei
+
+#endif // _EIDSP_STAGE_CLOCK_H_
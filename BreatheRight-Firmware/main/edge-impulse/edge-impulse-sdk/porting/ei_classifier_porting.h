@@ -111,6 +111,115 @@ void *ei_calloc(size_t nitems, size_t size);
  */
 void ei_free(void *ptr);
 
+/**
+ * Where ei_malloc / ei_calloc (and so ei_aligned_malloc) place new buffers.
+ * The placement functions below are provided by ports with more than one
+ * heap (ESP32 with PSRAM).
+ */
+typedef enum {
+    EI_MEM_DEFAULT = 0,     // wherever malloc() decides
+    EI_MEM_INTERNAL = 1,    // internal RAM, external RAM only if that fails
+    EI_MEM_EXTERNAL = 2     // external RAM (e.g. PSRAM), internal if that fails
+} ei_mem_placement_t;
+
+/**
+ * Counters of where allocations landed since the last ei_reset_mem_report()
+ */
+typedef struct {
+    uint32_t internal_allocs;
+    uint32_t external_allocs;
+    uint32_t fallback_allocs;   // landed outside the requested placement
+    uint32_t failed_allocs;
+    size_t internal_bytes;
+    size_t external_bytes;
+    size_t largest_alloc;
+} ei_mem_report_t;
+
+/**
+ * Select the placement of subsequent allocations, applies to all callers
+ * until changed
+ *
+ * @return the previous placement
+ */
+ei_mem_placement_t ei_set_mem_placement(ei_mem_placement_t placement);
+
+/**
+ * Copy the allocation counters into report
+ */
+void ei_get_mem_report(ei_mem_report_t *report);
+
+/**
+ * Clear the allocation counters
+ */
+void ei_reset_mem_report(void);
+
+/**
+ * Stages of the audio pipeline timed when EIDSP_PROFILE_STAGES is set
+ */
+typedef enum {
+    EI_STAGE_PREEMPHASIS = 0,
+    EI_STAGE_FRAMING,
+    EI_STAGE_FFT,
+    EI_STAGE_FILTERBANK,    // power spectrum to log mel energies
+    EI_STAGE_DCT,
+    EI_STAGE_CMVN,          // normalization and copy into the input tensor
+    EI_STAGE_INVOKE,
+    EI_STAGE_POSTPROCESS,   // output tensor to scores, moving average filter
+    EI_STAGE_COUNT
+} ei_stage_t;
+
+/**
+ * Microseconds spent in each stage since the last ei_reset_stage_times()
+ */
+typedef struct {
+    uint32_t us[EI_STAGE_COUNT];
+    uint32_t ran;               // bit per stage charged at all, a stage can take 0 us
+} ei_stage_times_t;
+
+/**
+ * Add to the time spent in a stage, called by ei::stage_clock
+ */
+void ei_add_stage_time(ei_stage_t stage, uint32_t us);
+
+/**
+ * Copy the stage times into times
+ */
+void ei_get_stage_times(ei_stage_times_t *times);
+
+/**
+ * Clear the stage times
+ */
+void ei_reset_stage_times(void);
+
+/**
+ * One share of a loop run by ei_dsp_parallel_for: items [first, last) on
+ * DSP worker `worker` (0 is the calling task)
+ *
+ * @return 0 if OK
+ */
+typedef int (*ei_dsp_work_fn)(void *ctx, size_t first, size_t last, int worker);
+
+/**
+ * Run fn over items [0, count) split between the DSP workers, and return when
+ * all of them are done. Items must be independent of each other. One caller
+ * at a time. Ports without workers run fn(ctx, 0, count, 0) on the caller.
+ *
+ * @return the first non-zero result of fn, 0 if OK
+ */
+int ei_dsp_parallel_for(size_t count, ei_dsp_work_fn fn, void *ctx);
+
+/**
+ * Number of workers ei_dsp_parallel_for splits between, the caller included
+ */
+int ei_dsp_workers(void);
+
+/**
+ * Use at most n workers (1 keeps everything on the caller)
+ *
+ * @return the previous limit
+ */
+int ei_set_dsp_workers(int n);
+
 #if defined(__cplusplus) && EI_C_LINKAGE == 1
 }
 #endif // defined(__cplusplus) && EI_C_LINKAGE == 1
@@ -25,8 +25,13 @@
 
 #include <stdarg.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "soc/soc_memory_layout.h"
 
 
 #define EI_WEAK_FN __attribute__((weak))
@@ -62,12 +67,109 @@ __attribute__((weak)) void ei_printf_float(float f) {
     ei_printf("%f", f);
 }
 
+static const char *MEM_TAG = "ei_mem";
+static ei_mem_placement_t mem_placement = EI_MEM_DEFAULT;
+static ei_mem_report_t mem_report;
+
+/**
+ * Allocate according to the current placement. heap_caps_calloc zeroes the
+ * buffer, so malloc and calloc share this path.
+ */
+static void *mem_alloc_placed(size_t size, bool zero) {
+    ei_mem_placement_t placement = mem_placement;
+    void *ptr = NULL;
+
+    if (placement == EI_MEM_INTERNAL || placement == EI_MEM_EXTERNAL) {
+        uint32_t caps = (placement == EI_MEM_INTERNAL ? MALLOC_CAP_INTERNAL : MALLOC_CAP_SPIRAM) | MALLOC_CAP_8BIT;
+        ptr = zero ? heap_caps_calloc(1, size, caps) : heap_caps_malloc(size, caps);
+    }
+    if (ptr == NULL) {
+        ptr = zero ? calloc(1, size) : malloc(size);
+    }
+
+    if (ptr == NULL) {
+        mem_report.failed_allocs++;
+        ESP_LOGD(MEM_TAG, "%u bytes: failed", (unsigned)size);
+        return NULL;
+    }
+
+    bool external = esp_ptr_external_ram(ptr);
+    if (external) {
+        mem_report.external_allocs++;
+        mem_report.external_bytes += size;
+    }
+    else {
+        mem_report.internal_allocs++;
+        mem_report.internal_bytes += size;
+    }
+    bool fallback = (placement == EI_MEM_INTERNAL && external) || (placement == EI_MEM_EXTERNAL && !external);
+    if (fallback) {
+        mem_report.fallback_allocs++;
+    }
+    if (size > mem_report.largest_alloc) {
+        mem_report.largest_alloc = size;
+    }
+    ESP_LOGD(MEM_TAG, "%u bytes: %s%s (%p)", (unsigned)size, external ? "external" : "internal",
+        fallback ? ", fallback" : "", ptr);
+
+    return ptr;
+}
+
+ei_mem_placement_t ei_set_mem_placement(ei_mem_placement_t placement) {
+    ei_mem_placement_t previous = mem_placement;
+    mem_placement = placement;
+    return previous;
+}
+
+void ei_get_mem_report(ei_mem_report_t *report) {
+    *report = mem_report;
+}
+
+void ei_reset_mem_report(void) {
+    memset(&mem_report, 0, sizeof(mem_report));
+}
+
+static ei_stage_times_t stage_times;
+
+void ei_add_stage_time(ei_stage_t stage, uint32_t us) {
+    stage_times.us[stage] += us;
+    stage_times.ran |= 1u << stage;
+}
+
+void ei_get_stage_times(ei_stage_times_t *times) {
+    *times = stage_times;
+}
+
+void ei_reset_stage_times(void) {
+    memset(&stage_times, 0, sizeof(stage_times));
+}
+
+/**
+ * No DSP workers, everything runs on the caller. The firmware overrides these
+ * with a worker on the other core.
+ */
+EI_WEAK_FN int ei_dsp_parallel_for(size_t count, ei_dsp_work_fn fn, void *ctx) {
+    return fn(ctx, 0, count, 0);
+}
+
+EI_WEAK_FN int ei_dsp_workers(void) {
+    return 1;
+}
+
+EI_WEAK_FN int ei_set_dsp_workers(int n) {
+    (void)n;
+    return 1;
+}
+
 __attribute__((weak)) void *ei_malloc(size_t size) {
-    return malloc(size);
+    return mem_alloc_placed(size, false);
 }
 
 __attribute__((weak)) void *ei_calloc(size_t nitems, size_t size) {
-    return calloc(nitems, size);
+    if (size != 0 && nitems > SIZE_MAX / size) {
+        return NULL;
+    }
+    return mem_alloc_placed(nitems * size, true);
 }
 
 __attribute__((weak)) void ei_free(void *ptr) {
@@ -0,0 +1,157 @@
+/* Edge Impulse inferencing library
+ * Copyright (c) 2021 EdgeImpulse Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "../ei_classifier_porting.h"
+#if EI_PORTING_POSIX == 1
+
+#include <stdarg.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <thread>
+
+#define EI_WEAK_FN __attribute__((weak))
+
+EI_WEAK_FN EI_IMPULSE_ERROR ei_run_impulse_check_canceled() {
+    return EI_IMPULSE_OK;
+}
+
+/**
+ * Cancelable sleep, can be triggered with signal from other thread
+ */
+EI_WEAK_FN EI_IMPULSE_ERROR ei_sleep(int32_t time_ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(time_ms));
+    return EI_IMPULSE_OK;
+}
+
+uint64_t ei_read_timer_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+uint64_t ei_read_timer_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+__attribute__((weak)) void ei_printf(const char *format, ...) {
+    va_list myargs;
+    va_start(myargs, format);
+    vprintf(format, myargs);
+    va_end(myargs);
+}
+
+__attribute__((weak)) void ei_printf_float(float f) {
+    ei_printf("%f", f);
+}
+
+/**
+ * One heap: the placement is remembered but has no effect, every
+ * allocation is counted as internal.
+ */
+static ei_mem_placement_t mem_placement = EI_MEM_DEFAULT;
+static ei_mem_report_t mem_report;
+
+static void *mem_alloc_counted(void *ptr, size_t size) {
+    if (ptr == NULL) {
+        mem_report.failed_allocs++;
+        return NULL;
+    }
+    mem_report.internal_allocs++;
+    mem_report.internal_bytes += size;
+    if (size > mem_report.largest_alloc) {
+        mem_report.largest_alloc = size;
+    }
+    return ptr;
+}
+
+ei_mem_placement_t ei_set_mem_placement(ei_mem_placement_t placement) {
+    ei_mem_placement_t previous = mem_placement;
+    mem_placement = placement;
+    return previous;
+}
+
+void ei_get_mem_report(ei_mem_report_t *report) {
+    *report = mem_report;
+}
+
+void ei_reset_mem_report(void) {
+    memset(&mem_report, 0, sizeof(mem_report));
+}
+
+static ei_stage_times_t stage_times;
+
+void ei_add_stage_time(ei_stage_t stage, uint32_t us) {
+    stage_times.us[stage] += us;
+    stage_times.ran |= 1u << stage;
+}
+
+void ei_get_stage_times(ei_stage_times_t *times) {
+    *times = stage_times;
+}
+
+void ei_reset_stage_times(void) {
+    memset(&stage_times, 0, sizeof(stage_times));
+}
+
+/**
+ * No DSP workers, everything runs on the caller. The host replay overrides these
+ * with a worker thread.
+ */
+EI_WEAK_FN int ei_dsp_parallel_for(size_t count, ei_dsp_work_fn fn, void *ctx) {
+    return fn(ctx, 0, count, 0);
+}
+
+EI_WEAK_FN int ei_dsp_workers(void) {
+    return 1;
+}
+
+EI_WEAK_FN int ei_set_dsp_workers(int n) {
+    (void)n;
+    return 1;
+}
+
+__attribute__((weak)) void *ei_malloc(size_t size) {
+    return mem_alloc_counted(malloc(size), size);
+}
+
+__attribute__((weak)) void *ei_calloc(size_t nitems, size_t size) {
+    if (size != 0 && nitems > SIZE_MAX / size) {
+        return NULL;
+    }
+    return mem_alloc_counted(calloc(nitems, size), nitems * size);
+}
+
+__attribute__((weak)) void ei_free(void *ptr) {
+    free(ptr);
+}
+
+#if defined(__cplusplus) && EI_C_LINKAGE == 1
+extern "C"
+#endif
+__attribute__((weak)) void DebugLog(const char* s) {
+    ei_printf("%s", s);
+}
+
+#endif // EI_PORTING_POSIX == 1
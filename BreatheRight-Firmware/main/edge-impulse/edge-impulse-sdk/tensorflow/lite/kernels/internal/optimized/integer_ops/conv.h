@@ -0,0 +1,158 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_KERNELS_INTERNAL_OPTIMIZED_INTEGER_OPS_CONV_H_
+#define TENSORFLOW_LITE_KERNELS_INTERNAL_OPTIMIZED_INTEGER_OPS_CONV_H_
+
+#include "edge-impulse-sdk/tensorflow/lite/kernels/internal/common.h"
+#include "edge-impulse-sdk/tensorflow/lite/kernels/internal/optimized/integer_ops/dot_product.h"
+#include "edge-impulse-sdk/tensorflow/lite/kernels/internal/reference/integer_ops/conv.h"
+
+namespace tflite {
+namespace optimized_integer_ops {
+
+// Per-channel int8 convolution, bit exact with
+// reference_integer_ops::ConvPerChannel.
+//
+// The filter taps that fall inside the image are clipped once per output
+// pixel instead of being tested for every tap and channel. Within one filter
+// row the valid taps are contiguous in both the NHWC input and the OHWI
+// filter, so each row is a single dot product. Where the whole filter is
+// inside the image the input offset is folded in as
+// input_offset * filter_sums[out_channel]; at the border the padded taps
+// must not contribute the offset, so the offset is added per tap instead.
+//
+// filter_sums holds the sum of each output channel's filter (see RowSums).
+// It may be null, then every pixel takes the border path.
+inline void ConvPerChannel(
+    const ConvParams& params, const int32* output_multiplier,
+    const int32* output_shift, const int32* filter_sums,
+    const RuntimeShape& input_shape, const int8* input_data,
+    const RuntimeShape& filter_shape, const int8* filter_data,
+    const RuntimeShape& bias_shape, const int32* bias_data,
+    const RuntimeShape& output_shape, int8* output_data) {
+  if (params.dilation_width_factor != 1 || params.dilation_height_factor != 1) {
+    reference_integer_ops::ConvPerChannel(
+        params, output_multiplier, output_shift, input_shape, input_data,
+        filter_shape, filter_data, bias_shape, bias_data, output_shape,
+        output_data);
+    return;
+  }
+
+  // Get parameters.
+  const int32 input_offset = params.input_offset;  // r = s(q - Z)
+  const int stride_width = params.stride_width;
+  const int stride_height = params.stride_height;
+  const int pad_width = params.padding_values.width;
+  const int pad_height = params.padding_values.height;
+  const int32 output_offset = params.output_offset;
+
+  // Set min and max value of the output.
+  const int32 output_activation_min = params.quantized_activation_min;
+  const int32 output_activation_max = params.quantized_activation_max;
+
+  // Sanity check.
+  TFLITE_DCHECK_LE(output_activation_min, output_activation_max);
+  TFLITE_DCHECK_EQ(input_shape.DimensionsCount(), 4);
+  TFLITE_DCHECK_EQ(filter_shape.DimensionsCount(), 4);
+  TFLITE_DCHECK_EQ(output_shape.DimensionsCount(), 4);
+  const int batches = MatchingDim(input_shape, 0, output_shape, 0);
+  const int input_depth = MatchingDim(input_shape, 3, filter_shape, 3);
+  const int output_depth = MatchingDim(filter_shape, 0, output_shape, 3);
+  if (bias_data) {
+    TFLITE_DCHECK_EQ(bias_shape.FlatSize(), output_depth);
+  }
+
+  // Check dimensions of the tensors.
+  const int input_height = input_shape.Dims(1);
+  const int input_width = input_shape.Dims(2);
+  const int filter_height = filter_shape.Dims(1);
+  const int filter_width = filter_shape.Dims(2);
+  const int output_height = output_shape.Dims(1);
+  const int output_width = output_shape.Dims(2);
+
+  const int input_row_stride = input_width * input_depth;
+  const int filter_row_stride = filter_width * input_depth;
+  const int filter_channel_stride = filter_height * filter_row_stride;
+
+  int8* out = output_data;
+  for (int batch = 0; batch < batches; ++batch) {
+    for (int out_y = 0; out_y < output_height; ++out_y) {
+      const int in_y_origin = (out_y * stride_height) - pad_height;
+      const int filter_y_start = std::max(0, -in_y_origin);
+      const int filter_y_end =
+          std::min(filter_height, input_height - in_y_origin);
+      for (int out_x = 0; out_x < output_width; ++out_x) {
+        const int in_x_origin = (out_x * stride_width) - pad_width;
+        const int filter_x_start = std::max(0, -in_x_origin);
+        const int filter_x_end =
+            std::min(filter_width, input_width - in_x_origin);
+        const int rows = filter_y_end - filter_y_start;
+        const int run = (filter_x_end - filter_x_start) * input_depth;
+        const bool inside = filter_sums != nullptr && rows == filter_height &&
+                            run == filter_row_stride;
+
+        const int8* input_base = nullptr;
+        if (rows > 0 && run > 0) {
+          input_base =
+              input_data + Offset(input_shape, batch,
+                                  in_y_origin + filter_y_start,
+                                  in_x_origin + filter_x_start, 0);
+        }
+        const int8* filter_base = filter_data +
+                                  filter_y_start * filter_row_stride +
+                                  filter_x_start * input_depth;
+
+        for (int out_channel = 0; out_channel < output_depth; ++out_channel) {
+          int32 acc = 0;
+          if (input_base) {
+            const int8* in_row = input_base;
+            const int8* filter_row =
+                filter_base + out_channel * filter_channel_stride;
+            if (inside) {
+              for (int r = 0; r < rows; ++r) {
+                acc += DotProduct(in_row, filter_row, run);
+                in_row += input_row_stride;
+                filter_row += filter_row_stride;
+              }
+              acc += input_offset * filter_sums[out_channel];
+            } else {
+              for (int r = 0; r < rows; ++r) {
+                acc += DotProductWithOffset(in_row, filter_row, run,
+                                            input_offset);
+                in_row += input_row_stride;
+                filter_row += filter_row_stride;
+              }
+            }
+          }
+
+          if (bias_data) {
+            acc += bias_data[out_channel];
+          }
+          acc = MultiplyByQuantizedMultiplier(
+              acc, output_multiplier[out_channel], output_shift[out_channel]);
+          acc += output_offset;
+          acc = std::max(acc, output_activation_min);
+          acc = std::min(acc, output_activation_max);
+          *out++ = static_cast<int8_t>(acc);
+        }
+      }
+    }
+  }
+}
+
+}  // namespace optimized_integer_ops
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_KERNELS_INTERNAL_OPTIMIZED_INTEGER_OPS_CONV_H_
@@ -0,0 +1,84 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_KERNELS_INTERNAL_OPTIMIZED_INTEGER_OPS_DOT_PRODUCT_H_
+#define TENSORFLOW_LITE_KERNELS_INTERNAL_OPTIMIZED_INTEGER_OPS_DOT_PRODUCT_H_
+
+#include "edge-impulse-sdk/tensorflow/lite/kernels/internal/common.h"
+
+namespace tflite {
+namespace optimized_integer_ops {
+
+// Inner loops shared by the int8 Conv2D and FullyConnected kernels, written
+// for cores with a 16x16 multiplier and no SIMD, like the ESP32 LX6 (MAC16
+// option). The operands are widened to int16 so the compiler emits a single
+// cycle MUL16S per tap instead of a 32 bit MULL, and the loops are unrolled
+// by four to amortize the loop overhead and the sign extending loads.
+
+// sum(a[i] * b[i]) for i in [0, n).
+inline int32 DotProduct(const int8* a, const int8* b, int n) {
+  int32 acc = 0;
+  int i = 0;
+  for (; i <= n - 4; i += 4) {
+    acc += static_cast<int16>(a[i + 0]) * static_cast<int16>(b[i + 0]);
+    acc += static_cast<int16>(a[i + 1]) * static_cast<int16>(b[i + 1]);
+    acc += static_cast<int16>(a[i + 2]) * static_cast<int16>(b[i + 2]);
+    acc += static_cast<int16>(a[i + 3]) * static_cast<int16>(b[i + 3]);
+  }
+  for (; i < n; ++i) {
+    acc += static_cast<int16>(a[i]) * static_cast<int16>(b[i]);
+  }
+  return acc;
+}
+
+// sum(filter[i] * (input[i] + input_offset)) for i in [0, n). The offset input
+// still fits in int16 since input_offset is the negated int8 zero point.
+inline int32 DotProductWithOffset(const int8* input, const int8* filter, int n,
+                                  int32 input_offset) {
+  const int16 offset = static_cast<int16>(input_offset);
+  int32 acc = 0;
+  int i = 0;
+  for (; i <= n - 4; i += 4) {
+    acc += static_cast<int16>(filter[i + 0]) *
+           static_cast<int16>(input[i + 0] + offset);
+    acc += static_cast<int16>(filter[i + 1]) *
+           static_cast<int16>(input[i + 1] + offset);
+    acc += static_cast<int16>(filter[i + 2]) *
+           static_cast<int16>(input[i + 2] + offset);
+    acc += static_cast<int16>(filter[i + 3]) *
+           static_cast<int16>(input[i + 3] + offset);
+  }
+  for (; i < n; ++i) {
+    acc += static_cast<int16>(filter[i]) * static_cast<int16>(input[i] + offset);
+  }
+  return acc;
+}
+
+// Sums every row of a rows x cols int8 matrix. The kernels fold the input
+// offset in as input_offset * row_sum, so the inner loops only see raw int8
+// values. Call once when the weights are known, e.g. in Prepare.
+inline void RowSums(const int8* data, int rows, int cols, int32* sums) {
+  for (int r = 0; r < rows; ++r) {
+    int32 sum = 0;
+    for (int c = 0; c < cols; ++c) {
+      sum += data[r * cols + c];
+    }
+    sums[r] = sum;
+  }
+}
+
+}  // namespace optimized_integer_ops
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_KERNELS_INTERNAL_OPTIMIZED_INTEGER_OPS_DOT_PRODUCT_H_
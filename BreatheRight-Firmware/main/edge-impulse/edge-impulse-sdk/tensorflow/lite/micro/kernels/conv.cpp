@@ -1018,6 +1018,10 @@ limitations under the License.
 #include "edge-impulse-sdk/tensorflow/lite/kernels/kernel_util.h"
 #include "edge-impulse-sdk/tensorflow/lite/kernels/padding.h"
 
+#if EI_CLASSIFIER_TFLITE_ENABLE_XTENSA_KERNELS == 1
+#include "edge-impulse-sdk/tensorflow/lite/kernels/internal/optimized/integer_ops/conv.h"
+#endif
+
 namespace tflite {
 namespace ops {
 namespace micro {
@@ -1045,6 +1049,12 @@ struct OpData {
   int32_t* per_channel_output_multiplier;
   int32_t* per_channel_output_shift;
 
+#if EI_CLASSIFIER_TFLITE_ENABLE_XTENSA_KERNELS == 1
+  // Sum of every output channel's int8 filter, null if the filter is not
+  // constant.
+  int32_t* filter_sums;
+#endif
+
   // The range of the fused activation layer. For example for kNone and
   // uint8_t these would be 0 and 255.
   int32_t output_activation_min;
@@ -1157,6 +1167,20 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
                       affine_quantization->zero_point->size);
   }
 
+#if EI_CLASSIFIER_TFLITE_ENABLE_XTENSA_KERNELS == 1
+  data->filter_sums = nullptr;
+  if (input->type == kTfLiteInt8 &&
+      filter->allocation_type == kTfLiteMmapRo) {
+    TF_LITE_ENSURE_STATUS(context->AllocatePersistentBuffer(
+        context, num_channels * sizeof(int32_t),
+        reinterpret_cast<void**>(&data->filter_sums)));
+    optimized_integer_ops::RowSums(GetTensorData<int8_t>(filter), num_channels,
+                                   filter_height * filter_width *
+                                       filter->dims->data[3],
+                                   data->filter_sums);
+  }
+#endif
+
   return CalculateOpData(context, node, params, input_width, input_height,
                          filter_width, filter_height, output_width,
                          output_height, input->type, data);
@@ -1214,6 +1238,15 @@ void EvalQuantizedPerChannel(TfLiteContext* context, TfLiteNode* node,
   op_params.quantized_activation_min = data.output_activation_min;
   op_params.quantized_activation_max = data.output_activation_max;
 
+#if EI_CLASSIFIER_TFLITE_ENABLE_XTENSA_KERNELS == 1
+  optimized_integer_ops::ConvPerChannel(
+      op_params, data.per_channel_output_multiplier,
+      data.per_channel_output_shift, data.filter_sums, GetTensorShape(input),
+      GetTensorData<int8>(input), GetTensorShape(filter),
+      GetTensorData<int8>(filter), GetTensorShape(bias),
+      GetTensorData<int32>(bias), GetTensorShape(output),
+      GetTensorData<int8>(output));
+#else
   reference_integer_ops::ConvPerChannel(
       op_params, data.per_channel_output_multiplier,
       data.per_channel_output_shift, GetTensorShape(input),
@@ -1221,6 +1254,7 @@ void EvalQuantizedPerChannel(TfLiteContext* context, TfLiteNode* node,
       GetTensorData<int8>(filter), GetTensorShape(bias),
       GetTensorData<int32>(bias), GetTensorShape(output),
       GetTensorData<int8>(output));
+#endif
 }
 
 void EvalFloat(TfLiteContext* context, TfLiteNode* node,
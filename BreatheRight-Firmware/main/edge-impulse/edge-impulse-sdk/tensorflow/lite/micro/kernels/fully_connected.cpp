@@ -678,6 +678,10 @@ limitations under the License.
 #include "edge-impulse-sdk/tensorflow/lite/kernels/internal/tensor_ctypes.h"
 #include "edge-impulse-sdk/tensorflow/lite/kernels/kernel_util.h"
 
+#if EI_CLASSIFIER_TFLITE_ENABLE_XTENSA_KERNELS == 1
+#include "edge-impulse-sdk/tensorflow/lite/kernels/internal/optimized/integer_ops/fully_connected.h"
+#endif
+
 namespace tflite {
 namespace ops {
 namespace micro {
@@ -695,6 +699,11 @@ struct OpData {
   int32_t output_activation_max;
   // The index of the temporary tensor where the quantized inputs are cached.
   int input_quantized_index;
+#if EI_CLASSIFIER_TFLITE_ENABLE_XTENSA_KERNELS == 1
+  // Sum of every output's int8 weights, null if the weights are not
+  // constant.
+  int32_t* filter_sums;
+#endif
 };
 
 constexpr int kInputTensor = 0;
@@ -752,6 +761,21 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   TF_LITE_ENSURE_MSG(context, input->type == filter->type,
                      "Hybrid models are not supported on TFLite Micro.");
 
+#if EI_CLASSIFIER_TFLITE_ENABLE_XTENSA_KERNELS == 1
+  data->filter_sums = nullptr;
+  if (input->type == kTfLiteInt8 &&
+      filter->allocation_type == kTfLiteMmapRo) {
+    const int filter_dim_count = filter->dims->size;
+    const int rows = filter->dims->data[filter_dim_count - 2];
+    const int cols = filter->dims->data[filter_dim_count - 1];
+    TF_LITE_ENSURE_STATUS(context->AllocatePersistentBuffer(
+        context, rows * sizeof(int32_t),
+        reinterpret_cast<void**>(&data->filter_sums)));
+    optimized_integer_ops::RowSums(GetTensorData<int8_t>(filter), rows, cols,
+                                   data->filter_sums);
+  }
+#endif
+
   return CalculateOpData(context, params->activation, input->type, input,
                          filter, bias, output, data);
 }
@@ -770,6 +794,18 @@ TfLiteStatus EvalQuantizedInt8(TfLiteContext* context, TfLiteNode* node,
   op_params.quantized_activation_min = data.output_activation_min;
   op_params.quantized_activation_max = data.output_activation_max;
 
+#if EI_CLASSIFIER_TFLITE_ENABLE_XTENSA_KERNELS == 1
+  if (data.filter_sums) {
+    optimized_integer_ops::FullyConnected(
+        op_params, data.filter_sums, GetTensorShape(input),
+        GetTensorData<int8_t>(input), GetTensorShape(filter),
+        GetTensorData<int8_t>(filter), GetTensorShape(bias),
+        GetTensorData<int32_t>(bias), GetTensorShape(output),
+        GetTensorData<int8_t>(output));
+    return kTfLiteOk;
+  }
+#endif
+
   reference_integer_ops::FullyConnected(
       op_params, GetTensorShape(input), GetTensorData<int8_t>(input),
       GetTensorShape(filter), GetTensorData<int8_t>(filter),
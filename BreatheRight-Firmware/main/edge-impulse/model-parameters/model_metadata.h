@@ -79,6 +79,20 @@
 #define EI_CLASSIFIER_SLICES_PER_MODEL_WINDOW    3
 #endif // EI_CLASSIFIER_SLICES_PER_MODEL_WINDOW
 #define EI_CLASSIFIER_SLICE_SIZE                 (EI_CLASSIFIER_RAW_SAMPLE_COUNT / EI_CLASSIFIER_SLICES_PER_MODEL_WINDOW)
+// Upper bound of run_classifier_set_slices_per_model_window, sizes the moving average filter
+#ifndef EI_CLASSIFIER_MAX_SLICES_PER_MODEL_WINDOW
+#define EI_CLASSIFIER_MAX_SLICES_PER_MODEL_WINDOW 8
+#endif // EI_CLASSIFIER_MAX_SLICES_PER_MODEL_WINDOW
+
+// MFCC block parameters, ei_dsp_config_13 is built from these so the DSP can
+// also be specialized at compile time (see speechpy::feature_static)
+#define EI_CLASSIFIER_MFCC_NUM_CEPSTRAL          13
+#define EI_CLASSIFIER_MFCC_FRAME_LENGTH          0.02000f
+#define EI_CLASSIFIER_MFCC_FRAME_STRIDE          0.02000f
+#define EI_CLASSIFIER_MFCC_NUM_FILTERS           32
+#define EI_CLASSIFIER_MFCC_FFT_LENGTH            256
+#define EI_CLASSIFIER_MFCC_LOW_FREQUENCY         300
+#define EI_CLASSIFIER_MFCC_HIGH_FREQUENCY        0
 
 #if EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE && EI_CLASSIFIER_USE_FULL_TFLITE == 1
 #undef EI_CLASSIFIER_INFERENCING_ENGINE
@@ -186,14 +200,14 @@ const uint32_t ei_dsp_config_13_axes_size = 1;
 ei_dsp_config_mfcc_t ei_dsp_config_13 = {
     2,
     1,
-    13,
-    0.02000f,
-    0.02000f,
-    32,
-    256,
+    EI_CLASSIFIER_MFCC_NUM_CEPSTRAL,
+    EI_CLASSIFIER_MFCC_FRAME_LENGTH,
+    EI_CLASSIFIER_MFCC_FRAME_STRIDE,
+    EI_CLASSIFIER_MFCC_NUM_FILTERS,
+    EI_CLASSIFIER_MFCC_FFT_LENGTH,
     101,
-    300,
-    0,
+    EI_CLASSIFIER_MFCC_LOW_FREQUENCY,
+    EI_CLASSIFIER_MFCC_HIGH_FREQUENCY,
     0.98000f,
     1
 };
@@ -37,6 +37,10 @@ extern void ei_printf(const char *format, ...);
 #endif
 #endif
 
+#if EI_CLASSIFIER_PROFILE_LAYERS
+#include "edge-impulse-sdk/porting/ei_classifier_porting.h"
+#endif
+
 #if defined __GNUC__
 #define ALIGN(X) __attribute__((aligned(X)))
 #elif defined _MSC_VER
@@ -71,6 +75,23 @@ template <int SZ, class T> struct TfArray {
 enum used_operators_e {
   OP_RESHAPE, OP_CONV_2D, OP_AVERAGE_POOL_2D, OP_FULLY_CONNECTED, OP_SOFTMAX,  OP_LAST
 };
+#if EI_CLASSIFIER_PROFILE_LAYERS
+const char *used_operator_names[] = {
+  "RESHAPE", "CONV_2D", "AVERAGE_POOL_2D", "FULLY_CONNECTED", "SOFTMAX",
+};
+uint64_t layer_ticks[8];
+uint32_t layer_invokes;
+
+inline uint32_t read_layer_ticks() {
+#if defined(__XTENSA__)
+  uint32_t ccount;
+  __asm__ __volatile__("rsr %0, ccount" : "=a"(ccount));
+  return ccount;
+#else
+  return (uint32_t)ei_read_timer_us();
+#endif
+}
+#endif // EI_CLASSIFIER_PROFILE_LAYERS
 struct TensorInfo_t { // subset of TfLiteTensor used for initialization from constant memory
   TfLiteAllocationType allocation_type;
   TfLiteType type;
@@ -442,8 +463,17 @@ TfLiteTensor* trained_model_output(int index) {
 }
 
 TfLiteStatus trained_model_invoke() {
+#if EI_CLASSIFIER_PROFILE_LAYERS
+  layer_invokes++;
+#endif
   for(size_t i = 0; i < 8; ++i) {
+#if EI_CLASSIFIER_PROFILE_LAYERS
+    uint32_t start_ticks = read_layer_ticks();
+#endif
     TfLiteStatus status = registrations[nodeData[i].used_op_index].invoke(&ctx, &tflNodes[i]);
+#if EI_CLASSIFIER_PROFILE_LAYERS
+    layer_ticks[i] += (uint32_t)(read_layer_ticks() - start_ticks);
+#endif
 
 #if EI_CLASSIFIER_PRINT_STATE
     ei_printf("layer %lu\n", i);
@@ -511,6 +541,27 @@ TfLiteStatus trained_model_invoke() {
   return kTfLiteOk;
 }
 
+#if EI_CLASSIFIER_PROFILE_LAYERS
+const char *trained_model_layer_name(size_t index) {
+  return used_operator_names[nodeData[index].used_op_index];
+}
+
+uint64_t trained_model_layer_ticks(size_t index) {
+  return layer_ticks[index];
+}
+
+uint32_t trained_model_layer_invokes() {
+  return layer_invokes;
+}
+
+void trained_model_layer_ticks_reset() {
+  for(size_t i = 0; i < 8; ++i) {
+    layer_ticks[i] = 0;
+  }
+  layer_invokes = 0;
+}
+#endif // EI_CLASSIFIER_PROFILE_LAYERS
+
 TfLiteStatus trained_model_reset( void (*free_fnc)(void* ptr) ) {
 #ifdef EI_CLASSIFIER_ALLOCATION_HEAP
   free_fnc(tensor_arena);
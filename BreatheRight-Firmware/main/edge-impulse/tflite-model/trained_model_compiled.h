@@ -46,6 +46,23 @@ inline size_t trained_model_outputs() {
   return 1;
 }
 
+#if EI_CLASSIFIER_PROFILE_LAYERS
+// Returns the number of layers (operators) of the model.
+inline size_t trained_model_layers() {
+  return 8;
+}
+// Returns the operator of the layer with the given index, e.g. "CONV_2D".
+const char *trained_model_layer_name(size_t index);
+// Returns the time spent in the layer with the given index, summed over all
+// invocations since the last reset. CPU cycles on Xtensa, microseconds
+// elsewhere.
+uint64_t trained_model_layer_ticks(size_t index);
+// Returns the number of invocations since the last reset.
+uint32_t trained_model_layer_invokes();
+// Clears the layer timings.
+void trained_model_layer_ticks_reset();
+#endif // EI_CLASSIFIER_PROFILE_LAYERS
+
 inline void *trained_model_input_ptr(int index) {
   return trained_model_input(index)->data.data;
 }
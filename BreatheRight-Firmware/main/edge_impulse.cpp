@@ -1,9 +1,18 @@
 #include <stdio.h>
 #include <cstring>
+#include <cmath>
 #include <iostream>
 #include <sstream>
 #include "edge_impulse.h"
+#include "audio_capture.h"
+#include "slice_queue.h"
+#include "energy_gate.h"
+#include "inference_profiler.h"
+#include "task_plan.h"
+#include "dsp_workers.h"
 #include <Cough_Tutorial_inferencing.h> 
+#include "slice_classifier.h"
+#include "classifier_bench.h"
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -12,10 +21,9 @@
 
 #include "driver/i2s.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 
 extern "C" {
-#include "microphone.h"
-
 EI_DATA eiData;
 SemaphoreHandle_t xEISemaphore;
 }
@@ -26,25 +34,45 @@ static const char *TAG = EDGEIMPULSE_TAB_NAME;
 static bool microphone_inference_start(uint32_t n_samples);
 static bool microphone_inference_record(void);
 static void microphone_inference_end(void);
-static int microphone_audio_signal_get_data(size_t offset, size_t length, float *out_ptr);
-
-/** Audio buffers, pointers and selectors */
-typedef struct {
-    signed short *buffers[2];
-    unsigned char buf_select;
-    unsigned char buf_ready;
-    unsigned int buf_count;
-    unsigned int n_samples; 
-} inference_t;
+static void segment_slice(uint32_t seq, const float *scores);
+static void publish_events(const SEGMENT_EVENT *closed, size_t n);
+static void apply_slices(uint32_t seq, uint32_t slices);
+static void slice_handled(uint32_t captured_us);
+#if CONFIG_CLASSIFIER_LAYER_PROFILE
+static void log_layer_profile(void);
+#endif
 
 TaskHandle_t mic_handle, inference_handle;
 
-static inference_t inference;
+/** Audio slices handed from microphoneTask to inferenceTask */
+static SLICE_QUEUE slice_queue;
+static const int16_t *current_slice;
+static uint32_t slice_queue_full;
+static uint32_t slice_seq;
+/** Health counters, see EI_HEALTH. dropped_slices is written by microphoneTask, the others by inferenceTask */
+static uint32_t dropped_slices;
+static uint32_t slices_handled;
+static uint32_t deadline_misses;
+/** Slices per model window asked for by edge_impulse_set_slices, picked up by microphoneTask */
+static uint32_t slices_requested = EI_CLASSIFIER_SLICES_PER_MODEL_WINDOW;
+
+/** Energy gate, updated by microphoneTask for every captured slice */
+static ENERGY_GATE energy_gate;
 static bool record_ready = false;
-static signed short *sampleBuffer;
 static bool debug_nn = false; // Set this to true to see e.g. features generated from the raw signal
 static int print_results = -(EI_CLASSIFIER_SLICES_PER_MODEL_WINDOW);
 
+/** Turns the per-slice scores into cough / sneeze events, inferenceTask only */
+static EVENT_SEGMENTER segmenter;
+
+#if CONFIG_CLASSIFIER_MEM_INTERNAL
+static const ei_mem_placement_t classifier_mem_placement = EI_MEM_INTERNAL;
+#elif CONFIG_CLASSIFIER_MEM_EXTERNAL
+static const ei_mem_placement_t classifier_mem_placement = EI_MEM_EXTERNAL;
+#else
+static const ei_mem_placement_t classifier_mem_placement = EI_MEM_DEFAULT;
+#endif
+
 
 extern "C" void edge_impulse_start() {
     // summary of inferencing settings (from model_metadata.h)
@@ -59,10 +87,45 @@ extern "C" void edge_impulse_start() {
     xSemaphoreTake(xEISemaphore, portMAX_DELAY);
     eiData.coughs = 0;
     eiData.sneezes = 0;
+    memset(&eiData.events, 0, sizeof(eiData.events));
     xSemaphoreGive(xEISemaphore);                                          
 
-    run_classifier_init();
-    if (microphone_inference_start(EI_CLASSIFIER_SLICE_SIZE) == false) {
+    slice_classifier_init_segmenter(&segmenter);
+    if (segmenter.track[EVENT_COUGH].label_ix < 0) {
+        ESP_LOGW(TAG, "Model has no \"cough\" label, coughs will not be counted");
+    }
+    if (segmenter.track[EVENT_SNEEZE].label_ix < 0) {
+        ESP_LOGW(TAG, "Model has no \"sneeze\" label, sneezes will not be counted");
+    }
+
+#if EIDSP_MFCC_PARALLEL
+    if (!dsp_workers_start()) {
+        ESP_LOGW(TAG, "No DSP worker, the MFCC runs on one core");
+    }
+#endif
+
+#if CONFIG_AUDIO_MFCC_BENCHMARK
+    classifier_bench_mfcc_window(TAG);
+#endif
+#if CONFIG_AUDIO_MFCC_BENCHMARK && EI_DSP_MFCC_STATIC
+    classifier_bench_mfcc_static(TAG);
+#endif
+
+#if CONFIG_CLASSIFIER_MEM_BENCHMARK
+    classifier_bench_placement(TAG);
+#endif
+
+    ei_set_mem_placement(classifier_mem_placement);
+    ei_reset_mem_report();
+    slice_classifier_reset();
+    slice_classifier_log_mem_report(TAG, "init");
+
+#if CONFIG_CLASSIFIER_HOP_BENCHMARK
+    classifier_bench_hop(TAG, edge_impulse_slices());
+#endif
+
+    // Slots fit the longest slice, so the hop can change without reallocating them
+    if (microphone_inference_start(SLICE_CLASSIFIER_MAX_SLICE_SIZE) == false) {
         printf("ERR: Failed to setup audio sampling\r\n");
         return;
     }
@@ -74,38 +137,88 @@ void microphoneTask(void* pvParameters) {
 
     vTaskDelay(pdMS_TO_TICKS(10000));
 
-    // static int8_t i2s_readraw_buff[1024];
-    size_t bytesread;
-    // int16_t* buffptr;
-    double data = 0;
-    // ESP_LOGI(TAG, "Calling Microphone_Init ...");
-    Microphone_Init();
-    // ESP_LOGI(TAG, "Done calling Microphone_Init ...");
-    // QueueHandle_t queue = (QueueHandle_t) pvParameters;
+    if (!audio_capture_start()) {
+        ESP_LOGE(TAG, "Failed to start audio capture");
+        vTaskDelete(NULL);
+    }
+
+    AUDIO_CAPTURE_STATS stats;
+    TickType_t last_report = xTaskGetTickCount();
+    uint32_t slices = 0;    // the first pass picks up slices_requested
+    uint32_t dropped_seen = 0;
 
     for (;;) {
-        // ESP_LOGI(TAG, "Calling i2s_read ...");
-        i2s_read(I2S_NUM_0, (char *)&sampleBuffer[0], (inference.n_samples >> 3), &bytesread, pdMS_TO_TICKS(100));
-        // ESP_LOGI(TAG, "i2s_read bytesread:%d", bytesread);
+        uint32_t requested = __atomic_load_n(&slices_requested, __ATOMIC_RELAXED);
+        if (requested != slices) {
+            // Slices are cut at the new length from here on, inferenceTask follows
+            // when it reaches the first of them
+            slices = requested;
+#ifdef CONFIG_AUDIO_VAD_ENABLE
+            energy_gate.hangover_slices = slices;
+#endif
+        }
 
-        // buffptr = (int16_t*)i2s_readraw_buff;
+        int16_t *slot = slice_queue_write_slot(&slice_queue);
+        if (slot == NULL) {
+            // Inference is behind. Wait for a slot while the capture ring keeps buffering.
+            slice_queue_full++;
+            while ((slot = slice_queue_write_slot(&slice_queue)) == NULL) {
+                ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100));
+            }
+        }
 
-        if (record_ready == true) {
-            // ESP_LOGI(TAG, "Copying samples to inference buffers");
-            for (int i = 0; i<bytesread>> 1; i++) {
-                inference.buffers[inference.buf_select][inference.buf_count++] = sampleBuffer[i];
-
-                if (inference.buf_count >= inference.n_samples) {
-                    // ESP_LOGI(TAG, "buffer full. flipping buffers");            
-                    inference.buf_select ^= 1;
-                    inference.buf_count = 0;
-                    inference.buf_ready = 1;
-                }
+        // Blocks until the capture ring holds a full slice, no polling.
+        size_t n = audio_capture_read(slot, slice_classifier_slice_size(slices), pdMS_TO_TICKS(1000));
+        if (n == 0) {
+            ESP_LOGE(TAG, "Audio capture stalled");
+            continue;
+        }
+        uint32_t captured_us = (uint32_t)esp_timer_get_time();
+
+        audio_capture_get_stats(&stats);
+        if (stats.dropped_samples != dropped_seen) {
+            // The capture ring discarded audio since the last slice. Skip as many slice
+            // numbers, so event times stay in step and inferenceTask sees the gap.
+            uint32_t lost = stats.dropped_samples - dropped_seen;
+            uint32_t lost_slices = (lost + n - 1) / n;
+            dropped_seen = stats.dropped_samples;
+            if (record_ready == true) {
+                slice_seq += lost_slices;
+                dropped_slices += lost_slices;
             }
-        }       
-        vTaskDelay(pdMS_TO_TICKS(10));
- 
+        }
+
+        if (record_ready == true) {
+            SLICE_INFO *info = slice_queue_write_info(&slice_queue);
+            info->seq = slice_seq++;
+            info->captured_us = captured_us;
+            info->window_slices = slices;
+#ifdef CONFIG_AUDIO_VAD_ENABLE
+            info->active = energy_gate_update(&energy_gate, slot, n, NULL);
+#else
+            info->active = true;
+#endif
+            slice_queue_push(&slice_queue);
+            xTaskNotifyGive(inference_handle);
+        }
 
+        if (xTaskGetTickCount() - last_report >= pdMS_TO_TICKS(60000)) {
+            ESP_LOGI(TAG, "Capture: %u DMA buffers, %u samples, %u gaps (dma err %u, dma ovf %u, ring ovf %u, short %u), ring high-water %u, decimator %.1f cycles/sample",
+                stats.dma_buffers, stats.samples, audio_capture_gaps(&stats), stats.dma_errors,
+                stats.dma_overflows, stats.ring_overflows, stats.short_reads, stats.max_fill,
+                stats.input_samples ? (float)stats.dsp_cycles / stats.input_samples : 0.0f);
+            ESP_LOGI(TAG, "Slice queue: depth %u, high-water %u, producer waited %u times, %u slices dropped, %u of %u late",
+                slice_queue.depth, slice_queue.max_count, slice_queue_full, dropped_slices, deadline_misses,
+                slices_handled);
+#ifdef CONFIG_AUDIO_VAD_ENABLE
+            uint32_t gate_slices = energy_gate.processed + energy_gate.gated;
+            ESP_LOGI(TAG, "Energy gate: %u processed, %u gated (%.1f%%), noise floor %u",
+                energy_gate.processed, energy_gate.gated,
+                gate_slices ? 100.0f * energy_gate.gated / gate_slices : 0.0f,
+                (unsigned)sqrtf((float)energy_gate.noise_floor));
+#endif
+            last_report = xTaskGetTickCount();
+        }
     }
     vTaskDelete(NULL); // Should never get to here...
 }
@@ -114,32 +227,96 @@ void inferenceTask(void* pvParameters) {
     ESP_LOGI(TAG, "Starting inference Task");
     vTaskDelay(pdMS_TO_TICKS(9000));
 
+#if CONFIG_AUDIO_MFCC_BENCHMARK && EI_DSP_MFCC_STATIC && EIDSP_MFCC_PARALLEL
+    // Here rather than in edge_impulse_start, the caller's share has to run on this task's core
+    classifier_bench_mfcc_workers(TAG);
+#endif
+
+    bool mem_reported = false;
+    TickType_t last_profile = xTaskGetTickCount();
+    uint32_t next_seq = 0;
+
     for (;;) {
 
         // ESP_LOGI(TAG, "Calling microphone_inference_record");
+        uint64_t wait_start = ei_read_timer_us();
         bool m = microphone_inference_record();
+        inference_profiler_record(PROFILE_CAPTURE_WAIT, (uint32_t)(ei_read_timer_us() - wait_start));
+
+        if (xTaskGetTickCount() - last_profile >= pdMS_TO_TICKS(60000)) {
+            inference_profiler_log();
+#if EIDSP_MFCC_PARALLEL
+            dsp_workers_log(TAG);
+#endif
+#if CONFIG_CLASSIFIER_MULTI_MODEL
+            slice_classifier_log_models(TAG);
+#endif
+            last_profile = xTaskGetTickCount();
+        }
+
         if (!m) {
             printf("ERR: Failed to record audio...\n");
             vTaskDelay(pdMS_TO_TICKS(1));
             continue;
         }
 
-        signal_t signal;
-        signal.total_length = EI_CLASSIFIER_SLICE_SIZE;
-        signal.get_data = &microphone_audio_signal_get_data;
+        const SLICE_INFO *info = slice_queue_read_info(&slice_queue);
+        uint32_t seq = info->seq;
+        uint32_t captured_us = info->captured_us;
+
+        if (info->window_slices != slice_classifier_slices()) {
+            apply_slices(seq, info->window_slices);
+        }
+        if (seq != next_seq) {
+            // Audio was dropped before this slice, treat it like a gated gap
+            slice_classifier_skip();
+        }
+        next_seq = seq + 1;
+
+        if (!info->active) {
+            // Quiet slice: skip the DSP and the NN entirely.
+            slice_queue_pop(&slice_queue);
+            xTaskNotifyGive(mic_handle);
+            slice_classifier_skip();
+            segment_slice(seq, NULL);
+            slice_handled(captured_us);
+            continue;
+        }
+
         ei_impulse_result_t result = {0};
+        EI_IMPULSE_ERROR r = slice_classifier_run(current_slice, &result, debug_nn);
+
+        // Hand the slot back to microphoneTask as soon as the features are extracted.
+        slice_queue_pop(&slice_queue);
+        xTaskNotifyGive(mic_handle);
+        slice_handled(captured_us);
+        slice_classifier_record_stages();
 
-        // printf("calling run_classifier_continuous...");
-        EI_IMPULSE_ERROR r = run_classifier_continuous(&signal, &result, debug_nn);
         if (r != EI_IMPULSE_OK) {
             printf("ERR: Failed to run classifier (%d)\n", r);
+            segment_slice(seq, NULL);
             vTaskDelay(pdMS_TO_TICKS(1));
             continue;
         }
 
-        if (++print_results >= (EI_CLASSIFIER_SLICES_PER_MODEL_WINDOW)) {
-            int cough = 0;
-            int sneeze = 0;
+        float scores[EI_CLASSIFIER_LABEL_COUNT];
+        for (size_t ix = 0; ix < EI_CLASSIFIER_LABEL_COUNT; ix++) {
+            scores[ix] = result.classification[ix].value;
+        }
+        segment_slice(seq, scores);
+
+        if (!mem_reported) {
+            slice_classifier_log_mem_report(TAG, "first slice");
+            mem_reported = true;
+        }
+
+#if CONFIG_CLASSIFIER_LAYER_PROFILE
+        if (trained_model_layer_invokes() >= CONFIG_CLASSIFIER_LAYER_PROFILE_SLICES) {
+            log_layer_profile();
+        }
+#endif
+
+        if (++print_results >= (int)slice_classifier_slices()) {
             // print the predictions
             printf("Predictions ");
             printf("(DSP: %d ms., Classification: %d ms., Anomaly: %d ms.)",
@@ -148,19 +325,10 @@ void inferenceTask(void* pvParameters) {
             for (size_t ix = 0; ix < EI_CLASSIFIER_LABEL_COUNT; ix++) {
                 printf("    %s: %.5f\n", result.classification[ix].label,
                         result.classification[ix].value);
-                if (!strcmp(result.classification[ix].label, "cough") && result.classification[ix].value > 0.8) {
-                    cough++;
-                } else if (!strcmp(result.classification[ix].label, "sneeze") && result.classification[ix].value > 0.8) {
-                    sneeze++;
-                }
             }
     #if EI_CLASSIFIER_HAS_ANOMALY == 1
             printf("    anomaly score: %.3f\n", result.anomaly);
     #endif
-            xSemaphoreTake(xEISemaphore, portMAX_DELAY);
-            eiData.coughs += cough;
-            eiData.sneezes += sneeze;
-            xSemaphoreGive(xEISemaphore);       
 
             print_results = 0;
         }
@@ -172,59 +340,134 @@ void inferenceTask(void* pvParameters) {
 
 
 /**
- * @brief      Init inferencing struct and setup/start PDM
+ * @brief      Run the event segmenter on one slice and publish the events it closes
  *
- * @param[in]  n_samples  The n samples
- *
- * @return     { description_of_the_return_value }
+ * @param[in]  seq     Slice sequence number from the capture side
+ * @param[in]  scores  Classifier scores, NULL when the slice was not classified
  */
-static bool microphone_inference_start(uint32_t n_samples)
+static void segment_slice(uint32_t seq, const float *scores)
 {
-    inference.buffers[0] = (signed short *)malloc(n_samples * sizeof(signed short));
+    SEGMENT_EVENT closed[EVENT_KIND_COUNT];
+    size_t n = event_segmenter_update(&segmenter, seq, scores, closed, EVENT_KIND_COUNT);
+    publish_events(closed, n);
+}
 
-    if (inference.buffers[0] == NULL) {
-        return false;
+/**
+ * @brief      Count closed events and hand them to the reporting task
+ */
+static void publish_events(const SEGMENT_EVENT *closed, size_t n)
+{
+    if (n == 0) {
+        return;
     }
 
-    inference.buffers[1] = (signed short *)malloc(n_samples * sizeof(signed short));
+    xSemaphoreTake(xEISemaphore, portMAX_DELAY);
+    for (size_t ix = 0; ix < n; ix++) {
+        if (closed[ix].kind == EVENT_COUGH) {
+            eiData.coughs++;
+        } else if (closed[ix].kind == EVENT_SNEEZE) {
+            eiData.sneezes++;
+        }
+        event_ring_push(&eiData.events, &closed[ix]);
+    }
+    xSemaphoreGive(xEISemaphore);
+}
 
-    if (inference.buffers[0] == NULL) {
-        free(inference.buffers[0]);
-        return false;
+/**
+ * @brief      Switch the classifier and the event segmenter to the slice length
+ *             microphoneTask cut slice `seq` with. The feature window starts
+ *             over, so the next inference is a full model window later.
+ *
+ * @param[in]  seq     First slice of the new length
+ * @param[in]  slices  Slices per model window
+ */
+static void apply_slices(uint32_t seq, uint32_t slices)
+{
+    if (!slice_classifier_set_slices(slices)) {
+        ESP_LOGE(TAG, "Cannot classify with %u slices per window", slices);
+        return;
+    }
+
+    SEGMENT_EVENT closed[EVENT_KIND_COUNT];
+    size_t n = slice_classifier_retime_segmenter(&segmenter, seq, closed, EVENT_KIND_COUNT);
+    publish_events(closed, n);
+
+    print_results = -(int)slices;
+    ESP_LOGI(TAG, "Classifying every %u ms, %u slices per window",
+        slice_classifier_slice_size(slices) * 1000 / EI_CLASSIFIER_FREQUENCY, slices);
+}
+
+/**
+ * @brief      Count a slice handled by inferenceTask, and a deadline miss when
+ *             its scores came more than one hop after it was captured. Every
+ *             miss delays the following slices, steady misses fill the queue.
+ *
+ * @param[in]  captured_us  SLICE_INFO::captured_us of the slice
+ */
+static void slice_handled(uint32_t captured_us)
+{
+    const uint32_t hop_us = (uint64_t)slice_classifier_slice_size(slice_classifier_slices()) * 1000000 /
+        EI_CLASSIFIER_FREQUENCY;
+
+    slices_handled++;
+    if ((uint32_t)esp_timer_get_time() - captured_us > hop_us) {
+        deadline_misses++;
     }
+}
 
-    sampleBuffer = (signed short *)malloc((n_samples >> 3) * sizeof(signed short));
+extern "C" void edge_impulse_get_health(EI_HEALTH *out)
+{
+    AUDIO_CAPTURE_STATS capture;
+    audio_capture_get_stats(&capture);
+
+    out->short_reads = capture.short_reads;
+    out->dma_overflows = capture.dma_overflows;
+    out->dma_errors = capture.dma_errors;
+    out->dropped_samples = capture.dropped_samples;
+    out->dropped_slices = dropped_slices;
+    out->queue_waits = slice_queue_full;
+    out->max_queue_depth = slice_queue.max_count;
+    out->slices = slices_handled;
+    out->deadline_misses = deadline_misses;
+}
 
-    if (sampleBuffer == NULL) {
-        free(inference.buffers[0]);
-        free(inference.buffers[1]);
+extern "C" bool edge_impulse_set_slices(uint32_t slices)
+{
+    if (!slice_classifier_valid_slices(slices)) {
         return false;
     }
 
-    inference.buf_select = 0;
-    inference.buf_count = 0;
-    inference.n_samples = n_samples;
-    inference.buf_ready = 0;
+    __atomic_store_n(&slices_requested, slices, __ATOMIC_RELAXED);
+    return true;
+}
 
-    record_ready = true;
+extern "C" uint32_t edge_impulse_slices(void)
+{
+    return __atomic_load_n(&slices_requested, __ATOMIC_RELAXED);
+}
 
-    xTaskCreatePinnedToCore(microphoneTask, "microphoneTask", 4096 * 2, NULL, 1, &mic_handle, 1);
-    xTaskCreatePinnedToCore(inferenceTask, "inferenceTask", 4096 * 2, NULL, 1, &inference_handle, 1);
+/**
+ * @brief      Init inferencing struct and setup/start PDM
+ *
+ * @param[in]  n_samples  The n samples
+ *
+ * @return     { description_of_the_return_value }
+ */
+static bool microphone_inference_start(uint32_t n_samples)
+{
+    if (!slice_queue_init(&slice_queue, CONFIG_AUDIO_SLICE_QUEUE_DEPTH, n_samples)) {
+        return false;
+    }
 
-    // // configure the data receive callback
-    // PDM.onReceive(&pdm_data_ready_inference_callback);
+#ifdef CONFIG_AUDIO_VAD_ENABLE
+    slice_classifier_init_gate(&energy_gate);
+#endif
 
-    // PDM.setBufferSize((n_samples >> 1) * sizeof(int16_t));
+    record_ready = true;
 
-    // // initialize PDM with:
-    // // - one channel (mono mode)
-    // // - a 16 kHz sample rate
-    // if (!PDM.begin(1, EI_CLASSIFIER_FREQUENCY)) {
-    //     printf("Failed to start PDM!");
-    // }
+    task_plan_create(TASK_MICROPHONE, microphoneTask, NULL, &mic_handle);
+    task_plan_create(TASK_INFERENCE, inferenceTask, NULL, &inference_handle);
 
-    // // set the gain, defaults to 20
-    // PDM.setGain(127);
     return true;
 }
 
@@ -235,44 +478,50 @@ static bool microphone_inference_start(uint32_t n_samples)
  */
 static bool microphone_inference_record(void)
 {
-    bool ret = true;
-
-    if (inference.buf_ready == 1) {
-        printf(
-            "Error sample buffer overrun. Decrease the number of slices per model window "
-            "(EI_CLASSIFIER_SLICES_PER_MODEL_WINDOW)\n");
-        ret = false;
+    while ((current_slice = slice_queue_read_slot(&slice_queue)) == NULL) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
     }
 
-    while (inference.buf_ready == 0) {
-        vTaskDelay(pdMS_TO_TICKS(1));
-    }
-
-    inference.buf_ready = 0;
-
-    return ret;
+    return true;
 }
 
 /**
- * Get raw audio signal data
+ * @brief      Stop PDM and release buffers
  */
-static int microphone_audio_signal_get_data(size_t offset, size_t length, float *out_ptr)
+static void microphone_inference_end(void)
 {
-    numpy::int16_to_float(&inference.buffers[inference.buf_select ^ 1][offset], out_ptr, length);
-
-    return 0;
+    record_ready = false;
+    slice_queue_deinit(&slice_queue);
+    slice_classifier_deinit();
 }
 
+#if CONFIG_CLASSIFIER_LAYER_PROFILE
 /**
- * @brief      Stop PDM and release buffers
+ * @brief      Log the average CPU cycles spent in every layer of the model
+ *             since the last call, then start counting again
  */
-static void microphone_inference_end(void)
+static void log_layer_profile(void)
 {
-    // PDM.end();
-    free(inference.buffers[0]);
-    free(inference.buffers[1]);
-    free(sampleBuffer);
+    uint32_t invokes = trained_model_layer_invokes();
+    uint64_t total = 0;
+    for (size_t ix = 0; ix < trained_model_layers(); ix++) {
+        total += trained_model_layer_ticks(ix);
+    }
+
+    ESP_LOGI(TAG, "Layer profile over %u inferences (%s kernels): %llu cycles per inference",
+        invokes, EI_CLASSIFIER_TFLITE_ENABLE_XTENSA_KERNELS ? "Xtensa" : "reference", total / invokes);
+    for (size_t ix = 0; ix < trained_model_layers(); ix++) {
+        uint64_t ticks = trained_model_layer_ticks(ix);
+        ESP_LOGI(TAG, "    %u %-16s %8llu cycles %5.1f%%", ix, trained_model_layer_name(ix),
+            ticks / invokes, total ? 100.0f * ticks / total : 0.0f);
+    }
+    trained_model_layer_ticks_reset();
 }
+#endif
+
+#if CONFIG_AUDIO_SAMPLE_RATE != EI_CLASSIFIER_FREQUENCY
+#warning "Capture sample rate does not match the model, check the audio capture mode in menuconfig"
+#endif
 
 #if !defined(EI_CLASSIFIER_SENSOR) || EI_CLASSIFIER_SENSOR != EI_CLASSIFIER_SENSOR_MICROPHONE
 #error "Invalid model for current sensor."
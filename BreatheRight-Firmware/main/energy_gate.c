@@ -0,0 +1,117 @@
+/*
+ * Energy / voice activity gate
+ * BreatheRight v1.0
+ * energy_gate.c
+ * 
+ * Copyright (C) 2020 Upbeat Labs LLC or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "energy_gate.h"
+
+// Noise floor smoothing as right shifts: fall in ~2 slices, rise in ~32 slices (about 10 s).
+// The rise keeps the bits it shifts out in floor_frac, so steps below one LSB still add up.
+#define FLOOR_FALL_SHIFT 1
+#define FLOOR_RISE_SHIFT 5
+
+void energy_gate_init(ENERGY_GATE* g, uint32_t frame_samples, uint32_t threshold_db, uint32_t min_rms,
+                      uint32_t min_zcr, uint32_t hangover_slices) {
+    memset(g, 0, sizeof(*g));
+    g->frame_samples = frame_samples;
+    // threshold_db is a power ratio, and energies are powers: 10^(dB / 10), in Q8.
+    g->ratio_q8 = (uint32_t)(powf(10.0f, threshold_db / 10.0f) * 256.0f);
+    g->min_energy = min_rms * min_rms;
+    g->min_zcr = min_zcr;
+    g->hangover_slices = hangover_slices;
+}
+
+bool energy_gate_update(ENERGY_GATE* g, const int16_t* pcm, size_t n, ENERGY_GATE_RESULT* result) {
+    uint32_t peak_energy = 0;
+    uint32_t peak_zcr = 0;
+    uint32_t min_energy = UINT32_MAX;
+
+    for (size_t start = 0; start + g->frame_samples <= n; start += g->frame_samples) {
+        const int16_t* frame = &pcm[start];
+        uint64_t sum = 0;
+        uint32_t crossings = 0;
+
+        for (uint32_t i = 0; i < g->frame_samples; i++) {
+            int32_t s = frame[i];
+            sum += (uint32_t)(s * s);
+            if (i > 0) {
+                crossings += (s ^ frame[i - 1]) < 0;
+            }
+        }
+
+        uint32_t energy = (uint32_t)(sum / g->frame_samples);
+        if (energy > peak_energy) {
+            peak_energy = energy;
+            peak_zcr = crossings * 1000 / g->frame_samples;
+        }
+        if (energy < min_energy) {
+            min_energy = energy;
+        }
+    }
+
+    if (min_energy == UINT32_MAX) {
+        min_energy = 0;
+    }
+
+    if (!g->initialized) {
+        g->noise_floor = min_energy;
+        g->initialized = true;
+    } else if (min_energy < g->noise_floor) {
+        // Rounded, so the floor reaches min_energy instead of stopping one short
+        g->noise_floor -= (g->noise_floor - min_energy + (1 << (FLOOR_FALL_SHIFT - 1))) >> FLOOR_FALL_SHIFT;
+        g->floor_frac = 0;
+    } else {
+        g->floor_frac += min_energy - g->noise_floor;
+        g->noise_floor += g->floor_frac >> FLOOR_RISE_SHIFT;
+        g->floor_frac &= (1u << FLOOR_RISE_SHIFT) - 1;
+    }
+
+    uint64_t threshold = ((uint64_t)g->noise_floor * g->ratio_q8) >> 8;
+    bool active = peak_energy > threshold && peak_energy > g->min_energy && peak_zcr >= g->min_zcr;
+
+    if (active) {
+        g->hangover = g->hangover_slices;
+    }
+    bool open = active || g->hangover > 0;
+    if (!active && g->hangover > 0) {
+        g->hangover--;
+    }
+
+    if (open) {
+        g->processed++;
+    } else {
+        g->gated++;
+    }
+
+    if (result != NULL) {
+        result->peak_rms = (uint32_t)sqrtf((float)peak_energy);
+        result->floor_rms = (uint32_t)sqrtf((float)g->noise_floor);
+        result->zcr = peak_zcr;
+        result->active = active;
+        result->open = open;
+    }
+    return open;
+}
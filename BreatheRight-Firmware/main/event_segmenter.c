@@ -0,0 +1,167 @@
+/*
+ * Cough / sneeze event segmenter
+ * BreatheRight v1.0
+ * event_segmenter.c
+ * 
+ * Copyright (C) 2020 Upbeat Labs LLC or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "event_segmenter.h"
+
+static const char* const kind_labels[EVENT_KIND_COUNT] = { "cough", "sneeze" };
+
+void event_segmenter_init(EVENT_SEGMENTER* s, const char* const* labels, size_t label_count, float onset,
+                          float offset, uint32_t refractory_slices, uint32_t max_slices, uint32_t slice_samples,
+                          uint32_t window_slices) {
+    memset(s, 0, sizeof(*s));
+    s->onset = onset;
+    s->offset = offset;
+    s->refractory_slices = refractory_slices;
+    s->max_slices = max_slices;
+    s->slice_samples = slice_samples;
+    s->window_slices = window_slices;
+
+    for (int k = 0; k < EVENT_KIND_COUNT; k++) {
+        s->track[k].label_ix = -1;
+        for (size_t ix = 0; ix < label_count; ix++) {
+            if (strcmp(labels[ix], kind_labels[k]) == 0) {
+                s->track[k].label_ix = (int)ix;
+                break;
+            }
+        }
+    }
+}
+
+static uint32_t slice_start_sample(const EVENT_SEGMENTER* s, uint32_t slice) {
+    return s->origin_sample + (slice - s->origin_slice) * s->slice_samples;
+}
+
+static void close_event(EVENT_SEGMENTER* s, int kind, SEGMENT_EVENT* e) {
+    EVENT_TRACK* t = &s->track[kind];
+
+    // The last high window still held the event, but only its newest slice is
+    // known to be later than the previous windows.
+    uint32_t start = slice_start_sample(s, t->start_slice);
+    uint32_t end = slice_start_sample(s, t->last_slice + 2 - s->window_slices);
+    int32_t duration = (int32_t)(end - start);
+
+    e->start_sample = start;
+    e->duration = duration > (int32_t)s->slice_samples ? (uint32_t)duration : s->slice_samples;
+    e->kind = (uint8_t)kind;
+    e->peak = (uint8_t)(t->peak >= 1.0f ? 255 : t->peak * 255.0f + 0.5f);
+
+    t->active = false;
+    t->refractory = s->refractory_slices;
+}
+
+size_t event_segmenter_retime(EVENT_SEGMENTER* s, uint32_t slice, uint32_t refractory_slices, uint32_t max_slices,
+                              uint32_t slice_samples, uint32_t window_slices, SEGMENT_EVENT* out, size_t max_out) {
+    size_t n = 0;
+
+    for (int k = 0; k < EVENT_KIND_COUNT; k++) {
+        EVENT_TRACK* t = &s->track[k];
+        if (t->label_ix < 0 || !t->active) {
+            continue;
+        }
+        SEGMENT_EVENT e;
+        close_event(s, k, &e);
+        if (n < max_out) {
+            out[n++] = e;
+        }
+    }
+
+    s->origin_sample = slice_start_sample(s, slice);
+    s->origin_slice = slice;
+    s->refractory_slices = refractory_slices;
+    s->max_slices = max_slices;
+    s->slice_samples = slice_samples;
+    s->window_slices = window_slices;
+    for (int k = 0; k < EVENT_KIND_COUNT; k++) {
+        if (s->track[k].refractory > refractory_slices) {
+            s->track[k].refractory = refractory_slices;
+        }
+    }
+    return n;
+}
+
+size_t event_segmenter_update(EVENT_SEGMENTER* s, uint32_t slice, const float* scores, SEGMENT_EVENT* out,
+                              size_t max_out) {
+    size_t n = 0;
+
+    for (int k = 0; k < EVENT_KIND_COUNT; k++) {
+        EVENT_TRACK* t = &s->track[k];
+        if (t->label_ix < 0) {
+            continue;
+        }
+        float v = scores ? scores[t->label_ix] : 0.0f;
+
+        if (t->active) {
+            if (v >= s->offset && slice == t->last_slice + 1 && slice - t->start_slice < s->max_slices) {
+                t->last_slice = slice;
+                if (v > t->peak) {
+                    t->peak = v;
+                }
+                continue;
+            }
+            SEGMENT_EVENT e;
+            close_event(s, k, &e);
+            if (n < max_out) {
+                out[n++] = e;
+            }
+            continue;
+        }
+
+        if (t->refractory > 0) {
+            t->refractory--;
+            continue;
+        }
+        if (v >= s->onset) {
+            t->active = true;
+            t->start_slice = slice;
+            t->last_slice = slice;
+            t->peak = v;
+        }
+    }
+    return n;
+}
+
+void event_ring_push(EVENT_RING* r, const SEGMENT_EVENT* e) {
+    r->events[r->head] = *e;
+    r->head = (r->head + 1) % EVENT_RING_SIZE;
+    if (r->count == EVENT_RING_SIZE) {
+        r->dropped++;
+    } else {
+        r->count++;
+    }
+}
+
+size_t event_ring_drain(EVENT_RING* r, SEGMENT_EVENT* out, size_t max) {
+    size_t n = 0;
+    uint32_t tail = (r->head + EVENT_RING_SIZE - r->count) % EVENT_RING_SIZE;
+
+    while (n < max && r->count > 0) {
+        out[n++] = r->events[tail];
+        tail = (tail + 1) % EVENT_RING_SIZE;
+        r->count--;
+    }
+    return n;
+}
@@ -0,0 +1,89 @@
+/*
+ * Audio capture engine
+ * BreatheRight v1.0
+ * audio_capture.h
+ * 
+ * Copyright (C) 2020 Upbeat Labs LLC or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define AUDIO_CAPTURE_TAG "AUDIO-CAPTURE"
+
+/** Capture health counters, all monotonically increasing except max_fill. */
+typedef struct AUDIO_CAPTURE_STATS {
+    uint32_t dma_buffers;       // I2S_EVENT_RX_DONE events serviced
+    uint64_t input_samples;     // samples read from I2S at the I2S rate
+    uint32_t samples;           // samples written to the ring at CONFIG_AUDIO_SAMPLE_RATE
+    uint64_t dsp_cycles;        // CPU cycles spent in the decimator
+    uint32_t dma_errors;        // I2S_EVENT_DMA_ERROR events
+    uint32_t dma_overflows;     // DMA buffers the driver overwrote before the capture task read them
+    uint32_t ring_overflows;    // DMA buffers discarded because the consumer fell behind
+    uint32_t dropped_samples;   // samples lost to both overflows, at CONFIG_AUDIO_SAMPLE_RATE
+    uint32_t short_reads;       // i2s_read returned less than one DMA buffer
+    uint32_t max_fill;          // ring high-water mark in samples
+} AUDIO_CAPTURE_STATS;
+
+/**
+ * Called from the capture task with every decimated DMA buffer that made it
+ * into the ring. Runs at capture priority, so it must copy and return.
+ */
+typedef void (*AUDIO_CAPTURE_TAP)(const int16_t* pcm, size_t samples);
+
+/**
+ * Install the I2S driver with the configured DMA ring and start the capture
+ * task. The capture task only wakes on I2S_EVENT_RX_DONE, decimates each DMA
+ * buffer to CONFIG_AUDIO_SAMPLE_RATE and appends it to an internal RAM ring.
+ */
+bool audio_capture_start();
+
+/**
+ * Block until `samples` samples are available and copy them out of the ring.
+ * Only one task may consume from the ring. Returns the number of samples
+ * copied, 0 on timeout.
+ */
+size_t audio_capture_read(int16_t* dst, size_t samples, TickType_t ticks_to_wait);
+
+/** Samples currently buffered in the ring. */
+size_t audio_capture_available();
+
+/** Install a tap next to the ring consumer, NULL removes it. */
+void audio_capture_set_tap(AUDIO_CAPTURE_TAP tap);
+
+/** Snapshot of the capture counters. */
+void audio_capture_get_stats(AUDIO_CAPTURE_STATS* stats);
+
+/** Number of events that left a hole in the captured audio. */
+uint32_t audio_capture_gaps(const AUDIO_CAPTURE_STATS* stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,71 @@
+/*
+ * Audio decimator
+ * BreatheRight v1.0
+ * audio_decimator.h
+ * 
+ * Copyright (C) 2020 Upbeat Labs LLC or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** Taps of the anti-alias FIR, split into AUDIO_DECIMATOR_TAPS / factor phases. */
+#define AUDIO_DECIMATOR_TAPS 54
+
+/** Gain is applied in Q8, 256 is unity. */
+#define AUDIO_DECIMATOR_UNITY_GAIN 256
+
+typedef struct AUDIO_DECIMATOR {
+    int16_t delay[2 * AUDIO_DECIMATOR_TAPS];   // doubled so the FIR window is always contiguous
+    int pos;
+    int phase;
+    int factor;
+    int dc_block;
+    int32_t dc_x1;
+    int32_t dc_y1;              // Q8
+    int32_t gain_q8;
+} AUDIO_DECIMATOR;
+
+/**
+ * Reset the decimator.
+ *
+ * @param factor    1 (no rate change) or 3 (48 kHz to 16 kHz)
+ * @param gain_q8   Output gain in Q8
+ * @param dc_block  Non-zero to run the DC blocking filter
+ */
+void audio_decimator_init(AUDIO_DECIMATOR* d, int factor, int32_t gain_q8, int dc_block);
+
+/**
+ * Low-pass, decimate, DC-block and scale `n` input samples in a single pass.
+ * `out` must hold n / factor + 1 samples. `in` and `out` may alias when the
+ * factor is 1. Returns the number of samples written.
+ */
+size_t audio_decimator_process(AUDIO_DECIMATOR* d, const int16_t* in, size_t n, int16_t* out);
+
+#ifdef __cplusplus
+}
+#endif
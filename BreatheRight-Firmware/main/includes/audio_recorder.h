@@ -0,0 +1,84 @@
+/*
+ * Raw audio recorder
+ * BreatheRight v1.0
+ * audio_recorder.h
+ *
+ * Copyright (C) 2020 Upbeat Labs LLC or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define AUDIO_RECORDER_TAG "AUDIO-RECORDER"
+
+/**
+ * Background recorder for building datasets. The capture task copies every
+ * decimated DMA buffer into one of two CONFIG_AUDIO_RECORDER_BLOCK_BYTES
+ * blocks; recorderTask writes full blocks to the SD card or the spiffs
+ * partition while the capture task fills the other one, so a slow write
+ * never blocks capture or inference. When both blocks are still owned by
+ * the writer the block being filled is discarded and counted as dropped.
+ *
+ * Audio is stored as CONFIG_AUDIO_SAMPLE_RATE mono 16 bit PCM in segments of
+ * CONFIG_AUDIO_RECORDER_SEGMENT_S seconds, RECnnnnn.WAV or RECnnnnn.RAW.
+ * The WAV header is padded to 512 bytes so every block write stays sector
+ * aligned.
+ */
+
+/** Recorder counters, all monotonically increasing except recording. */
+typedef struct AUDIO_RECORDER_STATS {
+    bool recording;
+    uint32_t segments;          // files opened
+    uint32_t blocks_written;
+    uint32_t blocks_dropped;    // blocks discarded because the writer fell behind
+    uint32_t write_errors;
+    uint64_t bytes_written;
+    uint64_t write_us;          // time spent in write(), for the storage throughput
+    uint32_t max_write_us;      // slowest block write
+} AUDIO_RECORDER_STATS;
+
+/** Start recorderTask and hook it into the capture path. Recording starts off. */
+bool audio_recorder_init();
+
+/**
+ * Start or stop recording. Returns immediately, recorderTask mounts the
+ * storage and opens or closes the segment.
+ */
+void audio_recorder_enable(bool enable);
+
+/** Whether recording was requested, by audio_recorder_enable or after a write error. */
+bool audio_recorder_enabled();
+
+/** Snapshot of the recorder counters. */
+void audio_recorder_get_stats(AUDIO_RECORDER_STATS* stats);
+
+/** Storage write throughput over all recorded blocks, in KiB/s. */
+uint32_t audio_recorder_throughput_kbs(const AUDIO_RECORDER_STATS* stats);
+
+#ifdef __cplusplus
+}
+#endif
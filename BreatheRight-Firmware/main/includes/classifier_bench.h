@@ -0,0 +1,426 @@
+/*
+ * Classifier benchmarks
+ * BreatheRight v1.0
+ * classifier_bench.h
+ *
+ * Copyright (C) 2020 Upbeat Labs LLC or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#ifndef __cplusplus
+#error "classifier_bench.h needs the Edge Impulse C++ library"
+#endif
+
+#include <cmath>
+#include <cstring>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "xtensa/hal.h"
+#include "slice_classifier.h"
+
+/**
+ * Startup benchmarks of the classifier, selected in menuconfig, on synthetic
+ * audio. Run by edge_impulse_start and inferenceTask on the device and by
+ * host/mfcc_bench.cpp on the host, so the numbers of both come from the same
+ * code.
+ *
+ * Header only like slice_classifier.h: include it once, after it.
+ */
+
+/**
+ * @brief      Allocate `length` samples of background noise with a louder
+ *             burst over a fifth of it (200 ms of a 1 s window), so the MFCC
+ *             sees a realistic spread. PSRAM first, the benchmarks time the
+ *             classifier's own buffers, not the input.
+ *
+ * @return     The audio, free() it; NULL when out of memory
+ */
+static inline int16_t *classifier_bench_audio(size_t length)
+{
+    int16_t *audio = (int16_t*)heap_caps_malloc(length * sizeof(int16_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (audio == NULL) {
+        audio = (int16_t*)malloc(length * sizeof(int16_t));
+    }
+    if (audio == NULL) {
+        return NULL;
+    }
+
+    uint32_t lcg = 1;
+    for (size_t ix = 0; ix < length; ix++) {
+        lcg = lcg * 1664525 + 1013904223;
+        int32_t noise = (int32_t)(lcg >> 22) - 512;
+        audio[ix] = (int16_t)((ix > length * 3 / 8 && ix < length * 23 / 40) ? noise * 16 : noise);
+    }
+    return audio;
+}
+
+#if CONFIG_AUDIO_MFCC_BENCHMARK || CONFIG_CLASSIFIER_MEM_BENCHMARK
+/** Audio the benchmark signals read from */
+static const int16_t *classifier_bench_samples;
+
+static int classifier_bench_get_data(size_t offset, size_t length, float *out_ptr)
+{
+    numpy::int16_to_float(&classifier_bench_samples[offset], out_ptr, length);
+
+    return 0;
+}
+#endif
+
+#if CONFIG_AUDIO_MFCC_BENCHMARK
+static int classifier_bench_get_data_i16(size_t offset, size_t length, int16_t *out_ptr)
+{
+    memcpy(out_ptr, &classifier_bench_samples[offset], length * sizeof(int16_t));
+
+    return 0;
+}
+#endif
+
+#if CONFIG_AUDIO_MFCC_BENCHMARK
+/**
+ * @brief      Time the generic float MFCC of a whole model window, with the
+ *             float and the int16 signal, and log the best time per window
+ *             of both. The FFT plans are cached between frames with
+ *             AUDIO_FFT_PLAN_CACHE, build without it to compare.
+ */
+static inline void classifier_bench_mfcc_window(const char *tag)
+{
+    const size_t length = EI_CLASSIFIER_RAW_SAMPLE_COUNT;
+    const float pre_cof = 0.98f;
+    const int runs = 20;
+
+    int16_t *audio = classifier_bench_audio(length);
+    if (audio == NULL) {
+        ESP_LOGE(tag, "MFCC window benchmark: no memory for the window");
+        return;
+    }
+    classifier_bench_samples = audio;
+
+    signal_t signal;
+    signal.total_length = length;
+    signal.get_data = &classifier_bench_get_data;
+    signal_i16_t signal_i16;
+    signal_i16.total_length = length;
+    signal_i16.get_data = &classifier_bench_get_data_i16;
+
+    matrix_size_t size = speechpy::feature::calculate_mfcc_buffer_size(length, EI_CLASSIFIER_FREQUENCY,
+        EI_CLASSIFIER_MFCC_FRAME_LENGTH, EI_CLASSIFIER_MFCC_FRAME_STRIDE, EI_CLASSIFIER_MFCC_NUM_CEPSTRAL, 2);
+    matrix_t features(size.rows, size.cols);
+    if (features.buffer == NULL || size.rows == 0) {
+        ESP_LOGE(tag, "MFCC window benchmark: no memory for the features");
+        free(audio);
+        return;
+    }
+
+    const int limit = ei_set_dsp_workers(1);
+    int64_t best_us[2] = { INT64_MAX, INT64_MAX };
+    for (int r = 0; r < runs; r++) {
+        int64_t start = esp_timer_get_time();
+        int res = speechpy::feature::mfcc(&features, &signal, EI_CLASSIFIER_FREQUENCY,
+            EI_CLASSIFIER_MFCC_FRAME_LENGTH, EI_CLASSIFIER_MFCC_FRAME_STRIDE, EI_CLASSIFIER_MFCC_NUM_CEPSTRAL,
+            EI_CLASSIFIER_MFCC_NUM_FILTERS, EI_CLASSIFIER_MFCC_FFT_LENGTH, EI_CLASSIFIER_MFCC_LOW_FREQUENCY,
+            EI_CLASSIFIER_MFCC_HIGH_FREQUENCY, true, 2);
+        int64_t float_us = esp_timer_get_time() - start;
+
+        start = esp_timer_get_time();
+        int res_i16 = speechpy::feature::mfcc_i16(&features, &signal_i16, 0, length, 0, pre_cof,
+            EI_CLASSIFIER_FREQUENCY, EI_CLASSIFIER_MFCC_FRAME_LENGTH, EI_CLASSIFIER_MFCC_FRAME_STRIDE,
+            EI_CLASSIFIER_MFCC_NUM_CEPSTRAL, EI_CLASSIFIER_MFCC_NUM_FILTERS, EI_CLASSIFIER_MFCC_FFT_LENGTH,
+            EI_CLASSIFIER_MFCC_LOW_FREQUENCY, EI_CLASSIFIER_MFCC_HIGH_FREQUENCY, true, 2);
+        int64_t i16_us = esp_timer_get_time() - start;
+
+        if (res != EIDSP_OK || res_i16 != EIDSP_OK) {
+            ESP_LOGE(tag, "MFCC window benchmark: MFCC failed (%d, %d)", res, res_i16);
+            break;
+        }
+        if (float_us < best_us[0]) {
+            best_us[0] = float_us;
+        }
+        if (i16_us < best_us[1]) {
+            best_us[1] = i16_us;
+        }
+    }
+    ei_set_dsp_workers(limit);
+
+    ESP_LOGI(tag, "MFCC window benchmark: %u frames, %lld us float signal, %lld us int16 signal (FFT plans %s)",
+        (unsigned)size.rows, (long long)best_us[0], (long long)best_us[1], EIDSP_CACHE_FFT_PLANS ? "cached" : "per frame");
+
+    free(audio);
+}
+#endif
+
+#if CONFIG_AUDIO_MFCC_BENCHMARK && EI_DSP_MFCC_STATIC
+/**
+ * @brief      Time the generic MFCC against the one specialized at compile
+ *             time for the model's DSP config, on one synthetic slice, and
+ *             log the CPU cycles per frame of both
+ */
+static inline void classifier_bench_mfcc_static(const char *tag)
+{
+    const size_t length = EI_CLASSIFIER_SLICE_SIZE;
+    const float pre_cof = 0.98f;
+    const int runs = 10;
+
+    int16_t *audio = classifier_bench_audio(length);
+    if (audio == NULL) {
+        ESP_LOGE(tag, "MFCC benchmark: no memory for the slice");
+        return;
+    }
+    classifier_bench_samples = audio;
+
+    signal_i16_t signal;
+    signal.total_length = length;
+    signal.get_data = &classifier_bench_get_data_i16;
+
+    matrix_size_t size = speechpy::feature::calculate_mfcc_buffer_size(length, EI_CLASSIFIER_FREQUENCY,
+        EI_CLASSIFIER_MFCC_FRAME_LENGTH, EI_CLASSIFIER_MFCC_FRAME_STRIDE, EI_CLASSIFIER_MFCC_NUM_CEPSTRAL, 2);
+    matrix_t generic(size.rows, size.cols);
+    matrix_t specialized(size.rows, size.cols);
+    if (generic.buffer == NULL || specialized.buffer == NULL || size.rows == 0) {
+        ESP_LOGE(tag, "MFCC benchmark: no memory for the features");
+        free(audio);
+        return;
+    }
+
+    // Cycles of one core, classifier_bench_mfcc_workers times the split
+    const int limit = ei_set_dsp_workers(1);
+    uint64_t generic_cycles = 0, static_cycles = 0;
+    for (int r = 0; r < runs; r++) {
+        uint32_t start = xthal_get_ccount();
+        int res = speechpy::feature::mfcc_i16(&generic, &signal, 0, length, 0, pre_cof,
+            EI_CLASSIFIER_FREQUENCY, EI_CLASSIFIER_MFCC_FRAME_LENGTH, EI_CLASSIFIER_MFCC_FRAME_STRIDE,
+            EI_CLASSIFIER_MFCC_NUM_CEPSTRAL, EI_CLASSIFIER_MFCC_NUM_FILTERS, EI_CLASSIFIER_MFCC_FFT_LENGTH,
+            EI_CLASSIFIER_MFCC_LOW_FREQUENCY, EI_CLASSIFIER_MFCC_HIGH_FREQUENCY, true, 2);
+        generic_cycles += xthal_get_ccount() - start;
+
+        start = xthal_get_ccount();
+        int res_static = ei_dsp_mfcc_static_t::mfcc_i16(&specialized, &signal, 0, length, 0, pre_cof,
+            EI_CLASSIFIER_MFCC_FRAME_LENGTH, EI_CLASSIFIER_MFCC_FRAME_STRIDE, true);
+        static_cycles += xthal_get_ccount() - start;
+
+        if (res != EIDSP_OK || res_static != EIDSP_OK) {
+            ESP_LOGE(tag, "MFCC benchmark: MFCC failed (%d, %d)", res, res_static);
+            break;
+        }
+    }
+    ei_set_dsp_workers(limit);
+
+    float max_diff = 0.0f;
+    for (size_t ix = 0; ix < size.rows * size.cols; ix++) {
+        float diff = fabsf(generic.buffer[ix] - specialized.buffer[ix]);
+        if (diff > max_diff) {
+            max_diff = diff;
+        }
+    }
+
+    const uint64_t frames = (uint64_t)runs * size.rows;
+    ESP_LOGI(tag, "MFCC benchmark: %llu cycles per frame generic, %llu with compile time tables (max feature diff %.6f)",
+        (unsigned long long)(generic_cycles / frames), (unsigned long long)(static_cycles / frames), max_diff);
+
+    free(audio);
+}
+#endif
+
+#if CONFIG_AUDIO_MFCC_BENCHMARK && EI_DSP_MFCC_STATIC && EIDSP_MFCC_PARALLEL
+/**
+ * @brief      Time the MFCC of one synthetic slice with one DSP worker and
+ *             with two, and log the time per slice of both and whether the
+ *             features are bit identical. On the device call it from
+ *             inferenceTask, so the caller's share runs where it does when
+ *             classifying.
+ */
+static inline void classifier_bench_mfcc_workers(const char *tag)
+{
+    const size_t length = slice_classifier_slice_size(slice_classifier_slices());
+    const float pre_cof = 0.98f;
+    const int runs = 20;
+
+    int16_t *audio = classifier_bench_audio(length);
+    if (audio == NULL) {
+        ESP_LOGE(tag, "MFCC workers benchmark: no memory for the slice");
+        return;
+    }
+    classifier_bench_samples = audio;
+
+    signal_i16_t signal;
+    signal.total_length = length;
+    signal.get_data = &classifier_bench_get_data_i16;
+
+    matrix_size_t size = speechpy::feature::calculate_mfcc_buffer_size(length, EI_CLASSIFIER_FREQUENCY,
+        EI_CLASSIFIER_MFCC_FRAME_LENGTH, EI_CLASSIFIER_MFCC_FRAME_STRIDE, EI_CLASSIFIER_MFCC_NUM_CEPSTRAL, 2);
+    matrix_t one_worker(size.rows, size.cols);
+    matrix_t two_workers(size.rows, size.cols);
+    matrix_t *features[2] = { &one_worker, &two_workers };
+    if (one_worker.buffer == NULL || two_workers.buffer == NULL || size.rows == 0) {
+        ESP_LOGE(tag, "MFCC workers benchmark: no memory for the features");
+        free(audio);
+        return;
+    }
+
+    int64_t slice_us[2] = { 0, 0 };
+    bool failed = false;
+    const int limit = ei_set_dsp_workers(1);
+    for (int workers = 1; workers <= 2 && !failed; workers++) {
+        ei_set_dsp_workers(workers);
+        if (ei_dsp_workers() != workers) {
+            break;
+        }
+        int64_t total_us = 0;
+        for (int r = 0; r < runs && !failed; r++) {
+            int64_t start = esp_timer_get_time();
+            int res = ei_dsp_mfcc_static_t::mfcc_i16(features[workers - 1], &signal, 0, length, 0, pre_cof,
+                EI_CLASSIFIER_MFCC_FRAME_LENGTH, EI_CLASSIFIER_MFCC_FRAME_STRIDE, true);
+            total_us += esp_timer_get_time() - start;
+            if (res != EIDSP_OK) {
+                ESP_LOGE(tag, "MFCC workers benchmark: MFCC failed with %d workers (%d)", workers, res);
+                failed = true;
+            }
+        }
+        slice_us[workers - 1] = total_us / runs;
+    }
+    ei_set_dsp_workers(limit);
+
+    if (!failed && slice_us[1] == 0) {
+        ESP_LOGW(tag, "MFCC workers benchmark: %lld us per slice, no second worker", (long long)slice_us[0]);
+    }
+    else if (!failed) {
+        bool same = memcmp(one_worker.buffer, two_workers.buffer, size.rows * size.cols * sizeof(float)) == 0;
+        ESP_LOGI(tag, "MFCC workers benchmark: %u frames per slice, %lld us with 1 worker, %lld us with 2 (%.2fx), features %s",
+            (unsigned)size.rows, (long long)slice_us[0], (long long)slice_us[1], (float)slice_us[0] / slice_us[1],
+            same ? "identical" : "DIFFER");
+    }
+
+    free(audio);
+}
+#endif
+
+#if CONFIG_CLASSIFIER_HOP_BENCHMARK
+/**
+ * @brief      Classify synthetic audio with every number of slices per model
+ *             window and log the time per slice against the hop, i.e. the
+ *             share of one core the classifier needs at that hop. Runs
+ *             through slice_classifier_run like inferenceTask, without the
+ *             energy gate, so every slice is classified.
+ *
+ * @param[in]  slices_after  Slices per model window to go back to afterwards
+ */
+static inline void classifier_bench_hop(const char *tag, uint32_t slices_after)
+{
+    const int windows = 4;
+
+    int16_t *audio = classifier_bench_audio(EI_CLASSIFIER_RAW_SAMPLE_COUNT);
+    if (audio == NULL) {
+        ESP_LOGE(tag, "Hop benchmark: no memory for the model window");
+        return;
+    }
+
+    for (uint32_t slices = SLICE_CLASSIFIER_MIN_SLICES; slices <= SLICE_CLASSIFIER_MAX_SLICES; slices++) {
+        if (!slice_classifier_set_slices(slices)) {
+            continue;
+        }
+        const uint32_t slice_size = slice_classifier_slice_size(slices);
+
+        // The first window only fills the features, keep it out of the timing
+        int64_t total_us = 0;
+        EI_IMPULSE_ERROR res = EI_IMPULSE_OK;
+        for (uint32_t ix = 0; ix < slices * (windows + 1) && res == EI_IMPULSE_OK; ix++) {
+            ei_impulse_result_t result;
+            memset(&result, 0, sizeof(result));
+            int64_t start = esp_timer_get_time();
+            res = slice_classifier_run(&audio[(ix % slices) * slice_size], &result, false);
+            if (ix >= slices) {
+                total_us += esp_timer_get_time() - start;
+            }
+        }
+        if (res != EI_IMPULSE_OK) {
+            ESP_LOGE(tag, "Hop benchmark: classifier failed with %u slices (%d)", (unsigned)slices, res);
+            continue;
+        }
+
+        const uint32_t hop_us = (uint64_t)slice_size * 1000000 / EI_CLASSIFIER_FREQUENCY;
+        const int64_t slice_us = total_us / (slices * windows);
+        ESP_LOGI(tag, "Hop benchmark: %u slices, %u ms hop: %lld us per slice, %.1f%% CPU",
+            (unsigned)slices, (unsigned)(hop_us / 1000), (long long)slice_us, 100.0f * slice_us / hop_us);
+    }
+
+    slice_classifier_set_slices(slices_after);
+    free(audio);
+}
+#endif
+
+#if CONFIG_CLASSIFIER_MEM_BENCHMARK
+/**
+ * @brief      Time full-window inferences on synthetic audio with every
+ *             buffer placement. The input window itself stays in PSRAM for
+ *             all runs, only the classifier's own buffers move.
+ */
+static inline void classifier_bench_placement(const char *tag)
+{
+    static const ei_mem_placement_t placements[] = { EI_MEM_DEFAULT, EI_MEM_INTERNAL, EI_MEM_EXTERNAL };
+    static const char *names[] = { "default", "internal", "PSRAM" };
+    const int runs = 5;
+
+    int16_t *audio = classifier_bench_audio(EI_CLASSIFIER_RAW_SAMPLE_COUNT);
+    if (audio == NULL) {
+        ESP_LOGE(tag, "Placement benchmark: no memory for the input window");
+        return;
+    }
+    classifier_bench_samples = audio;
+
+    signal_t signal;
+    signal.total_length = EI_CLASSIFIER_RAW_SAMPLE_COUNT;
+    signal.get_data = &classifier_bench_get_data;
+
+    for (size_t p = 0; p < sizeof(placements) / sizeof(placements[0]); p++) {
+        run_classifier_deinit();
+        ei_set_mem_placement(placements[p]);
+
+        // The first run sets up the model in the new placement, keep it out of the timing
+        ei_impulse_result_t result;
+        memset(&result, 0, sizeof(result));
+        run_classifier(&signal, &result, false);
+
+        ei_reset_mem_report();
+        int64_t total_us = 0;
+        int dsp_ms = 0, nn_ms = 0;
+        for (int r = 0; r < runs; r++) {
+            int64_t start = esp_timer_get_time();
+            EI_IMPULSE_ERROR res = run_classifier(&signal, &result, false);
+            total_us += esp_timer_get_time() - start;
+            if (res != EI_IMPULSE_OK) {
+                ESP_LOGE(tag, "Placement benchmark: run_classifier failed (%d)", res);
+                break;
+            }
+            dsp_ms += result.timing.dsp;
+            nn_ms += result.timing.classification;
+        }
+
+        ESP_LOGI(tag, "Placement %s: %lld us per window (DSP %d ms, NN %d ms)",
+            names[p], (long long)(total_us / runs), dsp_ms / runs, nn_ms / runs);
+        slice_classifier_log_mem_report(tag, names[p]);
+    }
+
+    run_classifier_deinit();
+    ei_set_mem_placement(EI_MEM_DEFAULT);
+    free(audio);
+}
+#endif
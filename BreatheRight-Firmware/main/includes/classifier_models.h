@@ -0,0 +1,60 @@
+/*
+ * Classifier models
+ * BreatheRight v1.0
+ * classifier_models.h
+ *
+ * Copyright (C) 2020 Upbeat Labs LLC or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#ifndef __cplusplus
+#error "classifier_models.h needs the Edge Impulse C++ library"
+#endif
+
+/**
+ * Models run on the features of each model window when
+ * CONFIG_CLASSIFIER_MULTI_MODEL is set, see slice_classifier_run. The first
+ * one drives the event segmenter and keeps the impulse model.
+ *
+ * To add a model, export it from Edge Impulse as an EON compiled C++ library,
+ * rename the trained_model_ prefix of tflite-model/trained_model_compiled.*
+ * (e.g. to wheeze_model_) and copy the two files into edge-impulse/tflite-model.
+ * Then include the header here, declare its labels and the MFCC config from
+ * its model_metadata.h, and list it:
+ *
+ *   #include "tflite-model/wheeze_model_compiled.h"
+ *
+ *   static const char *wheeze_categories[] = { "wheeze", "normal" };
+ *   static const ei_dsp_config_mfcc_t wheeze_dsp_config = { 2, 1, 13, 0.02f, ... };
+ *
+ *   EI_COMPILED_MODEL(wheeze_model, wheeze_categories, &wheeze_dsp_config),
+ *
+ * Include this once, after Cough_Tutorial_inferencing.h. A build can list
+ * its models in a header of its own by defining CLASSIFIER_MODELS_HEADER, the
+ * host build does to run two.
+ */
+#ifdef CLASSIFIER_MODELS_HEADER
+#include CLASSIFIER_MODELS_HEADER
+#else
+static const ei_compiled_model_t classifier_models[] = {
+    ei_impulse_compiled_model,
+};
+#endif
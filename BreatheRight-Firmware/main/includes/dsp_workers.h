@@ -0,0 +1,52 @@
+/*
+ * DSP worker on the second core
+ * BreatheRight v1.0
+ * dsp_workers.h
+ * 
+ * Copyright (C) 2020 Upbeat Labs LLC or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * Second worker of the SDK's ei_dsp_parallel_for (see EIDSP_MFCC_PARALLEL).
+ * dspWorkerTask, pinned by the task plan to the core inferenceTask is not
+ * on, waits for a loop to be posted; then it and the caller claim items one
+ * at a time until none are left. A worker held up by other tasks (Wi-Fi on
+ * core 0) only delays the item it holds, the other one takes the rest.
+ * Which worker computes an item does not change its result.
+ */
+
+/** Start dspWorkerTask. ei_dsp_parallel_for runs everything on the caller until then. */
+bool dsp_workers_start(void);
+
+/** Log the loops run and the share of the items dspWorkerTask took since the last call. */
+void dsp_workers_log(const char* tag);
+
+#ifdef __cplusplus
+}
+#endif
@@ -3,19 +3,54 @@
 #define _MY_EDGE_IMPULSE_H_
 
 #pragma once
+
+#include "event_segmenter.h"
+
 #ifdef __cplusplus
 extern "C"
 {
 #endif
 
+/** Shared with the reporting task, guarded by xEISemaphore. */
 typedef struct EI_DATA {
     uint16_t coughs;
     uint16_t sneezes;
+    EVENT_RING events;
 } EI_DATA;
 
+/**
+ * Capacity counters of the audio pipeline since boot. Every counter has a
+ * single writer task and is read without locking, so a snapshot may mix
+ * values a slice apart.
+ */
+typedef struct EI_HEALTH {
+    uint32_t short_reads;       // i2s_read returned less than one DMA buffer
+    uint32_t dma_overflows;     // DMA buffers the I2S driver overwrote before they were read
+    uint32_t dma_errors;        // I2S_EVENT_DMA_ERROR events
+    uint32_t dropped_samples;   // lost to DMA overflows or discarded by the capture ring
+    uint32_t dropped_slices;    // slices lost to dropped samples, skipped in the slice numbering
+    uint32_t queue_waits;       // microphoneTask found the slice queue full and waited
+    uint32_t max_queue_depth;   // slice queue high-water mark
+    uint32_t slices;            // slices handled by inferenceTask, classified or gated
+    uint32_t deadline_misses;   // slices handled more than one hop after they were captured
+} EI_HEALTH;
+
 #define EDGEIMPULSE_TAB_NAME "EDGE-IMPULSE"
 void edge_impulse_start();
 
+/**
+ * Classify every model window / `slices` from the next captured slice on, e.g.
+ * 4 or 8 slices for a short hop in a busy room, 2 to save power. Safe from any
+ * task. Returns false, changing nothing, if `slices` is out of range.
+ */
+bool edge_impulse_set_slices(uint32_t slices);
+
+/** Slices per model window last set, the one slices are being cut for */
+uint32_t edge_impulse_slices(void);
+
+/** Snapshot of the pipeline health counters, safe from any task. */
+void edge_impulse_get_health(EI_HEALTH *out);
+
 #ifdef __cplusplus
 }
 #endif
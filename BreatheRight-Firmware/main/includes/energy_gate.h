@@ -0,0 +1,81 @@
+/*
+ * Energy / voice activity gate
+ * BreatheRight v1.0
+ * energy_gate.h
+ * 
+ * Copyright (C) 2020 Upbeat Labs LLC or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * Per-slice activity gate in front of the classifier.
+ *
+ * Each slice is split into short frames. The loudest frame decides whether
+ * the slice is active: its energy must clear the adaptive noise floor by the
+ * configured ratio and an absolute minimum, and its zero-crossing rate must
+ * be above the rumble limit. The quietest frame drives the noise floor,
+ * which falls quickly and rises slowly. Once triggered the gate stays open
+ * for `hangover` more slices so the feature window is flushed with real
+ * audio before the classifier is paused again.
+ */
+typedef struct ENERGY_GATE {
+    uint32_t frame_samples;
+    uint32_t ratio_q8;          // energy ratio over the noise floor, Q8
+    uint32_t min_energy;        // absolute minimum mean square
+    uint32_t min_zcr;           // zero crossings per 1000 samples
+    uint32_t hangover_slices;
+
+    uint32_t noise_floor;       // mean square of the noise floor estimate
+    uint32_t floor_frac;        // rise of the floor below one LSB, in 1 / 2^FLOOR_RISE_SHIFT
+    uint32_t hangover;
+    bool initialized;
+
+    uint32_t processed;         // slices let through
+    uint32_t gated;             // slices skipped
+} ENERGY_GATE;
+
+/** Features of the last slice, for logging and diagnostics. */
+typedef struct ENERGY_GATE_RESULT {
+    uint32_t peak_rms;          // RMS of the loudest frame
+    uint32_t floor_rms;         // RMS of the noise floor after the update
+    uint32_t zcr;               // zero crossings per 1000 samples in the loudest frame
+    bool active;                // slice exceeded the thresholds
+    bool open;                  // slice should be classified
+} ENERGY_GATE_RESULT;
+
+void energy_gate_init(ENERGY_GATE* g, uint32_t frame_samples, uint32_t threshold_db, uint32_t min_rms,
+                      uint32_t min_zcr, uint32_t hangover_slices);
+
+/** Analyze one slice and update the gate. Returns true when it should be classified. */
+bool energy_gate_update(ENERGY_GATE* g, const int16_t* pcm, size_t n, ENERGY_GATE_RESULT* result);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,130 @@
+/*
+ * Cough / sneeze event segmenter
+ * BreatheRight v1.0
+ * event_segmenter.h
+ * 
+ * Copyright (C) 2020 Upbeat Labs LLC or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** Event kinds the segmenter tracks. */
+typedef enum EVENT_KIND {
+    EVENT_COUGH = 0,
+    EVENT_SNEEZE,
+    EVENT_KIND_COUNT
+} EVENT_KIND;
+
+/** One detected event, 12 bytes. */
+typedef struct SEGMENT_EVENT {
+    uint32_t start_sample;      // since capture start, wraps after ~74 h at 16 kHz
+    uint32_t duration;          // samples
+    uint8_t kind;               // EVENT_KIND
+    uint8_t peak;               // peak score, 255 is 1.0
+} SEGMENT_EVENT;
+
+/** State of one tracked label. */
+typedef struct EVENT_TRACK {
+    int label_ix;               // classifier output index, -1 when the model has no such label
+    bool active;
+    uint32_t start_slice;
+    uint32_t last_slice;        // last slice that scored above the offset threshold
+    uint32_t refractory;        // slices left before a new onset is accepted
+    float peak;
+} EVENT_TRACK;
+
+/**
+ * Turns per-slice classifier scores into discrete events.
+ *
+ * Every slice is classified over the model window that ends with it, so one
+ * cough scores high in several consecutive windows. An event starts when a
+ * label's score reaches the onset threshold and ends when it falls below the
+ * lower offset threshold, or after max_slices. The onset slice is taken as
+ * the start; the end is the last high window minus the part of it that
+ * precedes its newest slice, so timing resolution is one slice. After an
+ * event the label must stay quiet for `refractory_slices` before it can
+ * trigger again.
+ */
+typedef struct EVENT_SEGMENTER {
+    EVENT_TRACK track[EVENT_KIND_COUNT];
+    float onset;
+    float offset;
+    uint32_t refractory_slices;
+    uint32_t max_slices;
+    uint32_t slice_samples;
+    uint32_t window_slices;
+    uint32_t origin_slice;      // first slice of the current slice length
+    uint32_t origin_sample;     // its start, in samples since capture start
+} EVENT_SEGMENTER;
+
+/** Bounded ring of events, oldest first. Overwrites the oldest event when full. */
+#define EVENT_RING_SIZE 32
+
+typedef struct EVENT_RING {
+    SEGMENT_EVENT events[EVENT_RING_SIZE];
+    uint32_t head;
+    uint32_t count;
+    uint32_t dropped;           // events overwritten before they were read
+} EVENT_RING;
+
+/**
+ * labels/label_count are the classifier categories, the label of each event
+ * kind is looked up once here.
+ */
+void event_segmenter_init(EVENT_SEGMENTER* s, const char* const* labels, size_t label_count, float onset,
+                          float offset, uint32_t refractory_slices, uint32_t max_slices, uint32_t slice_samples,
+                          uint32_t window_slices);
+
+/**
+ * Switch to slices of a different length from slice number `slice` on, e.g.
+ * after the classifier hop changed. Events still open are closed first and
+ * written to out, like event_segmenter_update does; returns their number.
+ * Event times stay relative to capture start.
+ */
+size_t event_segmenter_retime(EVENT_SEGMENTER* s, uint32_t slice, uint32_t refractory_slices, uint32_t max_slices,
+                              uint32_t slice_samples, uint32_t window_slices, SEGMENT_EVENT* out, size_t max_out);
+
+/**
+ * Feed the scores of slice number `slice` (consecutive numbering, gaps allowed).
+ * scores is indexed like the classifier output; NULL means the slice was not
+ * classified and counts as silence. Closed events are written to out, up to
+ * max_out; at most one per kind closes per slice, so EVENT_KIND_COUNT is
+ * always enough. Returns the number written.
+ */
+size_t event_segmenter_update(EVENT_SEGMENTER* s, uint32_t slice, const float* scores, SEGMENT_EVENT* out,
+                              size_t max_out);
+
+void event_ring_push(EVENT_RING* r, const SEGMENT_EVENT* e);
+
+/** Move up to max events into out, oldest first. Returns the number moved. */
+size_t event_ring_drain(EVENT_RING* r, SEGMENT_EVENT* out, size_t max);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,94 @@
+/*
+ * Inference latency profiler
+ * BreatheRight v1.0
+ * inference_profiler.h
+ *
+ * Copyright (C) 2020 Upbeat Labs LLC or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define INFERENCE_PROFILER_TAG "PROFILER"
+
+/**
+ * Latency histograms of the inference pipeline. inferenceTask records the
+ * time it waited for a slice and, for every classified slice, the time
+ * spent in each DSP and classifier stage (from the SDK stage clock, see
+ * EIDSP_PROFILE_STAGES). Every stage has a fixed log-linear histogram, 4
+ * buckets per power of two, so a percentile is within 25% of the recorded
+ * value and recording is a clz and an increment.
+ *
+ * The histograms count from boot and are not locked, a reader may see a
+ * slice half recorded.
+ */
+
+/** Stages in pipeline order, the SDK's ei_stage_t follow the capture wait. */
+typedef enum PROFILE_STAGE {
+    PROFILE_CAPTURE_WAIT = 0,   // inferenceTask waiting for the next slice
+    PROFILE_PREEMPHASIS,
+    PROFILE_FRAMING,
+    PROFILE_FFT,
+    PROFILE_FILTERBANK,
+    PROFILE_DCT,
+    PROFILE_CMVN,
+    PROFILE_INVOKE,
+    PROFILE_POSTPROCESS,
+    PROFILE_STAGE_COUNT
+} PROFILE_STAGE;
+
+/** Percentiles of one stage in microseconds, 0 when nothing was recorded. */
+typedef struct PROFILE_PERCENTILES {
+    uint32_t count;
+    uint32_t p50;
+    uint32_t p95;
+    uint32_t p99;
+    uint32_t max;
+} PROFILE_PERCENTILES;
+
+/** Add one sample to a stage histogram. inferenceTask only. */
+void inference_profiler_record(PROFILE_STAGE stage, uint32_t us);
+
+/** Percentiles of a stage since boot. */
+void inference_profiler_get(PROFILE_STAGE stage, PROFILE_PERCENTILES* out);
+
+/** Short stage name for logs, the debug tab and the shadow. */
+const char* inference_profiler_stage_name(PROFILE_STAGE stage);
+
+/**
+ * Write "name:p50/p95/p99" for every stage with samples, comma separated, for
+ * the shadow. Returns the length written, the text is cut at size - 1.
+ */
+size_t inference_profiler_format(char* buf, size_t size);
+
+/** Log a line per stage with the count, percentiles and max. */
+void inference_profiler_log();
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,328 @@
+/*
+ * Slice classifier
+ * BreatheRight v1.0
+ * slice_classifier.h
+ *
+ * Copyright (C) 2020 Upbeat Labs LLC or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#ifndef __cplusplus
+#error "slice_classifier.h needs the Edge Impulse C++ library"
+#endif
+
+#include <cstring>
+
+#include "esp_log.h"
+#include "energy_gate.h"
+#include "event_segmenter.h"
+#include "inference_profiler.h"
+#if CONFIG_CLASSIFIER_MULTI_MODEL
+#include "classifier_models.h"
+#endif
+
+/**
+ * Feeds capture slices to the continuous classifier. Shared by inferenceTask
+ * and the host replay harness (host/replay.cpp), so both gate, classify and
+ * segment a slice exactly the same way.
+ *
+ * Like the Edge Impulse library this is header only: include it once, after
+ * Cough_Tutorial_inferencing.h, in the file that runs the classifier.
+ */
+
+/** Slice being classified, read by the signal callback */
+static const int16_t *slice_classifier_slice;
+/** A gated slice was skipped since the last classified one */
+static bool slice_classifier_resumed = false;
+
+#if CONFIG_CLASSIFIER_MULTI_MODEL
+#define SLICE_CLASSIFIER_MODEL_COUNT (sizeof(classifier_models) / sizeof(classifier_models[0]))
+
+/** Scores and timing totals of every model in classifier_models */
+static ei_model_slot_t slice_classifier_models[SLICE_CLASSIFIER_MODEL_COUNT];
+#endif
+
+#if CONFIG_AUDIO_I16_SIGNAL_PATH
+static int slice_classifier_get_data(size_t offset, size_t length, int16_t *out_ptr)
+{
+    memcpy(out_ptr, &slice_classifier_slice[offset], length * sizeof(int16_t));
+
+    return 0;
+}
+#else
+static int slice_classifier_get_data(size_t offset, size_t length, float *out_ptr)
+{
+    numpy::int16_to_float(&slice_classifier_slice[offset], out_ptr, length);
+
+    return 0;
+}
+#endif
+
+/** Fewest slices per model window, sizes the capture slots */
+#define SLICE_CLASSIFIER_MIN_SLICES 2
+/** Most slices per model window, bounded by the moving average filter of the SDK */
+#define SLICE_CLASSIFIER_MAX_SLICES EI_CLASSIFIER_MAX_SLICES_PER_MODEL_WINDOW
+/** Longest slice, at SLICE_CLASSIFIER_MIN_SLICES */
+#define SLICE_CLASSIFIER_MAX_SLICE_SIZE (EI_CLASSIFIER_RAW_SAMPLE_COUNT / SLICE_CLASSIFIER_MIN_SLICES)
+
+/**
+ * @brief      Samples per slice when the model window is cut into `slices`
+ */
+static inline uint32_t slice_classifier_slice_size(uint32_t slices)
+{
+    return EI_CLASSIFIER_RAW_SAMPLE_COUNT / slices;
+}
+
+/**
+ * @brief      Whether the classifier can run with `slices` slices per model window
+ */
+static inline bool slice_classifier_valid_slices(uint32_t slices)
+{
+    return slices >= SLICE_CLASSIFIER_MIN_SLICES && slices <= SLICE_CLASSIFIER_MAX_SLICES;
+}
+
+/**
+ * @brief      Slices per model window the classifier currently runs with
+ */
+static inline uint32_t slice_classifier_slices(void)
+{
+    return (uint32_t)run_classifier_slices_per_model_window();
+}
+
+/**
+ * @brief      Round a duration from menuconfig up to whole slices
+ */
+static inline uint32_t slice_classifier_ms_to_slices(uint32_t ms, uint32_t slices)
+{
+    const uint32_t slice_ms = slice_classifier_slice_size(slices) * 1000 / EI_CLASSIFIER_FREQUENCY;
+    return (ms + slice_ms - 1) / slice_ms;
+}
+
+/**
+ * @brief      Set up the event segmenter with the thresholds from menuconfig,
+ *             for the current slices per model window
+ */
+static inline void slice_classifier_init_segmenter(EVENT_SEGMENTER *segmenter)
+{
+    const uint32_t slices = slice_classifier_slices();
+    event_segmenter_init(segmenter, ei_classifier_inferencing_categories, EI_CLASSIFIER_LABEL_COUNT,
+                         CONFIG_EVENT_ONSET_PCT / 100.0f, CONFIG_EVENT_OFFSET_PCT / 100.0f,
+                         slice_classifier_ms_to_slices(CONFIG_EVENT_REFRACTORY_MS, slices),
+                         slice_classifier_ms_to_slices(CONFIG_EVENT_MAX_MS, slices),
+                         slice_classifier_slice_size(slices), slices);
+}
+
+/**
+ * @brief      Move the event segmenter to the current slices per model window,
+ *             from slice `seq` on. Returns the number of events this closed.
+ */
+static inline size_t slice_classifier_retime_segmenter(EVENT_SEGMENTER *segmenter, uint32_t seq,
+                                                       SEGMENT_EVENT *closed, size_t max_closed)
+{
+    const uint32_t slices = slice_classifier_slices();
+    return event_segmenter_retime(segmenter, seq, slice_classifier_ms_to_slices(CONFIG_EVENT_REFRACTORY_MS, slices),
+                                  slice_classifier_ms_to_slices(CONFIG_EVENT_MAX_MS, slices),
+                                  slice_classifier_slice_size(slices), slices, closed, max_closed);
+}
+
+#ifdef CONFIG_AUDIO_VAD_ENABLE
+/**
+ * @brief      Set up the energy gate with the thresholds from menuconfig
+ */
+static inline void slice_classifier_init_gate(ENERGY_GATE *gate)
+{
+    // 20 ms analysis frames. Keep the gate open for a full model window after activity.
+    energy_gate_init(gate, EI_CLASSIFIER_FREQUENCY / 50, CONFIG_AUDIO_VAD_THRESHOLD_DB,
+                     CONFIG_AUDIO_VAD_MIN_RMS, CONFIG_AUDIO_VAD_MIN_ZCR, slice_classifier_slices());
+}
+#endif
+
+/**
+ * @brief      Forget the slices seen so far, for a new recording. Also resets
+ *             the classifier's feature window and moving average filter.
+ */
+static inline void slice_classifier_reset(void)
+{
+    run_classifier_init();
+    slice_classifier_resumed = false;
+
+#if CONFIG_CLASSIFIER_MULTI_MODEL
+    for (size_t ix = 0; ix < SLICE_CLASSIFIER_MODEL_COUNT; ix++) {
+        slice_classifier_models[ix].model = &classifier_models[ix];
+    }
+    // On failure the first slice retries (and reports the error)
+    run_classifier_multi_init(slice_classifier_models, SLICE_CLASSIFIER_MODEL_COUNT);
+#endif
+}
+
+/**
+ * @brief      Cut the model window into `slices` slices from the next slice on,
+ *             so the classifier runs every model window / `slices`. Resets the
+ *             classifier like slice_classifier_reset, the moving average filter
+ *             takes the new length. The event segmenter and energy gate keep
+ *             their own copy, see slice_classifier_retime_segmenter.
+ *
+ * @return     false if `slices` is out of range, nothing changes then
+ */
+static inline bool slice_classifier_set_slices(uint32_t slices)
+{
+    if (!slice_classifier_valid_slices(slices) || !run_classifier_set_slices_per_model_window(slices)) {
+        return false;
+    }
+
+    slice_classifier_reset();
+    return true;
+}
+
+/**
+ * @brief      Release the models and the DSP buffers the classifier keeps
+ *             between slices
+ */
+static inline void slice_classifier_deinit(void)
+{
+#if CONFIG_CLASSIFIER_MULTI_MODEL
+    run_classifier_multi_deinit(slice_classifier_models, SLICE_CLASSIFIER_MODEL_COUNT);
+#endif
+    run_classifier_deinit();
+}
+
+/**
+ * @brief      Account for a slice the energy gate skipped
+ */
+static inline void slice_classifier_skip(void)
+{
+    slice_classifier_resumed = true;
+}
+
+/**
+ * @brief      Classify the model window that ends with this slice
+ *
+ * @param[in]  slice   slice_classifier_slice_size(slice_classifier_slices()) samples,
+ *                     only read during the call
+ * @param[out] result  Scores, smoothed over the model window
+ * @param[in]  debug   Print the features
+ */
+static inline EI_IMPULSE_ERROR slice_classifier_run(const int16_t *slice, ei_impulse_result_t *result, bool debug)
+{
+    if (slice_classifier_resumed) {
+        // The partial frame carried over from before the gap is not contiguous with this
+        // slice, drop it. The older frames in the feature window come from the hangover
+        // slices that closed the gate, i.e. the same quiet audio the skipped slices held.
+        ei_dsp_clear_continuous_audio_state();
+        slice_classifier_resumed = false;
+    }
+
+    slice_classifier_slice = slice;
+    ei_reset_stage_times();
+
+#if CONFIG_AUDIO_I16_SIGNAL_PATH
+    signal_i16_t signal;
+#else
+    signal_t signal;
+#endif
+    signal.total_length = slice_classifier_slice_size(slice_classifier_slices());
+    signal.get_data = &slice_classifier_get_data;
+
+#if CONFIG_CLASSIFIER_MULTI_MODEL
+    uint32_t dsp_us = 0;
+#if CONFIG_AUDIO_I16_SIGNAL_PATH
+    EI_IMPULSE_ERROR res = run_classifier_continuous_multi_i16(&signal, slice_classifier_models,
+                                                               SLICE_CLASSIFIER_MODEL_COUNT, &dsp_us, debug);
+#else
+    EI_IMPULSE_ERROR res = run_classifier_continuous_multi(&signal, slice_classifier_models,
+                                                           SLICE_CLASSIFIER_MODEL_COUNT, &dsp_us, debug);
+#endif
+    result->timing.dsp = dsp_us / 1000;
+
+    // The first model is the one of the impulse, the event segmenter follows its scores
+    const ei_model_slot_t *first = &slice_classifier_models[0];
+    if (first->ran) {
+        for (size_t ix = 0; ix < EI_CLASSIFIER_LABEL_COUNT; ix++) {
+            result->classification[ix] = first->classification[ix];
+        }
+    }
+    return res;
+#elif CONFIG_AUDIO_I16_SIGNAL_PATH
+    return run_classifier_continuous_i16(&signal, result, debug);
+#else
+    return run_classifier_continuous(&signal, result, debug);
+#endif
+}
+
+/**
+ * @brief      Add the SDK stage times of the last slice to the profiler histograms.
+ *             Stages that did not run (no inference until the window is full) are
+ *             skipped, stages that ran in under a microsecond are recorded as 0.
+ */
+static inline void slice_classifier_record_stages(void)
+{
+    static_assert(PROFILE_STAGE_COUNT == PROFILE_PREEMPHASIS + EI_STAGE_COUNT,
+        "PROFILE_STAGE must follow ei_stage_t after the capture wait");
+
+#if EIDSP_PROFILE_STAGES
+    ei_stage_times_t times;
+    ei_get_stage_times(&times);
+    for (int ix = 0; ix < EI_STAGE_COUNT; ix++) {
+        if (times.ran & (1u << ix)) {
+            inference_profiler_record((PROFILE_STAGE)(PROFILE_PREEMPHASIS + ix), times.us[ix]);
+        }
+    }
+#endif
+}
+
+/**
+ * @brief      Log where the classifier allocations landed since the last
+ *             ei_reset_mem_report
+ */
+static inline void slice_classifier_log_mem_report(const char *tag, const char *when)
+{
+    ei_mem_report_t report;
+    ei_get_mem_report(&report);
+
+    ESP_LOGI(tag, "Classifier memory (%s): %u internal (%u bytes), %u PSRAM (%u bytes), %u fallback, %u failed, largest %u bytes",
+        when, (unsigned)report.internal_allocs, (unsigned)report.internal_bytes, (unsigned)report.external_allocs,
+        (unsigned)report.external_bytes, (unsigned)report.fallback_allocs, (unsigned)report.failed_allocs,
+        (unsigned)report.largest_alloc);
+}
+
+#if CONFIG_CLASSIFIER_MULTI_MODEL
+/**
+ * @brief      Log the scores of the last window and the mean time per window
+ *             of every model
+ */
+static inline void slice_classifier_log_models(const char *tag)
+{
+    for (size_t ix = 0; ix < SLICE_CLASSIFIER_MODEL_COUNT; ix++) {
+        const ei_model_slot_t *slot = &slice_classifier_models[ix];
+        if (slot->runs == 0) {
+            ESP_LOGI(tag, "Model %s: not run", slot->model->name);
+            continue;
+        }
+
+        ESP_LOGI(tag, "Model %s: %u windows, quantize %u us, invoke %u us, output %u us",
+            slot->model->name, (unsigned)slot->runs, (unsigned)(slot->input_us / slot->runs),
+            (unsigned)(slot->invoke_us / slot->runs), (unsigned)(slot->output_us / slot->runs));
+        for (size_t label = 0; label < slot->model->label_count; label++) {
+            ESP_LOGI(tag, "    %s: %.5f", slot->model->labels[label], slot->classification[label].value);
+        }
+    }
+}
+#endif
@@ -0,0 +1,90 @@
+/*
+ * Audio slice queue
+ * BreatheRight v1.0
+ * slice_queue.h
+ * 
+ * Copyright (C) 2020 Upbeat Labs LLC or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * Lock-free single-producer/single-consumer queue of fixed-size audio slices.
+ *
+ * Slots are used in place: the producer fills the slot returned by
+ * slice_queue_write_slot() and publishes it with slice_queue_push(), the
+ * consumer works on slice_queue_read_slot() and hands it back with
+ * slice_queue_pop(). No locks, no copies. Blocking and wakeup are left to the
+ * caller so the queue has no RTOS dependency.
+ */
+/** Per-slice metadata filled in by the capture side. */
+typedef struct SLICE_INFO {
+    uint32_t seq;           // slice sequence number since capture start, skips dropped slices
+    uint32_t captured_us;   // esp_timer time the slice was complete, low 32 bits
+    uint8_t window_slices;  // slices per model window the slice was cut for
+    bool active;            // energy gate decision, false when the slice can be skipped
+} SLICE_INFO;
+
+typedef struct SLICE_QUEUE {
+    int16_t* slots;
+    SLICE_INFO* info;
+    uint32_t depth;
+    uint32_t slice_samples;  // slot size, the longest slice the queue can hold
+    uint32_t head;          // next slot to fill, in [0, 2 * depth), written by the producer only
+    uint32_t tail;          // next slot to read, in [0, 2 * depth), written by the consumer only
+    uint32_t max_count;     // high-water mark, written by the producer only
+} SLICE_QUEUE;
+
+bool slice_queue_init(SLICE_QUEUE* q, uint32_t depth, uint32_t slice_samples);
+void slice_queue_deinit(SLICE_QUEUE* q);
+
+/** Next free slot, or NULL when the queue is full. Producer only. */
+int16_t* slice_queue_write_slot(SLICE_QUEUE* q);
+
+/** Metadata of the slot returned by slice_queue_write_slot(). Producer only. */
+SLICE_INFO* slice_queue_write_info(SLICE_QUEUE* q);
+
+/** Publish the slot returned by slice_queue_write_slot(). Producer only. */
+void slice_queue_push(SLICE_QUEUE* q);
+
+/** Oldest filled slot, or NULL when the queue is empty. Consumer only. */
+const int16_t* slice_queue_read_slot(SLICE_QUEUE* q);
+
+/** Metadata of the slot returned by slice_queue_read_slot(). Consumer only. */
+const SLICE_INFO* slice_queue_read_info(SLICE_QUEUE* q);
+
+/** Release the slot returned by slice_queue_read_slot(). Consumer only. */
+void slice_queue_pop(SLICE_QUEUE* q);
+
+/** Slices currently queued. Safe from either side. */
+uint32_t slice_queue_count(const SLICE_QUEUE* q);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,76 @@
+/*
+ * Task plan: core, priority and stack of every firmware task
+ * BreatheRight v1.0
+ * task_plan.h
+ * 
+ * Copyright (C) 2020 Upbeat Labs LLC or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** Every task the firmware starts, in the order of the table in task_plan.c. */
+typedef enum TASK_ID {
+    TASK_AWS_IOT = 0,
+    TASK_BLINK,
+    TASK_AUDIO_CAPTURE,
+    TASK_MICROPHONE,
+    TASK_INFERENCE,
+    TASK_DSP_WORKER,
+    TASK_PM,
+    TASK_PMS7003,
+    TASK_GUI,
+    TASK_SOUND,
+    TASK_CLOCK,
+    TASK_BATTERY,
+    TASK_STATS,
+    TASK_RECORDER,
+    TASK_COUNT
+} TASK_ID;
+
+/**
+ * Placement of one task, from the "BreatheRight Task Configuration" menu.
+ * core is 0, 1 or tskNO_AFFINITY.
+ */
+typedef struct TASK_PLAN {
+    const char* name;
+    uint32_t stack;
+    UBaseType_t priority;
+    BaseType_t core;
+} TASK_PLAN;
+
+extern const TASK_PLAN task_plan[TASK_COUNT];
+
+/** Create task id with the name, stack, priority and core from the plan. */
+BaseType_t task_plan_create(TASK_ID id, TaskFunction_t fn, void* arg, TaskHandle_t* handle);
+
+/** Log the plan, one line per task. */
+void task_plan_log(void);
+
+#ifdef __cplusplus
+}
+#endif
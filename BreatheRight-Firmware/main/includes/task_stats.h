@@ -0,0 +1,52 @@
+/*
+ * CPU load sampler
+ * BreatheRight v1.0
+ * task_stats.h
+ * 
+ * Copyright (C) 2020 Upbeat Labs LLC or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * Periodic CPU load sampler. Every CONFIG_TASK_STATS_PERIOD_S seconds
+ * statsTask takes a uxTaskGetSystemState snapshot, diffs the run time
+ * counters against the previous one and logs the load of each core (time
+ * not spent in its idle task) and of each task, as a percentage of one
+ * core over the period. aws_iot_task reports the core loads in the "cpu"
+ * field of the device shadow.
+ */
+
+/** Start statsTask. Returns false if run time stats are not enabled. */
+bool task_stats_start(void);
+
+/** Load of core (0 or 1) over the last period, in percent. Negative before the first period. */
+float task_stats_core_load(int core);
+
+#ifdef __cplusplus
+}
+#endif
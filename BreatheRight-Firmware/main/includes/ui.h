@@ -26,7 +26,9 @@
 #pragma once
 
 #define MESSAGE_TAB_NAME "MESSAGES" 
+#define PROFILE_TAB_NAME "PROFILER"
 
 void ui_textarea_add(char *txt, char *param, size_t paramLen);
 void ui_wifi_label_update(bool state);
+void ui_record_button_update(bool state);
 void ui_init();
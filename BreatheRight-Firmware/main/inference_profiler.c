@@ -0,0 +1,196 @@
+/*
+ * Inference latency profiler
+ * BreatheRight v1.0
+ * inference_profiler.c
+ *
+ * Copyright (C) 2020 Upbeat Labs LLC or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_log.h"
+
+#include "inference_profiler.h"
+
+static const char* TAG = INFERENCE_PROFILER_TAG;
+
+static const char* const stage_names[PROFILE_STAGE_COUNT] = {
+    [PROFILE_CAPTURE_WAIT] = "wait",
+    [PROFILE_PREEMPHASIS]  = "pre",
+    [PROFILE_FRAMING]      = "frame",
+    [PROFILE_FFT]          = "fft",
+    [PROFILE_FILTERBANK]   = "fbank",
+    [PROFILE_DCT]          = "dct",
+    [PROFILE_CMVN]         = "cmvn",
+    [PROFILE_INVOKE]       = "nn",
+    [PROFILE_POSTPROCESS]  = "post",
+};
+
+const char* inference_profiler_stage_name(PROFILE_STAGE stage) {
+    return stage_names[stage];
+}
+
+#if CONFIG_INFERENCE_PROFILER
+
+// 0..7 us get a bucket each, above that every power of two is split in 4
+#define SUB_BUCKET_BITS     2
+#define SUB_BUCKETS         (1 << SUB_BUCKET_BITS)
+#define LINEAR_BUCKETS      (2 * SUB_BUCKETS)
+// Largest power of two with buckets, longer samples land in the last one (4.2 s)
+#define MAX_EXPONENT        21
+#define BUCKET_COUNT        (LINEAR_BUCKETS + (MAX_EXPONENT - SUB_BUCKET_BITS) * SUB_BUCKETS)
+#define MAX_BUCKETED_US     ((1u << (MAX_EXPONENT + 1)) - 1)
+
+typedef struct PROFILE_HISTOGRAM {
+    uint32_t count;
+    uint32_t max;
+    uint32_t buckets[BUCKET_COUNT];
+} PROFILE_HISTOGRAM;
+
+static PROFILE_HISTOGRAM histograms[PROFILE_STAGE_COUNT];
+
+static uint32_t bucket_index(uint32_t us) {
+    if (us < LINEAR_BUCKETS) {
+        return us;
+    }
+    if (us > MAX_BUCKETED_US) {
+        us = MAX_BUCKETED_US;
+    }
+    uint32_t exponent = 31 - __builtin_clz(us);
+    uint32_t sub = (us >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+    return LINEAR_BUCKETS + (exponent - SUB_BUCKET_BITS - 1) * SUB_BUCKETS + sub;
+}
+
+/** Largest value that falls into a bucket. */
+static uint32_t bucket_upper(uint32_t index) {
+    if (index < LINEAR_BUCKETS) {
+        return index;
+    }
+    uint32_t exponent = (index - LINEAR_BUCKETS) / SUB_BUCKETS + SUB_BUCKET_BITS + 1;
+    uint32_t sub = (index - LINEAR_BUCKETS) % SUB_BUCKETS;
+    uint32_t width = 1u << (exponent - SUB_BUCKET_BITS);
+    return (SUB_BUCKETS + sub) * width + width - 1;
+}
+
+/** Upper bound of the bucket holding the permille-th sample, capped at the max. */
+static uint32_t percentile(const PROFILE_HISTOGRAM* h, uint32_t count, uint32_t permille) {
+    uint32_t target = (uint32_t)(((uint64_t)count * permille + 999) / 1000);
+    if (target == 0) {
+        target = 1;
+    }
+
+    uint32_t seen = 0;
+    for (uint32_t i = 0; i < BUCKET_COUNT; i++) {
+        seen += h->buckets[i];
+        if (seen >= target) {
+            uint32_t upper = bucket_upper(i);
+            return upper < h->max ? upper : h->max;
+        }
+    }
+    return h->max;
+}
+
+void inference_profiler_record(PROFILE_STAGE stage, uint32_t us) {
+    PROFILE_HISTOGRAM* h = &histograms[stage];
+    h->buckets[bucket_index(us)]++;
+    if (us > h->max) {
+        h->max = us;
+    }
+    h->count++;
+}
+
+void inference_profiler_get(PROFILE_STAGE stage, PROFILE_PERCENTILES* out) {
+    const PROFILE_HISTOGRAM* h = &histograms[stage];
+    memset(out, 0, sizeof(*out));
+
+    // count is bumped last, so the buckets hold at least this many samples
+    uint32_t count = h->count;
+    if (count == 0) {
+        return;
+    }
+
+    out->count = count;
+    out->p50 = percentile(h, count, 500);
+    out->p95 = percentile(h, count, 950);
+    out->p99 = percentile(h, count, 990);
+    out->max = h->max;
+}
+
+size_t inference_profiler_format(char* buf, size_t size) {
+    size_t length = 0;
+    if (size == 0) {
+        return 0;
+    }
+    buf[0] = '\0';
+
+    for (int stage = 0; stage < PROFILE_STAGE_COUNT; stage++) {
+        PROFILE_PERCENTILES p;
+        inference_profiler_get(stage, &p);
+        if (p.count == 0) {
+            continue;
+        }
+
+        int n = snprintf(buf + length, size - length, "%s%s:%u/%u/%u", length > 0 ? "," : "",
+            stage_names[stage], p.p50, p.p95, p.p99);
+        if (n < 0 || (size_t)n >= size - length) {
+            // cut at a whole stage rather than in the middle of a number
+            buf[length] = '\0';
+            break;
+        }
+        length += n;
+    }
+    return length;
+}
+
+void inference_profiler_log() {
+    ESP_LOGI(TAG, "Stage latency since boot (us):");
+    for (int stage = 0; stage < PROFILE_STAGE_COUNT; stage++) {
+        PROFILE_PERCENTILES p;
+        inference_profiler_get(stage, &p);
+        if (p.count == 0) {
+            continue;
+        }
+        ESP_LOGI(TAG, "    %-6s %8u samples  p50 %7u  p95 %7u  p99 %7u  max %7u",
+            stage_names[stage], p.count, p.p50, p.p95, p.p99, p.max);
+    }
+}
+
+#else
+
+void inference_profiler_record(PROFILE_STAGE stage, uint32_t us) {
+}
+
+void inference_profiler_get(PROFILE_STAGE stage, PROFILE_PERCENTILES* out) {
+    memset(out, 0, sizeof(*out));
+}
+
+size_t inference_profiler_format(char* buf, size_t size) {
+    if (size > 0) {
+        buf[0] = '\0';
+    }
+    return 0;
+}
+
+void inference_profiler_log() {
+    ESP_LOGI(TAG, "Inference profiler is disabled (INFERENCE_PROFILER)");
+}
+
+#endif // CONFIG_INFERENCE_PROFILER
@@ -61,10 +61,16 @@
 #include "ui.h"
 #include "pms7003.h"
 #include "edge_impulse.h"
+#include "audio_recorder.h"
+#include "inference_profiler.h"
+#include "task_plan.h"
+#include "task_stats.h"
 
 /* The time between each MQTT message publish in milliseconds */
 #define PUBLISH_INTERVAL_MS 3000
-#define MAX_LENGTH_OF_UPDATE_JSON_BUFFER 200
+/* Worst case shadow update is 947 chars: every reported field at its longest, %f floats budgeted at
+   16 chars, the health/latency/events/cpu strings full and a 10 digit client token sequence */
+#define MAX_LENGTH_OF_UPDATE_JSON_BUFFER 1024
 
 
 /* The time prefix used by the logger. */
@@ -83,6 +89,27 @@ uint16_t pm2_5 = 0;
 uint16_t pm10 = 0;
 uint16_t coughs = 0;
 uint16_t sneezes = 0;
+bool recording = false;
+/* Slices per classifier window, sets the hop between inferences */
+uint8_t slices = 0;
+/* Stage latency percentiles, "stage:p50/p95/p99,..." in microseconds */
+char latency[256] = "";
+/* Longest health string: 60 chars of keys and separators plus 9 counters of up to 10 digits, and the NUL */
+#define HEALTH_LEN 151
+/* Audio pipeline health counters since boot, see EI_HEALTH */
+char health[HEALTH_LEN] = "";
+/* CPU load of each core over the last statsTask period, "0:<pct>,1:<pct>", empty until measured */
+char cpu[16] = "";
+/* Events drained from eiData on every publish */
+static SEGMENT_EVENT events[EVENT_RING_SIZE];
+/* Most events reported per publish, the newest are kept */
+#define SHADOW_EVENTS_MAX 8
+/* Longest record, ",c:268435.45/60000/100": start wraps at 2^32 samples, duration at most EVENT_MAX_MS */
+#define EVENT_RECORD_LEN 22
+/* Events of the last interval, "<c|s>:<start s>/<duration ms>/<peak %>,...", start since capture start */
+char eventRecords[SHADOW_EVENTS_MAX * EVENT_RECORD_LEN] = "";
+/* Events of the last interval not in eventRecords: beyond SHADOW_EVENTS_MAX or overwritten in the ring */
+uint32_t eventsDropped = 0;
 
 extern PMS7003_DATA pmsData;
 extern SemaphoreHandle_t xPmsSemaphore;
@@ -103,6 +130,29 @@ char HostAddress[255] = AWS_IOT_MQTT_HOST;
 /* Default MQTT port is pulled from the aws_iot_config.h */
 uint32_t port = AWS_IOT_MQTT_PORT;
 
+/* Write the newest SHADOW_EVENTS_MAX events as records into eventRecords, returns how many */
+static size_t format_event_records(const SEGMENT_EVENT *ev, size_t count) {
+    size_t first = count > SHADOW_EVENTS_MAX ? count - SHADOW_EVENTS_MAX : 0;
+    size_t len = 0;
+
+    eventRecords[0] = '\0';
+    for (size_t i = first; i < count; i++) {
+        uint32_t start = ev[i].start_sample;
+        int n = snprintf(eventRecords + len, sizeof(eventRecords) - len, "%s%c:%u.%02u/%u/%u", len ? "," : "",
+                         ev[i].kind == EVENT_COUGH ? 'c' : 's', start / CONFIG_AUDIO_SAMPLE_RATE,
+                         (start % CONFIG_AUDIO_SAMPLE_RATE) * 100 / CONFIG_AUDIO_SAMPLE_RATE,
+                         (uint32_t)((uint64_t)ev[i].duration * 1000 / CONFIG_AUDIO_SAMPLE_RATE),
+                         (ev[i].peak * 100 + 127) / 255);
+        if (n < 0 || (size_t)n >= sizeof(eventRecords) - len) {
+            // Sized for the longest record, only a bad event gets here
+            eventRecords[len] = '\0';
+            return i - first;
+        }
+        len += n;
+    }
+    return count - first;
+}
+
 void iot_subscribe_callback_handler(AWS_IoT_Client *pClient, char *topicName, uint16_t topicNameLen,
                                     IoT_Publish_Message_Params *params, void *pData) {
     ESP_LOGI(TAG, "Subscribe callback");
@@ -166,7 +216,35 @@ void healthQualityIndex_Callback(const char *pJsonString, uint32_t JsonStringDat
     hqiStatus = status;
 }
 
+void recording_Callback(const char *pJsonString, uint32_t JsonStringDataLen, jsonStruct_t *pContext) {
+    IOT_UNUSED(pJsonString);
+    IOT_UNUSED(JsonStringDataLen);
+
+    if(pContext != NULL) {
+        bool enable = *(bool *) (pContext->pData);
+        ESP_LOGI(TAG, "Delta - recording state changed to %d", enable);
+
+        audio_recorder_enable(enable);
+        ui_record_button_update(enable);
+    }
+}
+
+
 
+void slices_Callback(const char *pJsonString, uint32_t JsonStringDataLen, jsonStruct_t *pContext) {
+    IOT_UNUSED(pJsonString);
+    IOT_UNUSED(JsonStringDataLen);
+
+    if(pContext != NULL) {
+        uint8_t requested = *(uint8_t *) (pContext->pData);
+        if(edge_impulse_set_slices(requested)) {
+            ESP_LOGI(TAG, "Delta - slices state changed to %d", requested);
+        } else {
+            // The next report puts the slices in use back into the shadow
+            ESP_LOGW(TAG, "Delta - %d slices out of range, keeping %u", requested, edge_impulse_slices());
+        }
+    }
+}
 
 void aws_iot_task(void *param) {
     IoT_Error_t rc = FAILURE;
@@ -237,6 +315,55 @@ void aws_iot_task(void *param) {
     hqiStatusActuator.type = SHADOW_JSON_UINT16;
     hqiStatusActuator.dataLength = sizeof(uint16_t);
 
+    jsonStruct_t recordingActuator;
+    recordingActuator.cb = recording_Callback;
+    recordingActuator.pKey = "recording";
+    recordingActuator.pData = &recording;
+    recordingActuator.type = SHADOW_JSON_BOOL;
+    recordingActuator.dataLength = sizeof(bool);
+
+    jsonStruct_t slicesActuator;
+    slicesActuator.cb = slices_Callback;
+    slicesActuator.pKey = "slices";
+    slicesActuator.pData = &slices;
+    slicesActuator.type = SHADOW_JSON_UINT8;
+    slicesActuator.dataLength = sizeof(uint8_t);
+
+    jsonStruct_t healthHandler;
+    healthHandler.cb = NULL;
+    healthHandler.pKey = "health";
+    healthHandler.pData = health;
+    healthHandler.type = SHADOW_JSON_STRING;
+    healthHandler.dataLength = sizeof(health);
+
+    jsonStruct_t eventsHandler;
+    eventsHandler.cb = NULL;
+    eventsHandler.pKey = "events";
+    eventsHandler.pData = eventRecords;
+    eventsHandler.type = SHADOW_JSON_STRING;
+    eventsHandler.dataLength = sizeof(eventRecords);
+
+    jsonStruct_t eventsDroppedHandler;
+    eventsDroppedHandler.cb = NULL;
+    eventsDroppedHandler.pKey = "eventsDropped";
+    eventsDroppedHandler.pData = &eventsDropped;
+    eventsDroppedHandler.type = SHADOW_JSON_UINT32;
+    eventsDroppedHandler.dataLength = sizeof(uint32_t);
+
+    jsonStruct_t cpuHandler;
+    cpuHandler.cb = NULL;
+    cpuHandler.pKey = "cpu";
+    cpuHandler.pData = cpu;
+    cpuHandler.type = SHADOW_JSON_STRING;
+    cpuHandler.dataLength = sizeof(cpu);
+
+    jsonStruct_t latencyHandler;
+    latencyHandler.cb = NULL;
+    latencyHandler.pKey = "latency";
+    latencyHandler.pData = latency;
+    latencyHandler.type = SHADOW_JSON_STRING;
+    latencyHandler.dataLength = sizeof(latency);
+
     ESP_LOGI(TAG, "AWS IoT SDK Version %d.%d.%d-%s", VERSION_MAJOR, VERSION_MINOR, VERSION_PATCH, VERSION_TAG);    
 
     // initialize the mqtt client    
@@ -308,6 +435,18 @@ void aws_iot_task(void *param) {
         ESP_LOGE(TAG, "Shadow Register Delta Error");
     }
 
+    // register delta callback for recording
+    rc = aws_iot_shadow_register_delta(&iotCoreClient, &recordingActuator);
+    if(SUCCESS != rc) {
+        ESP_LOGE(TAG, "Shadow Register Delta Error");
+    }
+
+    // register delta callback for slices
+    rc = aws_iot_shadow_register_delta(&iotCoreClient, &slicesActuator);
+    if(SUCCESS != rc) {
+        ESP_LOGE(TAG, "Shadow Register Delta Error");
+    }
+
     // loop and publish changes
     while(NETWORK_ATTEMPTING_RECONNECT == rc || NETWORK_RECONNECTED == rc || SUCCESS == rc) {
         rc = aws_iot_shadow_yield(&iotCoreClient, 200);
@@ -341,7 +480,33 @@ void aws_iot_task(void *param) {
         // Reset the coughs/sneezes for the next interval
         eiData.coughs = 0;
         eiData.sneezes = 0;
+        size_t event_count = event_ring_drain(&eiData.events, events, EVENT_RING_SIZE);
+        uint32_t events_dropped = eiData.events.dropped;
+        eiData.events.dropped = 0;
         xSemaphoreGive(xEISemaphore);
+
+        eventsDropped = events_dropped + (event_count - format_event_records(events, event_count));
+
+        recording = audio_recorder_enabled();
+        slices = edge_impulse_slices();
+        AUDIO_RECORDER_STATS recorderStats;
+        audio_recorder_get_stats(&recorderStats);
+
+        inference_profiler_format(latency, sizeof(latency));
+
+        EI_HEALTH eiHealth;
+        edge_impulse_get_health(&eiHealth);
+        snprintf(health, sizeof(health), "short:%u,dmaovf:%u,dmaerr:%u,dropped:%u,dropsmp:%u,waits:%u,late:%u/%u,maxq:%u",
+                 eiHealth.short_reads, eiHealth.dma_overflows, eiHealth.dma_errors, eiHealth.dropped_slices,
+                 eiHealth.dropped_samples, eiHealth.queue_waits, eiHealth.deadline_misses, eiHealth.slices, eiHealth.max_queue_depth);
+
+        float load0 = task_stats_core_load(0);
+        float load1 = task_stats_core_load(1);
+        if (load0 >= 0.0f && load1 >= 0.0f) {
+            snprintf(cpu, sizeof(cpu), "0:%d,1:%d", (int)(load0 + 0.5f), (int)(load1 + 0.5f));
+        } else {
+            cpu[0] = '\0';
+        }
     
 
         // END get sensor readings
@@ -355,14 +520,34 @@ void aws_iot_task(void *param) {
         ESP_LOGI(TAG, "On Device: pm10 %d", pm10);
         ESP_LOGI(TAG, "On Device: coughs %d", coughs);
         ESP_LOGI(TAG, "On Device: sneezes %d", sneezes);    
+        for (size_t i = 0; i < event_count; i++) {
+            ESP_LOGI(TAG, "On Device: %s at %.2f s, %u ms, peak %.2f",
+                     events[i].kind == EVENT_COUGH ? "cough" : "sneeze",
+                     events[i].start_sample / (float)CONFIG_AUDIO_SAMPLE_RATE,
+                     events[i].duration * 1000 / CONFIG_AUDIO_SAMPLE_RATE, events[i].peak / 255.0f);
+        }
+        if (events_dropped > 0) {
+            ESP_LOGW(TAG, "On Device: %u events dropped, the event ring is full", events_dropped);
+        }
         ESP_LOGI(TAG, "On Device: hqiStatus %d", hqiStatus);
+        ESP_LOGI(TAG, "On Device: recording %d, %u KiB in %u segments at %u KiB/s, %u blocks dropped, %u write errors",
+                 recording, (uint32_t)(recorderStats.bytes_written / 1024), recorderStats.segments,
+                 audio_recorder_throughput_kbs(&recorderStats), recorderStats.blocks_dropped, recorderStats.write_errors);
+        ESP_LOGI(TAG, "On Device: slices %d", slices);
+        ESP_LOGI(TAG, "On Device: latency %s", latency);
+        ESP_LOGI(TAG, "On Device: health %s", health);
+        ESP_LOGI(TAG, "On Device: cpu %s", cpu);
+        ESP_LOGI(TAG, "On Device: events %s, %u dropped", eventRecords, eventsDropped);
        
 
         rc = aws_iot_shadow_init_json_document(JsonDocumentBuffer, sizeOfJsonDocumentBuffer);
         if(SUCCESS == rc) {
-            rc = aws_iot_shadow_add_reported(JsonDocumentBuffer, sizeOfJsonDocumentBuffer, 9, &temperatureHandler,
+            rc = aws_iot_shadow_add_reported(JsonDocumentBuffer, sizeOfJsonDocumentBuffer, 16, &temperatureHandler,
                                              &humidityHandler, &pressureHandler, &pm1_0Handler, &pm2_5Handler, 
-                                             &pm10Handler, &coughsHandler, &sneezesHandler, &hqiStatusActuator);
+                                             &pm10Handler, &coughsHandler, &sneezesHandler, &hqiStatusActuator,
+                                             &recordingActuator, &slicesActuator, &latencyHandler,
+                                             &healthHandler, &cpuHandler, &eventsHandler,
+                                             &eventsDroppedHandler);
             if(SUCCESS == rc) {
                 rc = aws_iot_finalize_json_document(JsonDocumentBuffer, sizeOfJsonDocumentBuffer);
                 if(SUCCESS == rc) {
@@ -402,8 +587,10 @@ void app_main()
     
     blink_init();
     ui_init();
+    audio_recorder_init();
     initialise_wifi();
 
-    xTaskCreatePinnedToCore(&aws_iot_task, "aws_iot_task", 4096 * 2, NULL, 5, NULL, 1);
-    xTaskCreatePinnedToCore(&blink_task, "blink_task", 4096 * 1, NULL, 2, &xBlink, 1);
+    task_plan_create(TASK_AWS_IOT, &aws_iot_task, NULL, NULL);
+    task_plan_create(TASK_BLINK, &blink_task, NULL, &xBlink);
+    task_stats_start();
 }
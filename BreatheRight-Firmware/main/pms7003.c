@@ -38,6 +38,7 @@
 
 #include "pms7003.h"
 #include "blink.h"
+#include "task_plan.h"
 #include <time.h>
 
 static const char* TAG = PM_TAB_NAME;
@@ -309,8 +310,8 @@ void display_pm_tab(lv_obj_t* tv){
     xSemaphoreGive(xBmeSemaphore);
 
 
-    xTaskCreatePinnedToCore(pm_task, "pmTask", configMINIMAL_STACK_SIZE * 3, NULL, 1, &pm_handle, 1);
-    xTaskCreatePinnedToCore(readpms7003_task, "pms7003Task", configMINIMAL_STACK_SIZE * 3, NULL, 1, &pms7003_handle, 1);
+    task_plan_create(TASK_PM, pm_task, NULL, &pm_handle);
+    task_plan_create(TASK_PMS7003, readpms7003_task, NULL, &pms7003_handle);
 
 }
 
@@ -35,6 +35,7 @@
 #include "core2forAWS.h"
 
 #include "power.h"
+#include "task_plan.h"
 
 static void led_event_handler(lv_obj_t* obj, lv_event_t event);
 static void vibration_event_handler(lv_obj_t* obj, lv_event_t event);
@@ -46,7 +47,7 @@ lv_obj_t* power_tab;
 TaskHandle_t power_handle;
 
 void display_power_info(lv_obj_t* core2forAWS_screen_obj){
-    xTaskCreatePinnedToCore(battery_task, "batteryTask", configMINIMAL_STACK_SIZE * 2, (void*) core2forAWS_screen_obj, 0, &power_handle, 1);
+    task_plan_create(TASK_BATTERY, battery_task, (void*) core2forAWS_screen_obj, &power_handle);
 }
 
 static void brightness_event_handler(lv_obj_t* obj, lv_event_t event){
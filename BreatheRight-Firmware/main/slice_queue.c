@@ -0,0 +1,113 @@
+/*
+ * Audio slice queue
+ * BreatheRight v1.0
+ * slice_queue.c
+ * 
+ * Copyright (C) 2020 Upbeat Labs LLC or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+
+#include "slice_queue.h"
+
+// head and tail run over [0, 2 * depth): equal means empty, depth apart means full.
+// Unlike free-running counters taken modulo depth, nothing jumps when a uint32_t
+// wraps, whatever the depth.
+static inline uint32_t next_index(const SLICE_QUEUE* q, uint32_t ix) {
+    return ix + 1 == 2 * q->depth ? 0 : ix + 1;
+}
+
+static inline uint32_t index_distance(const SLICE_QUEUE* q, uint32_t head, uint32_t tail) {
+    return head >= tail ? head - tail : head + 2 * q->depth - tail;
+}
+
+static inline uint32_t slot_of(const SLICE_QUEUE* q, uint32_t ix) {
+    return ix < q->depth ? ix : ix - q->depth;
+}
+
+bool slice_queue_init(SLICE_QUEUE* q, uint32_t depth, uint32_t slice_samples) {
+    q->slots = (int16_t*)malloc(depth * slice_samples * sizeof(int16_t));
+    q->info = (SLICE_INFO*)calloc(depth, sizeof(SLICE_INFO));
+    if (q->slots == NULL || q->info == NULL) {
+        free(q->slots);
+        free(q->info);
+        return false;
+    }
+    q->depth = depth;
+    q->slice_samples = slice_samples;
+    q->head = 0;
+    q->tail = 0;
+    q->max_count = 0;
+    return true;
+}
+
+void slice_queue_deinit(SLICE_QUEUE* q) {
+    free(q->slots);
+    free(q->info);
+    q->slots = NULL;
+    q->info = NULL;
+}
+
+int16_t* slice_queue_write_slot(SLICE_QUEUE* q) {
+    uint32_t head = q->head;
+    uint32_t tail = __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE);
+
+    if (index_distance(q, head, tail) >= q->depth) {
+        return NULL;
+    }
+    return &q->slots[slot_of(q, head) * q->slice_samples];
+}
+
+SLICE_INFO* slice_queue_write_info(SLICE_QUEUE* q) {
+    return &q->info[slot_of(q, q->head)];
+}
+
+void slice_queue_push(SLICE_QUEUE* q) {
+    uint32_t head = next_index(q, q->head);
+    uint32_t count = index_distance(q, head, __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE));
+
+    // Release orders the slot contents before the new head becomes visible.
+    __atomic_store_n(&q->head, head, __ATOMIC_RELEASE);
+    if (count > q->max_count) {
+        q->max_count = count;
+    }
+}
+
+const int16_t* slice_queue_read_slot(SLICE_QUEUE* q) {
+    uint32_t tail = q->tail;
+    uint32_t head = __atomic_load_n(&q->head, __ATOMIC_ACQUIRE);
+
+    if (head == tail) {
+        return NULL;
+    }
+    return &q->slots[slot_of(q, tail) * q->slice_samples];
+}
+
+const SLICE_INFO* slice_queue_read_info(SLICE_QUEUE* q) {
+    return &q->info[slot_of(q, q->tail)];
+}
+
+void slice_queue_pop(SLICE_QUEUE* q) {
+    __atomic_store_n(&q->tail, next_index(q, q->tail), __ATOMIC_RELEASE);
+}
+
+uint32_t slice_queue_count(const SLICE_QUEUE* q) {
+    return index_distance(q, __atomic_load_n(&q->head, __ATOMIC_ACQUIRE), __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE));
+}
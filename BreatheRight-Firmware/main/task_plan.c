@@ -0,0 +1,71 @@
+/*
+ * Task plan: core, priority and stack of every firmware task
+ * BreatheRight v1.0
+ * task_plan.c
+ * 
+ * Copyright (C) 2020 Upbeat Labs LLC or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "esp_log.h"
+
+#include "task_plan.h"
+
+static const char* TAG = "TASKS";
+
+#define TASK_CORE(core) ((core) < 0 ? tskNO_AFFINITY : (BaseType_t)(core))
+#define TASK_ENTRY(sym, name) \
+    { name, CONFIG_TASK_##sym##_STACK, CONFIG_TASK_##sym##_PRIORITY, TASK_CORE(CONFIG_TASK_##sym##_CORE) }
+
+const TASK_PLAN task_plan[TASK_COUNT] = {
+    [TASK_AWS_IOT]       = TASK_ENTRY(AWS_IOT, "aws_iot_task"),
+    [TASK_BLINK]         = TASK_ENTRY(BLINK, "blink_task"),
+    [TASK_AUDIO_CAPTURE] = TASK_ENTRY(AUDIO_CAPTURE, "audioCaptureTask"),
+    [TASK_MICROPHONE]    = TASK_ENTRY(MICROPHONE, "microphoneTask"),
+    [TASK_INFERENCE]     = TASK_ENTRY(INFERENCE, "inferenceTask"),
+    [TASK_DSP_WORKER]    = TASK_ENTRY(DSP_WORKER, "dspWorkerTask"),
+    [TASK_PM]            = TASK_ENTRY(PM, "pmTask"),
+    [TASK_PMS7003]       = TASK_ENTRY(PMS7003, "pms7003Task"),
+    [TASK_GUI]           = TASK_ENTRY(GUI, "gui"),
+    [TASK_SOUND]         = TASK_ENTRY(SOUND, "soundTask"),
+    [TASK_CLOCK]         = TASK_ENTRY(CLOCK, "clockTask"),
+    [TASK_BATTERY]       = TASK_ENTRY(BATTERY, "batteryTask"),
+    [TASK_STATS]         = TASK_ENTRY(STATS, "statsTask"),
+    [TASK_RECORDER]      = TASK_ENTRY(RECORDER, "recorderTask"),
+};
+
+BaseType_t task_plan_create(TASK_ID id, TaskFunction_t fn, void* arg, TaskHandle_t* handle) {
+    const TASK_PLAN* p = &task_plan[id];
+    BaseType_t res = xTaskCreatePinnedToCore(fn, p->name, p->stack, arg, p->priority, handle, p->core);
+    if (res != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create %s (%u byte stack)", p->name, p->stack);
+    }
+    return res;
+}
+
+void task_plan_log(void) {
+    for (int i = 0; i < TASK_COUNT; i++) {
+        const TASK_PLAN* p = &task_plan[i];
+        if (p->core == tskNO_AFFINITY) {
+            ESP_LOGI(TAG, "%-16s any core, priority %u, %u byte stack", p->name, p->priority, p->stack);
+        } else {
+            ESP_LOGI(TAG, "%-16s core %d, priority %u, %u byte stack", p->name, p->core, p->priority, p->stack);
+        }
+    }
+}
@@ -0,0 +1,158 @@
+/*
+ * CPU load sampler
+ * BreatheRight v1.0
+ * task_stats.c
+ * 
+ * Copyright (C) 2020 Upbeat Labs LLC or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+
+#include "task_plan.h"
+#include "task_stats.h"
+
+static const char* TAG = "STATS";
+
+#if CONFIG_TASK_STATS_ENABLE
+
+#define MAX_TASKS 32
+
+typedef struct TASK_SAMPLE {
+    TaskHandle_t handle;
+    uint32_t run_time;
+} TASK_SAMPLE;
+
+static TaskStatus_t status[MAX_TASKS];
+static TASK_SAMPLE previous[MAX_TASKS];
+static UBaseType_t previous_count;
+static uint32_t previous_total;
+static float core_load[portNUM_PROCESSORS];
+
+static uint32_t previous_run_time(TaskHandle_t handle, bool* found) {
+    for (UBaseType_t i = 0; i < previous_count; i++) {
+        if (previous[i].handle == handle) {
+            *found = true;
+            return previous[i].run_time;
+        }
+    }
+    *found = false;
+    return 0;
+}
+
+static void sample(bool report) {
+    uint32_t total;
+    UBaseType_t count = uxTaskGetSystemState(status, MAX_TASKS, &total);
+    if (count == 0) {
+        ESP_LOGW(TAG, "More than %d tasks, skipping sample", MAX_TASKS);
+        return;
+    }
+
+    // Counters are 32 bits and wrap, unsigned differences stay correct for one wrap per period.
+    uint32_t elapsed = total - previous_total;
+
+    if (report && elapsed > 0) {
+        for (int core = 0; core < portNUM_PROCESSORS; core++) {
+            TaskHandle_t idle = xTaskGetIdleTaskHandleForCPU(core);
+            for (UBaseType_t i = 0; i < count; i++) {
+                bool found;
+                uint32_t prev = previous_run_time(status[i].xHandle, &found);
+                if (status[i].xHandle == idle && found) {
+                    uint32_t idle_time = status[i].ulRunTimeCounter - prev;
+                    core_load[core] = idle_time >= elapsed ? 0.0f : 100.0f * (elapsed - idle_time) / elapsed;
+                }
+            }
+        }
+        ESP_LOGI(TAG, "CPU load over %u s: core 0 %.1f%%, core 1 %.1f%%", CONFIG_TASK_STATS_PERIOD_S,
+            core_load[0], portNUM_PROCESSORS > 1 ? core_load[1] : 0.0f);
+
+        for (UBaseType_t i = 0; i < count; i++) {
+            bool found;
+            uint32_t prev = previous_run_time(status[i].xHandle, &found);
+            if (!found) {
+                // Started during the period, its whole run time belongs to it.
+                prev = 0;
+            }
+            uint32_t delta = status[i].ulRunTimeCounter - prev;
+#if configTASKLIST_INCLUDE_COREID
+            BaseType_t core = status[i].xCoreID;
+#else
+            BaseType_t core = tskNO_AFFINITY;
+#endif
+            char core_str[4];
+            if (core == tskNO_AFFINITY) {
+                strcpy(core_str, "any");
+            } else {
+                core_str[0] = '0' + core;
+                core_str[1] = '\0';
+            }
+            ESP_LOGI(TAG, "  %-16s core %-3s prio %2u %5.1f%%  stack free %u", status[i].pcTaskName, core_str,
+                status[i].uxCurrentPriority, 100.0f * delta / elapsed, status[i].usStackHighWaterMark);
+        }
+    }
+
+    for (UBaseType_t i = 0; i < count; i++) {
+        previous[i].handle = status[i].xHandle;
+        previous[i].run_time = status[i].ulRunTimeCounter;
+    }
+    previous_count = count;
+    previous_total = total;
+}
+
+static void stats_task(void* pvParameters) {
+    sample(false);
+    for (;;) {
+        vTaskDelay(pdMS_TO_TICKS(CONFIG_TASK_STATS_PERIOD_S * 1000));
+        sample(true);
+    }
+    vTaskDelete(NULL); // Should never get to here...
+}
+
+bool task_stats_start(void) {
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        core_load[core] = -1.0f;
+    }
+    task_plan_log();
+    return task_plan_create(TASK_STATS, stats_task, NULL, NULL) == pdPASS;
+}
+
+float task_stats_core_load(int core) {
+    if (core < 0 || core >= portNUM_PROCESSORS) {
+        return -1.0f;
+    }
+    return core_load[core];
+}
+
+#else
+
+bool task_stats_start(void) {
+    task_plan_log();
+    ESP_LOGI(TAG, "CPU load sampling is disabled (TASK_STATS_ENABLE)");
+    return false;
+}
+
+float task_stats_core_load(int core) {
+    return -1.0f;
+}
+
+#endif // CONFIG_TASK_STATS_ENABLE
@@ -40,22 +40,44 @@
 #include "pms7003.h"
 // #include "mic.h"
 #include "edge_impulse.h"
+#include "audio_recorder.h"
+#include "inference_profiler.h"
+#include "task_plan.h"
 
 LV_IMG_DECLARE(upbeatlabs_logo);
 
 #define MAX_TEXTAREA_LENGTH 1024
 
+#define RECORD_BTN_HEIGHT 32
+#if CONFIG_AUDIO_RECORDER
+// The REC button sits where the PM and profile tabs start, under the clock and
+// battery row (y 36), with the log below it: 240 - 12 - (36 + 32 + 8)
+#define MESSAGE_TEXTAREA_HEIGHT 152
+#else
+#define MESSAGE_TEXTAREA_HEIGHT 180
+#endif
+
 static lv_obj_t *active_screen;
 static lv_obj_t *out_txtarea;
 static lv_obj_t *wifi_label;
+static lv_obj_t *record_btn;
+static lv_obj_t *profile_table;
+static uint16_t profile_tab_id;
 
 static const char *TAG = MESSAGE_TAB_NAME;
 
 static void tab_event_cb(lv_obj_t* slider, lv_event_t event);
+#if CONFIG_AUDIO_RECORDER
+static void record_event_handler(lv_obj_t* obj, lv_event_t event);
+#endif
+#if CONFIG_INFERENCE_PROFILER
+static void profile_table_update(lv_task_t* task);
+#endif
 
 static lv_obj_t* tab_view;
 
 void display_message_tab(lv_obj_t* tv);
+void display_profile_tab(lv_obj_t* tv);
 
 static void ui_textarea_prune(size_t new_text_length){
     const char * current_text = lv_textarea_get_text(out_txtarea);
@@ -103,6 +125,15 @@ void ui_wifi_label_update(bool state){
     xSemaphoreGive(xGuiSemaphore);
 }
 
+void ui_record_button_update(bool state){
+    if (record_btn == NULL) {
+        return;
+    }
+    xSemaphoreTake(xGuiSemaphore, portMAX_DELAY);
+    lv_btn_set_state(record_btn, state ? LV_BTN_STATE_CHECKED_RELEASED : LV_BTN_STATE_RELEASED);
+    xSemaphoreGive(xGuiSemaphore);
+}
+
 void ui_init() {
     /* Displays the Upbeat Labs logo */
     xSemaphoreTake(xGuiSemaphore, portMAX_DELAY);   // Takes (blocks) the xGuiSemaphore mutex from being read/written by another task.
@@ -120,7 +151,7 @@ void ui_init() {
     */
     vTaskDelay(pdMS_TO_TICKS(2000)); // FreeRTOS scheduler block execution for 2 seconds to keep showing the Upbeat Labs logo.
     
-    xTaskCreatePinnedToCore(sound_task, "soundTask", 4096 * 2, NULL, 3, NULL, 1);
+    task_plan_create(TASK_SOUND, sound_task, NULL, NULL);
 
     xSemaphoreTake(xGuiSemaphore, portMAX_DELAY);
     lv_obj_clean(opener_scr);   // Clear the aws_img_obj and remove from memory space. Currently no objects exist on the screen.
@@ -145,6 +176,8 @@ void ui_init() {
 
     display_message_tab(tab_view);
 
+    display_profile_tab(tab_view);
+
     // display_microphone_tab(tab_view);
 
     edge_impulse_start();
@@ -158,16 +191,94 @@ void display_message_tab(lv_obj_t* tv){
 
     lv_obj_t* message_tab = lv_tabview_add_tab(tv, MESSAGE_TAB_NAME);
     out_txtarea = lv_textarea_create(message_tab, NULL);
-    lv_obj_set_size(out_txtarea, 300, 180);
+    lv_obj_set_size(out_txtarea, 300, MESSAGE_TEXTAREA_HEIGHT);
     lv_obj_align(out_txtarea, NULL, LV_ALIGN_IN_BOTTOM_MID, 0, -12);
     lv_textarea_set_max_length(out_txtarea, MAX_TEXTAREA_LENGTH);
     lv_textarea_set_text_sel(out_txtarea, false);
     lv_textarea_set_cursor_hidden(out_txtarea, true);
     lv_textarea_set_text(out_txtarea, "Starting BreatheRight...\n");
+
+#if CONFIG_AUDIO_RECORDER
+    record_btn = lv_btn_create(message_tab, NULL);
+    lv_btn_set_checkable(record_btn, true);
+    lv_obj_set_size(record_btn, 80, RECORD_BTN_HEIGHT);
+    lv_obj_align(record_btn, out_txtarea, LV_ALIGN_OUT_TOP_LEFT, 0, -8);
+    lv_obj_set_event_cb(record_btn, record_event_handler);
+    lv_obj_t* record_label = lv_label_create(record_btn, NULL);
+    lv_label_set_text(record_label, LV_SYMBOL_AUDIO " REC");
+#endif
     xSemaphoreGive(xGuiSemaphore);
 
 }
 
+void display_profile_tab(lv_obj_t* tv){
+#if CONFIG_INFERENCE_PROFILER
+    xSemaphoreTake(xGuiSemaphore, portMAX_DELAY);
+
+    lv_obj_t* profile_tab = lv_tabview_add_tab(tv, PROFILE_TAB_NAME);
+    profile_tab_id = lv_tabview_get_tab_count(tv) - 1;
+
+    profile_table = lv_table_create(profile_tab, NULL);
+    lv_obj_set_style_local_pad_top(profile_table, LV_TABLE_PART_CELL1, LV_STATE_DEFAULT, 2);
+    lv_obj_set_style_local_pad_bottom(profile_table, LV_TABLE_PART_CELL1, LV_STATE_DEFAULT, 2);
+    lv_obj_set_style_local_pad_left(profile_table, LV_TABLE_PART_CELL1, LV_STATE_DEFAULT, 4);
+    lv_obj_set_style_local_pad_right(profile_table, LV_TABLE_PART_CELL1, LV_STATE_DEFAULT, 4);
+    lv_table_set_col_cnt(profile_table, 4);
+    lv_table_set_row_cnt(profile_table, PROFILE_STAGE_COUNT + 1);
+    lv_table_set_col_width(profile_table, 0, 68);
+
+    const char* headers[4] = { "us", "p50", "p95", "p99" };
+    for (uint16_t col = 0; col < 4; col++) {
+        lv_table_set_cell_value(profile_table, 0, col, headers[col]);
+        if (col > 0) {
+            lv_table_set_col_width(profile_table, col, 76);
+            for (uint16_t row = 0; row <= PROFILE_STAGE_COUNT; row++) {
+                lv_table_set_cell_align(profile_table, row, col, LV_LABEL_ALIGN_RIGHT);
+            }
+        }
+    }
+    for (int stage = 0; stage < PROFILE_STAGE_COUNT; stage++) {
+        lv_table_set_cell_value(profile_table, stage + 1, 0, inference_profiler_stage_name(stage));
+    }
+    lv_obj_align(profile_table, NULL, LV_ALIGN_IN_TOP_MID, 0, 36);
+
+    // Runs in the GUI task, which holds xGuiSemaphore while it runs the LVGL tasks
+    lv_task_create(profile_table_update, 2000, LV_TASK_PRIO_LOW, NULL);
+
+    xSemaphoreGive(xGuiSemaphore);
+#endif
+}
+
+#if CONFIG_INFERENCE_PROFILER
+static void profile_table_update(lv_task_t* task){
+    if (lv_tabview_get_tab_act(tab_view) != profile_tab_id) {
+        return;
+    }
+
+    for (int stage = 0; stage < PROFILE_STAGE_COUNT; stage++) {
+        PROFILE_PERCENTILES p;
+        inference_profiler_get(stage, &p);
+        if (p.count == 0) {
+            continue;
+        }
+        lv_table_set_cell_value_fmt(profile_table, stage + 1, 1, "%u", p.p50);
+        lv_table_set_cell_value_fmt(profile_table, stage + 1, 2, "%u", p.p95);
+        lv_table_set_cell_value_fmt(profile_table, stage + 1, 3, "%u", p.p99);
+    }
+}
+#endif // CONFIG_INFERENCE_PROFILER
+
+#if CONFIG_AUDIO_RECORDER
+static void record_event_handler(lv_obj_t* obj, lv_event_t event){
+    if(event == LV_EVENT_VALUE_CHANGED) {
+        bool value = (lv_obj_get_state(obj, LV_BTN_PART_MAIN) & LV_STATE_CHECKED) != 0;
+
+        audio_recorder_enable(value);
+        ESP_LOGI(TAG, "Recording: %x", value);
+    }
+}
+#endif // CONFIG_AUDIO_RECORDER
+
 
 static void tab_event_cb(lv_obj_t* slider, lv_event_t event){
     if(event == LV_EVENT_VALUE_CHANGED) {